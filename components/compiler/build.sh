@@ -20,6 +20,7 @@ source_files=(
     "fs.c"
     "function.c"
     "gc.c"
+    "heap.c"
     "io.c"
     "keyword.c"
     "list.c"
@@ -29,10 +30,12 @@ source_files=(
     "native.c"
     "object.c"
     "process.c"
+    "profiler.c"
     "reader.c"
     "record.c"
     "repl.c"
     "scanner.c"
+    "snapshot.c"
     "string.c"
     "symbol.c"
     "syntax.c"
@@ -40,6 +43,7 @@ source_files=(
     "time.c"
     "value.c"
     "vm.c"
+    "weak.c"
 )
 
 object_files=()
@@ -1,4 +1,5 @@
 #include "array.h"
+#include "gc.h"
 #include "native.h"
 #include "util.h"
 #include "value.h"
@@ -12,11 +13,12 @@ ObjectArray *mesche_object_make_array(VM *vm) {
 
 void mesche_free_array(VM *vm, ObjectArray *array) {
   mesche_value_array_free((MescheMemory *)vm, &array->objects);
-  FREE(vm, ObjectArray, array);
+  FREE_OBJECT(vm, array);
 }
 
 Value mesche_array_push(MescheMemory *mem, ObjectArray *array, Value value) {
   mesche_value_array_write(mem, &array->objects, value);
+  mesche_gc_write_barrier((VM *)mem, (Object *)array);
   return value;
 }
 
@@ -26,10 +28,12 @@ Value array_make_msc(VM *vm, int arg_count, Value *args) {
   if (arg_count == 1) {
     // Initialize the array to the specified size
     // TODO: Type check the argument
-    int length = AS_NUMBER(args[0]);
+    int length = AS_INTEGER(args[0]);
+    mesche_vm_stack_push(vm, OBJECT_VAL(array));
     for (int i = 0; i < length; i++) {
       mesche_array_push((MescheMemory *)vm, array, FALSE_VAL);
     }
+    mesche_vm_stack_pop(vm);
   }
 
   return OBJECT_VAL(array);
@@ -54,7 +58,7 @@ Value array_length_msc(VM *vm, int arg_count, Value *args) {
   }
 
   ObjectArray *array = AS_ARRAY(args[0]);
-  return NUMBER_VAL(array->objects.count);
+  return FIXNUM_VAL(array->objects.count);
 }
 
 Value array_nth_msc(VM *vm, int arg_count, Value *args) {
@@ -63,14 +67,14 @@ Value array_nth_msc(VM *vm, int arg_count, Value *args) {
   }
 
   ObjectArray *array = AS_ARRAY(args[0]);
-  Value value = args[1];
+  int64_t index = AS_INTEGER(args[1]);
 
-  if (AS_NUMBER(args[1]) >= array->objects.count) {
-    PANIC("Array index %d requested when only has %d items.", (int)AS_NUMBER(args[1]),
+  if (index >= array->objects.count) {
+    PANIC("Array index %d requested when only has %d items.", (int)index,
           array->objects.count);
   }
 
-  return array->objects.values[(int)AS_NUMBER(value)];
+  return array->objects.values[index];
 }
 
 Value array_nth_set_msc(VM *vm, int arg_count, Value *args) {
@@ -81,7 +85,8 @@ Value array_nth_set_msc(VM *vm, int arg_count, Value *args) {
   ObjectArray *array = AS_ARRAY(args[0]);
   Value index = args[1];
 
-  array->objects.values[(int)AS_NUMBER(index)] = args[2];
+  array->objects.values[AS_INTEGER(index)] = args[2];
+  mesche_gc_write_barrier(vm, (Object *)array);
   return args[2];
 }
 
@@ -1,4 +1,5 @@
 #include <stdio.h>
+#include <string.h>
 
 #include "chunk.h"
 #include "mem.h"
@@ -11,6 +12,11 @@ void mesche_chunk_init(Chunk *chunk) {
   chunk->code = NULL;
   chunk->lines = NULL;
   chunk->file_name = NULL;
+  chunk->global_caches = NULL;
+  chunk->global_cache_capacity = 0;
+  chunk->call_caches = NULL;
+  chunk->call_cache_count = 0;
+  chunk->call_cache_capacity = 0;
   mesche_value_array_init(&chunk->constants);
 }
 
@@ -60,13 +66,43 @@ int mesche_chunk_constant_add(MescheMemory *mem, Chunk *chunk, Value value) {
   // so that it gets marked correctly in a GC pass
   mesche_vm_stack_push(vm, value);
   mesche_value_array_write(mem, &chunk->constants, value);
+
+  // Keep a global lookup cache entry for every constant slot
+  if (chunk->global_cache_capacity < chunk->constants.capacity) {
+    int old_capacity = chunk->global_cache_capacity;
+    chunk->global_caches = GROW_ARRAY(mem, GlobalCache, chunk->global_caches, old_capacity,
+                                      chunk->constants.capacity);
+    chunk->global_cache_capacity = chunk->constants.capacity;
+    memset(chunk->global_caches + old_capacity, 0,
+           sizeof(GlobalCache) * (chunk->global_cache_capacity - old_capacity));
+  }
+
   mesche_vm_stack_pop(vm);
   return chunk->constants.count - 1;
 }
 
+int mesche_chunk_call_cache_add(MescheMemory *mem, Chunk *chunk) {
+  if (chunk->call_cache_capacity < chunk->call_cache_count + 1) {
+    int old_capacity = chunk->call_cache_capacity;
+    chunk->call_cache_capacity = GROW_CAPACITY(old_capacity);
+    chunk->call_caches = GROW_ARRAY(mem, CallCache, chunk->call_caches, old_capacity,
+                                    chunk->call_cache_capacity);
+  }
+
+  memset(&chunk->call_caches[chunk->call_cache_count], 0, sizeof(CallCache));
+  return chunk->call_cache_count++;
+}
+
 void mesche_chunk_free(MescheMemory *mem, Chunk *chunk) {
+  for (int i = 0; i < chunk->call_cache_count; i++) {
+    FREE_ARRAY(mem, uint8_t, chunk->call_caches[i].keyword_map,
+               chunk->call_caches[i].keyword_map_count);
+  }
+
   FREE_ARRAY(mem, uint8_t, chunk->code, chunk->capacity);
   FREE_ARRAY(mem, uint8_t, chunk->lines, chunk->capacity);
+  FREE_ARRAY(mem, GlobalCache, chunk->global_caches, chunk->global_cache_capacity);
+  FREE_ARRAY(mem, CallCache, chunk->call_caches, chunk->call_cache_capacity);
   mesche_value_array_free(mem, &chunk->constants);
   mesche_chunk_init(chunk);
 }
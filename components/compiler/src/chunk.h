@@ -7,12 +7,51 @@
 #include "string.h"
 #include "value.h"
 
+// Caches the module binding that a global variable access resolved to.  The
+// cache is indexed by the constant index of the variable's name and is only
+// valid while the access happens in `module` and no binding names have been
+// added to any module since `epoch`.
+typedef struct {
+  struct ObjectModule *module;
+  struct ObjectModule *owner;
+  int slot;
+  uint32_t epoch;
+} GlobalCache;
+
+// The number of distinct callees remembered by each call site cache
+#define CALL_CACHE_WAYS 2
+
+// Caches the callees that an OP_CALL or OP_TAIL_CALL site has already
+// validated.  For closures the cached object is the closure's function so that
+// all closures of the same lambda share an entry, for native functions it is
+// the native function object itself.  A hit means the callee's arity matches
+// the site's argument count and no keyword or rest argument processing is
+// needed, so the call can go straight to frame setup.
+//
+// Sites that pass keyword arguments also remember how the keywords they pass
+// map onto the keyword slots of the last function or record type they called:
+// `keyword_map[i]` is the index of the keyword/value pair that supplies slot
+// `i`, or KEYWORD_NOT_PASSED if the slot takes its default value.
+typedef struct {
+  struct Object *callees[CALL_CACHE_WAYS];
+  struct Object *keyword_callee;
+  uint8_t *keyword_map;
+  int keyword_map_count;
+} CallCache;
+
+#define KEYWORD_NOT_PASSED 0xFF
+
 typedef struct {
   int capacity;
   int count;
   uint8_t *code;
   int *lines;
   ValueArray constants;
+  GlobalCache *global_caches;
+  int global_cache_capacity;
+  CallCache *call_caches;
+  int call_cache_count;
+  int call_cache_capacity;
   ObjectString *file_name;
 } Chunk;
 
@@ -20,6 +59,7 @@ void mesche_chunk_init(Chunk *chunk);
 void mesche_chunk_write(MescheMemory *mem, Chunk *chunk, uint8_t byte, int line);
 void mesche_chunk_insert_space(MescheMemory *mem, Chunk *chunk, int start_offset, int space_size);
 int mesche_chunk_constant_add(MescheMemory *mem, Chunk *chunk, Value value);
+int mesche_chunk_call_cache_add(MescheMemory *mem, Chunk *chunk);
 void mesche_chunk_free(MescheMemory *mem, Chunk *chunk);
 
 #endif
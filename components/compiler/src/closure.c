@@ -1,28 +1,23 @@
 #include "closure.h"
 #include "mem.h"
 
-#define ALLOC(vm, type, count)                                                                     \
-  (type) mesche_mem_realloc((MescheMemory *)vm, NULL, 0, sizeof(type) * count)
-
 ObjectClosure *mesche_object_make_closure(VM *vm, ObjectFunction *function, ObjectModule *module) {
-  // Allocate upvalues for this closure instance
-  ObjectUpvalue **upvalues = ALLOC(vm, ObjectUpvalue **, function->upvalue_count);
-  for (int i = 0; i < function->upvalue_count; i++) {
-    upvalues[i] = NULL;
-  }
-
-  ObjectClosure *closure = ALLOC_OBJECT(vm, ObjectClosure, ObjectKindClosure);
+  // The upvalue slots are stored inline after the closure's fields
+  int upvalue_count = function->upvalue_count;
+  ObjectClosure *closure = ALLOC_OBJECT_EX(vm, ObjectClosure, sizeof(ObjectUpvalue *) * upvalue_count,
+                                           ObjectKindClosure);
   closure->function = function;
   closure->module = module;
-  closure->upvalues = upvalues;
-  closure->upvalue_count = function->upvalue_count;
+  closure->upvalue_count = upvalue_count;
+  for (int i = 0; i < upvalue_count; i++) {
+    closure->upvalues[i] = NULL;
+  }
 
   return closure;
 };
 
 void mesche_free_closure(VM *vm, ObjectClosure *closure) {
-  FREE_ARRAY(vm, ObjectUpvalue *, closure->upvalues, closure->upvalue_count);
-  FREE(vm, ObjectClosure, closure);
+  FREE_OBJECT(vm, closure);
 }
 
 ObjectUpvalue *mesche_object_make_upvalue(VM *vm, Value *slot) {
@@ -34,4 +29,4 @@ ObjectUpvalue *mesche_object_make_upvalue(VM *vm, Value *slot) {
   return upvalue;
 }
 
-void mesche_free_upvalue(VM *vm, ObjectUpvalue *upvalue) { FREE(vm, ObjectUpvalue, upvalue); }
+void mesche_free_upvalue(VM *vm, ObjectUpvalue *upvalue) { FREE_OBJECT(vm, upvalue); }
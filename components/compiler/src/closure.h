@@ -20,8 +20,8 @@ typedef struct ObjectClosure {
   Object object;
   ObjectModule *module;
   ObjectFunction *function;
-  ObjectUpvalue **upvalues;
   int upvalue_count;
+  ObjectUpvalue *upvalues[];
 } ObjectClosure;
 
 ObjectUpvalue *mesche_object_make_upvalue(VM *vm, Value *slot);
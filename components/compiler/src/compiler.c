@@ -140,7 +140,8 @@ typedef struct CompilerContext {
   Upvalue upvalues[UINT8_COUNT];
 
   int tail_site_count;
-  uint8_t tail_sites[UINT8_COUNT];
+  int tail_sites[UINT8_COUNT];
+  int last_apply_offset;
 } CompilerContext;
 
 typedef struct {
@@ -159,7 +160,10 @@ void mesche_compiler_mark_roots(void *target) {
   CompilerContext *ctx = (CompilerContext *)target;
 
   while (ctx != NULL) {
+    // Functions are written to throughout compilation, so make sure they are
+    // traced even if they've already been promoted to the old generation
     mesche_gc_mark_object(ctx->vm, (Object *)ctx->function);
+    mesche_gc_write_barrier(ctx->vm, (Object *)ctx->function);
 
     if (ctx->module != NULL) {
       mesche_gc_mark_object(ctx->vm, (Object *)ctx->module);
@@ -185,6 +189,7 @@ static void compiler_init_context(CompilerContext *ctx, CompilerContext *parent,
   ctx->local_count = 0;
   ctx->scope_depth = 0;
   ctx->tail_site_count = 0;
+  ctx->last_apply_offset = -1;
 
   // Set up memory management
   ctx->vm->current_compiler = ctx;
@@ -216,23 +221,37 @@ static void compiler_emit_bytes(CompilerContext *ctx, Value syntax, uint8_t byte
 
 static void compiler_emit_call(CompilerContext *ctx, Value syntax, uint8_t arg_count,
                                uint8_t keyword_count) {
+  // Every call site gets its own inline cache for the callees it sees
+  int cache = mesche_chunk_call_cache_add(ctx->mem, &ctx->function->chunk);
+  if (cache > UINT16_MAX) {
+    PANIC("Too many call sites in one chunk!\n");
+  }
+
   compiler_emit_byte(ctx, syntax, OP_CALL);
   compiler_emit_byte(ctx, syntax, arg_count);
   compiler_emit_byte(ctx, syntax, keyword_count);
+  compiler_emit_byte(ctx, syntax, (cache >> 8) & 0xff);
+  compiler_emit_byte(ctx, syntax, cache & 0xff);
 }
 
 static void compiler_log_tail_site(CompilerContext *ctx) {
   // Log the call site to potentially patch tail calls later.  The call has
-  // already been written so look back 3 bytes (the size of an OP_CALL) to
-  // check whether there actually was a call.
-  int func_offset = ctx->function->chunk.count - 3;
-  if (ctx->function->chunk.count >= 3 && ctx->function->chunk.code[func_offset] == OP_CALL) {
-    // It's possible that a block parser could try to add a tail site that was
-    // just added by another sub-expression, skip such an occurrence.
-    if (ctx->tail_site_count == 0 || ctx->tail_sites[ctx->tail_site_count - 1] != func_offset) {
-      ctx->tail_sites[ctx->tail_site_count] = func_offset;
-      ctx->tail_site_count++;
-    }
+  // already been written so look back 5 bytes (the size of an OP_CALL) to
+  // check whether there actually was a call, or 1 byte for an OP_APPLY.
+  Chunk *chunk = &ctx->function->chunk;
+  int func_offset = chunk->count - 5;
+  if (ctx->last_apply_offset >= 0 && ctx->last_apply_offset == chunk->count - 1 &&
+      chunk->code[ctx->last_apply_offset] == OP_APPLY) {
+    func_offset = ctx->last_apply_offset;
+  } else if (chunk->count < 5 || chunk->code[func_offset] != OP_CALL) {
+    return;
+  }
+
+  // It's possible that a block parser could try to add a tail site that was
+  // just added by another sub-expression, skip such an occurrence.
+  if (ctx->tail_site_count == 0 || ctx->tail_sites[ctx->tail_site_count - 1] != func_offset) {
+    ctx->tail_sites[ctx->tail_site_count] = func_offset;
+    ctx->tail_site_count++;
   }
 }
 
@@ -252,7 +271,8 @@ static void compiler_patch_tail_calls(CompilerContext *ctx) {
 
   for (int i = 0; i < ctx->tail_site_count; i++) {
     // Convert the call site to a tail call
-    ctx->function->chunk.code[ctx->tail_sites[i]] = OP_TAIL_CALL;
+    uint8_t *instr = &ctx->function->chunk.code[ctx->tail_sites[i]];
+    *instr = *instr == OP_APPLY ? OP_TAIL_APPLY : OP_TAIL_CALL;
   }
 }
 
@@ -260,6 +280,97 @@ static void compiler_emit_return(CompilerContext *ctx) {
   compiler_emit_byte(ctx, UNSPECIFIED_VAL, OP_RETURN);
 }
 
+static int compiler_instr_size(Chunk *chunk, int offset) {
+  switch (chunk->code[offset]) {
+  case OP_CONSTANT:
+  case OP_LIST:
+  case OP_POP_SCOPE:
+  case OP_DEFINE_RECORD:
+  case OP_EXPORT_SYMBOL:
+  case OP_DEFINE_GLOBAL:
+  case OP_SET_GLOBAL:
+  case OP_SET_UPVALUE:
+  case OP_SET_LOCAL:
+  case OP_READ_GLOBAL:
+  case OP_READ_UPVALUE:
+  case OP_READ_LOCAL:
+    return 2;
+  case OP_JUMP:
+  case OP_JUMP_IF_FALSE:
+    return 3;
+  case OP_CALL:
+  case OP_TAIL_CALL:
+    return 5;
+  case OP_CLOSURE: {
+    ObjectFunction *function = AS_FUNCTION(chunk->constants.values[chunk->code[offset + 1]]);
+    return 2 + function->upvalue_count * 2;
+  }
+  default:
+    return 1;
+  }
+}
+
+static uint8_t compiler_compare_jump_op(uint8_t instr) {
+  switch (instr) {
+  case OP_LESS_THAN:
+    return OP_LESS_THAN_JUMP_IF_FALSE;
+  case OP_LESS_EQUAL:
+    return OP_LESS_EQUAL_JUMP_IF_FALSE;
+  case OP_GREATER_THAN:
+    return OP_GREATER_THAN_JUMP_IF_FALSE;
+  case OP_GREATER_EQUAL:
+    return OP_GREATER_EQUAL_JUMP_IF_FALSE;
+  default:
+    return OP_NOP;
+  }
+}
+
+static void compiler_fuse_instructions(CompilerContext *ctx) {
+  // Replace the first opcode of common instruction sequences with a
+  // superinstruction that executes the whole sequence.  Only the opcode byte is
+  // rewritten, the rest of the sequence stays as it was so that a jump which
+  // targets one of the later instructions still executes correctly.  This must
+  // run after all jumps and tail calls in the function have been patched.
+  Chunk *chunk = &ctx->function->chunk;
+  uint8_t *code = chunk->code;
+  int offset = 0;
+  while (offset < chunk->count) {
+    uint8_t instr = code[offset];
+    int next = offset + compiler_instr_size(chunk, offset);
+    if (next >= chunk->count) {
+      break;
+    }
+
+    if (instr == OP_READ_LOCAL && code[next] == OP_CONSTANT && next + 2 < chunk->count &&
+        (code[next + 2] == OP_ADD || code[next + 2] == OP_SUBTRACT)) {
+      // OP_READ_LOCAL, OP_CONSTANT, OP_ADD/OP_SUBTRACT
+      code[offset] =
+          code[next + 2] == OP_ADD ? OP_LOCAL_CONSTANT_ADD : OP_LOCAL_CONSTANT_SUBTRACT;
+      offset = next + 3;
+    } else if (instr == OP_READ_LOCAL && code[next] == OP_READ_LOCAL) {
+      code[offset] = OP_READ_LOCAL_LOCAL;
+      offset = next + 2;
+    } else if (instr == OP_READ_LOCAL && code[next] == OP_CONSTANT) {
+      code[offset] = OP_READ_LOCAL_CONSTANT;
+      offset = next + 2;
+    } else if (compiler_compare_jump_op(instr) != OP_NOP && code[next] == OP_JUMP_IF_FALSE &&
+               next + 3 < chunk->count && code[next + 3] == OP_POP) {
+      // A comparison that only decides a branch never needs its boolean result
+      // when both sides of the branch start by popping it
+      uint16_t jump = (uint16_t)((code[next + 1] << 8) | code[next + 2]);
+      int target = next + 3 + jump;
+      if (target < chunk->count && code[target] == OP_POP) {
+        code[offset] = compiler_compare_jump_op(instr);
+        offset = next + 4;
+      } else {
+        offset = next;
+      }
+    } else {
+      offset = next;
+    }
+  }
+}
+
 static Value compiler_end(CompilerContext *ctx) {
   ObjectFunction *function = ctx->function;
 
@@ -269,6 +380,7 @@ static Value compiler_end(CompilerContext *ctx) {
   }
 
   compiler_emit_return(ctx);
+  compiler_fuse_instructions(ctx);
 
 #ifdef DEBUG_PRINT_CODE
   mesche_disasm_function(ctx->vm->output_port, function);
@@ -343,6 +455,8 @@ static Value compiler_parse_block(CompilerContext *ctx, Value syntax, const char
       compiler_emit_byte(ctx, syntax, OP_POP);
     }
   }
+
+  return TRUE_VAL;
 }
 
 static Value compiler_add_local(CompilerContext *ctx, Value syntax, ObjectSymbol *symbol) {
@@ -496,6 +610,8 @@ static Value compiler_emit_identifier(CompilerContext *ctx, Value syntax) {
     uint8_t variable_constant = compiler_resolve_symbol(ctx, syntax, symbol, true);
     compiler_emit_bytes(ctx, syntax, OP_READ_GLOBAL, variable_constant);
   }
+
+  return TRUE_VAL;
 }
 
 static Value compiler_define_variable_ex(CompilerContext *ctx, Value syntax,
@@ -515,6 +631,7 @@ static Value compiler_define_variable_ex(CompilerContext *ctx, Value syntax,
       if (ctx->module != NULL) {
         mesche_value_array_write((MescheMemory *)ctx->vm, &ctx->module->exports,
                                  ctx->function->chunk.constants.values[variable_constant]);
+        mesche_gc_write_barrier(ctx->vm, (Object *)ctx->module);
       }
 
       // TODO: Convert to OP_CREATE_BINDING?
@@ -599,6 +716,7 @@ static Value compiler_parse_let(CompilerContext *ctx, Value syntax) {
   if (let_name) {
     // Use the symbol name as the let function's name
     let_ctx.function->name = let_name->name;
+    mesche_gc_write_barrier(ctx->vm, (Object *)let_ctx.function);
     MOVE_NEXT(ctx, syntax);
   } else {
     EXPECT_CONS(ctx, syntax, "let: Expected symbol or binding list");
@@ -704,6 +822,8 @@ static Value compiler_parse_let(CompilerContext *ctx, Value syntax) {
   ctx->function->chunk.count = call_offset;
   compiler_emit_call(ctx, let_expr, let_ctx.function->arity, 0);
   compiler_log_tail_site(ctx);
+
+  return TRUE_VAL;
 }
 
 static Value compiler_parse_define_attributes(CompilerContext *ctx, Value syntax,
@@ -743,6 +863,63 @@ static bool compiler_compare_keyword(Token keyword, const char *expected_name) {
   return memcmp(keyword.start + 1, expected_name, strlen(expected_name)) == 0;
 }
 
+// Parses a parameter that follows :keys, either a symbol or a list of a symbol
+// and the literal value to use when the keyword isn't passed.  The parameter's
+// local slot comes after the positional and rest parameters and is bound by
+// matching its interned keyword against the keywords passed to the call.
+static Value compiler_parse_keyword_param(CompilerContext *ctx, Value param_syntax,
+                                         const char *form_name) {
+  const char *message = prefix_message(form_name, "Expected symbol or (symbol default) after :keys");
+
+  ObjectSymbol *param;
+  Value name_syntax = param_syntax;
+  Value default_syntax = FALSE_VAL;
+  MAYBE_SYMBOL(param_syntax, param);
+  if (param == NULL) {
+    EXPECT_CONS(ctx, param_syntax, message);
+    name_syntax = HEAD(param_syntax);
+    EXPECT_SYMBOL(ctx, name_syntax, param, message);
+
+    Value rest = param_syntax;
+    MOVE_NEXT(ctx, rest);
+    EXPECT_CONS(ctx, rest, message);
+    default_syntax = HEAD(rest);
+    MOVE_NEXT(ctx, rest);
+    EXPECT_EMPTY(ctx, rest, message);
+  }
+
+  if (ctx->function->keyword_args.count == 255) {
+    return compiler_error(ctx, param_syntax,
+                          prefix_message(form_name, "Function has more than 255 keyword parameters"));
+  }
+
+  // Keyword parameters are plain locals as far as the function body is concerned
+  uint8_t constant = compiler_resolve_symbol(ctx, name_syntax, param, false);
+  compiler_define_variable(ctx, name_syntax, constant);
+
+  KeywordArgument keyword_arg;
+  keyword_arg.default_index = 0;
+  if (IS_SYNTAX(default_syntax)) {
+    Value default_value = mesche_syntax_to_datum(ctx->vm, default_syntax);
+    if (IS_CONS(default_value)) {
+      return compiler_error(
+          ctx, default_syntax,
+          prefix_message(form_name, "Keyword parameter default must be a literal value"));
+    }
+
+    keyword_arg.default_index = compiler_make_constant(ctx, default_value) + 1;
+  }
+
+  // Keep the keyword reachable while it gets added to the function
+  keyword_arg.keyword =
+      mesche_object_make_keyword(ctx->vm, param->name->chars, param->name->length);
+  mesche_vm_stack_push(ctx->vm, OBJECT_VAL(keyword_arg.keyword));
+  mesche_object_function_keyword_add(ctx->mem, ctx->function, keyword_arg);
+  mesche_vm_stack_pop(ctx->vm);
+
+  return TRUE_VAL;
+}
+
 static Value compiler_parse_lambda_inner(CompilerContext *ctx, Value formals, Value syntax,
                                          ObjectString *name, const char *form_name) {
   // Create a new compiler context for parsing the function body
@@ -763,9 +940,36 @@ static Value compiler_parse_lambda_inner(CompilerContext *ctx, Value formals, Va
     func_ctx.function->rest_arg_index = 1;
     func_ctx.function->arity++;
   } else if (!MAYBE_EMPTY(formals)) {
+    ArgType arg_type = ARG_POSITIONAL;
     while (!IS_EMPTY(formals)) {
       Value this_param;
       bool is_rest_param = false;
+
+      // Look for the :rest and :keys markers that change how the following
+      // parameters are bound
+      ObjectKeyword *marker;
+      MAYBE_KEYWORD(HEAD(formals), marker);
+      if (marker) {
+        if (strcmp(marker->string.chars, "rest") == 0 && arg_type == ARG_POSITIONAL) {
+          arg_type = ARG_REST;
+        } else if (strcmp(marker->string.chars, "keys") == 0 && arg_type != ARG_KEYWORD) {
+          arg_type = ARG_KEYWORD;
+        } else {
+          return compiler_error(
+              ctx, HEAD(formals),
+              prefix_message(form_name, "Unexpected keyword in parameter list"));
+        }
+
+        MOVE_NEXT(ctx, formals);
+        continue;
+      }
+
+      if (arg_type == ARG_KEYWORD) {
+        OK(compiler_parse_keyword_param(&func_ctx, HEAD(formals), form_name));
+        MOVE_NEXT(ctx, formals);
+        continue;
+      }
+
       MAYBE_SYMBOL(formals, param);
       if (param) {
         // Now that we've found the rest parameter, exit after processing it
@@ -777,6 +981,17 @@ static Value compiler_parse_lambda_inner(CompilerContext *ctx, Value formals, Va
         EXPECT_CONS(ctx, formals, message);
         EXPECT_SYMBOL(ctx, HEAD(formals), param, message);
         this_param = HEAD(formals);
+
+        // Only one parameter follows :rest
+        if (arg_type == ARG_REST) {
+          if (func_ctx.function->rest_arg_index > 0) {
+            return compiler_error(
+                ctx, this_param,
+                prefix_message(form_name, "Expected a single parameter after :rest"));
+          }
+
+          is_rest_param = true;
+        }
       }
 
       uint8_t constant = compiler_resolve_symbol(&func_ctx, this_param, param, false);
@@ -791,8 +1006,10 @@ static Value compiler_parse_lambda_inner(CompilerContext *ctx, Value formals, Va
       // Store knowledge of the "rest" parameter
       if (is_rest_param) {
         func_ctx.function->rest_arg_index = func_ctx.function->arity;
-      } else {
-        // Move to the next parameter
+      }
+
+      // Move to the next parameter
+      if (!IS_EMPTY(formals)) {
         MOVE_NEXT(ctx, formals);
       }
     }
@@ -803,6 +1020,7 @@ static Value compiler_parse_lambda_inner(CompilerContext *ctx, Value formals, Va
 
   // Get the parsed function and store it in a constant
   func_ctx.function->name = name;
+  mesche_gc_write_barrier(ctx->vm, (Object *)func_ctx.function);
   // TODO: Check for error!
   ObjectFunction *function = AS_FUNCTION(compiler_end(&func_ctx));
   compiler_emit_bytes(ctx, syntax, OP_CLOSURE, compiler_make_constant(ctx, OBJECT_VAL(function)));
@@ -851,6 +1069,7 @@ static Value compiler_parse_apply(CompilerContext *ctx, Value syntax) {
   EXPECT_CONS(ctx, syntax, "apply: Expected argument expression");
   OK(compiler_parse_expr(ctx, HEAD(syntax)));
 
+  ctx->last_apply_offset = ctx->function->chunk.count;
   compiler_emit_byte(ctx, syntax, OP_APPLY);
 
   MOVE_NEXT(ctx, syntax);
@@ -1345,6 +1564,33 @@ static Value compiler_parse_load_file(CompilerContext *ctx, Value syntax) {
 
   MOVE_NEXT(ctx, syntax);
   EXPECT_EMPTY(ctx, syntax, "load-file: Expected end of expression");
+
+  return TRUE_VAL;
+}
+
+// Counts the keyword/value pairs at the end of a call's argument list, which
+// are passed to the callee separately from its positional arguments.  A pair is
+// a literal keyword followed by any expression.
+static uint8_t compiler_count_keyword_pairs(Value args) {
+  Value items[UINT8_MAX];
+  int item_count = 0;
+  while (!IS_EMPTY(args) && item_count < UINT8_MAX) {
+    items[item_count++] = HEAD(args);
+    MOVE_NEXT(NULL, args);
+  }
+
+  uint8_t keyword_count = 0;
+  for (int i = item_count - 2; i >= 0; i -= 2) {
+    ObjectKeyword *keyword;
+    MAYBE_KEYWORD(items[i], keyword);
+    if (keyword == NULL) {
+      break;
+    }
+
+    keyword_count++;
+  }
+
+  return keyword_count;
 }
 
 static Value compiler_parse_list(CompilerContext *ctx, Value syntax) {
@@ -1419,6 +1665,9 @@ static Value compiler_parse_list(CompilerContext *ctx, Value syntax) {
     OK(compiler_parse_expr(ctx, callee));
   }
 
+  // Find any keyword arguments before the argument list gets consumed
+  uint8_t keyword_count = is_operator ? 0 : compiler_count_keyword_pairs(syntax);
+
   // Parse argument expressions until we reach the end of the list
   uint8_t arg_count = 0;
   while (!IS_EMPTY(syntax)) {
@@ -1441,8 +1690,10 @@ static Value compiler_parse_list(CompilerContext *ctx, Value syntax) {
 
   // One last chance to decide that this should be an OP_CALL
   if (!is_operator) {
-    compiler_emit_call(ctx, call_expr, arg_count, 0);
+    compiler_emit_call(ctx, call_expr, arg_count - keyword_count * 2, keyword_count);
   }
+
+  return TRUE_VAL;
 }
 
 static Value compiler_parse_expr(CompilerContext *ctx, Value syntax) {
@@ -1491,9 +1742,11 @@ static Value compiler_parse_expr(CompilerContext *ctx, Value syntax) {
     if (IS_OBJECT(value)) {
       PANIC("Unexpected expression object: %d\n", AS_OBJECT(value)->kind);
     } else {
-      PANIC("Unexpected expression value: %d\n", value.kind);
+      PANIC("Unexpected expression value: %d\n", VALUE_KIND(value));
     }
   }
+
+  return TRUE_VAL;
 }
 
 Value compile_expr(CompilerContext *ctx, Value expr) {
@@ -1588,6 +1841,7 @@ Value mesche_compile_module(VM *vm, ObjectModule *module, Reader *reader) {
 
   // Assign the function as the module's top-level body
   ctx.module->init_function = function;
+  mesche_gc_write_barrier(vm, (Object *)ctx.module);
 
   // Clear the VM's pointer to this compiler
   vm->current_compiler = NULL;
@@ -1,9 +1,10 @@
 #include "continuation.h"
+#include "gc.h"
 #include "mem.h"
 
 ObjectContinuation *mesche_object_make_continuation(VM *vm, CallFrame *frame_start,
-                                                    uint8_t frame_count, Value *stack_start,
-                                                    uint8_t stack_count) {
+                                                    int frame_count, Value *stack_start,
+                                                    int stack_count) {
   ObjectContinuation *continuation = ALLOC_OBJECT(vm, ObjectContinuation, ObjectKindContinuation);
 
   // Pre-initialize frames and values to 0 so that the arrays don't get walked
@@ -24,6 +25,17 @@ ObjectContinuation *mesche_object_make_continuation(VM *vm, CallFrame *frame_sta
   continuation->stack_count = stack_count;
   memcpy(continuation->stack, stack_start, sizeof(Value) * stack_count);
 
+  // Point the captured frames' slots into the copied values since the VM's
+  // value stack can move when it grows
+  for (int i = 0; i < frame_count; i++) {
+    continuation->frames[i].slots =
+        continuation->stack + (continuation->frames[i].slots - stack_start);
+  }
+
+  // The continuation may have survived a collection while its arrays were
+  // allocated
+  mesche_gc_write_barrier(vm, (Object *)continuation);
+
   // Pop the continuation
   mesche_vm_stack_pop(vm);
 
@@ -33,5 +45,5 @@ ObjectContinuation *mesche_object_make_continuation(VM *vm, CallFrame *frame_sta
 void mesche_free_continuation(VM *vm, ObjectContinuation *continuation) {
   FREE_ARRAY(vm, CallFrame *, continuation->frames, continuation->frame_count);
   FREE_ARRAY(vm, Value *, continuation->stack, continuation->stack_count);
-  FREE(vm, ObjectContinuation, continuation);
+  FREE_OBJECT(vm, continuation);
 }
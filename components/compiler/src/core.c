@@ -3,8 +3,10 @@
 
 #include "array.h"
 #include "closure.h"
+#include "gc.h"
 #include "io.h"
 #include "keyword.h"
+#include "math.h"
 #include "native.h"
 #include "object.h"
 #include "symbol.h"
@@ -20,6 +22,46 @@ Value core_number_p_msc(VM *vm, int arg_count, Value *args) {
   return BOOL_VAL(IS_NUMBER(args[0]));
 }
 
+Value core_exact_p_msc(VM *vm, int arg_count, Value *args) {
+  if (arg_count != 1) {
+    PANIC("Function requires a single parameter.");
+  }
+
+  return BOOL_VAL(IS_FIXNUM(args[0]));
+}
+
+Value core_inexact_p_msc(VM *vm, int arg_count, Value *args) {
+  if (arg_count != 1) {
+    PANIC("Function requires a single parameter.");
+  }
+
+  return BOOL_VAL(IS_FLONUM(args[0]));
+}
+
+Value core_exact_msc(VM *vm, int arg_count, Value *args) {
+  if (arg_count != 1) {
+    PANIC("Function requires a single parameter.");
+  }
+
+  // Inexact numbers are truncated, or stay inexact if they don't fit
+  if (IS_FLONUM(args[0])) {
+    double number = AS_NUMBER(args[0]);
+    if (number >= FIXNUM_MIN && number <= FIXNUM_MAX) {
+      return FIXNUM_VAL((int64_t)number);
+    }
+  }
+
+  return args[0];
+}
+
+Value core_inexact_msc(VM *vm, int arg_count, Value *args) {
+  if (arg_count != 1) {
+    PANIC("Function requires a single parameter.");
+  }
+
+  return IS_FIXNUM(args[0]) ? NUMBER_VAL(AS_NUMBER(args[0])) : args[0];
+}
+
 Value core_boolean_p_msc(VM *vm, int arg_count, Value *args) {
   if (arg_count != 1) {
     PANIC("Function requires a single parameter.");
@@ -81,7 +123,7 @@ Value core_equal_p_msc(VM *vm, int arg_count, Value *args) {
     PANIC("Function requires 2 parameters.");
   }
 
-  return BOOL_VAL(mesche_value_eqv_p(args[0], args[1]));
+  return BOOL_VAL(mesche_value_equal_p(args[0], args[1]));
 }
 
 Value core_eqv_p_msc(VM *vm, int arg_count, Value *args) {
@@ -107,30 +149,7 @@ Value core_cons_msc(VM *vm, int arg_count, Value *args) {
 }
 
 Value core_list_msc(VM *vm, int arg_count, Value *args) {
-  Value list = EMPTY_VAL;
-
-  if (arg_count > 0) {
-    ObjectCons *current = NULL;
-    bool pushed_list = false;
-    for (int i = 0; i < arg_count; i++) {
-      if (current == NULL) {
-        current = mesche_object_make_cons(vm, args[i], EMPTY_VAL);
-        list = OBJECT_VAL(current);
-
-        // Temporarily store the list so it doesn't get collected
-        mesche_vm_stack_push(vm, list);
-      } else {
-        // Add the new cons to the end of the list
-        current->cdr = OBJECT_VAL(mesche_object_make_cons(vm, args[i], EMPTY_VAL));
-        current = AS_CONS(current->cdr);
-      }
-    }
-
-    // Pop the list from the stack before we return it
-    mesche_vm_stack_pop(vm);
-  }
-
-  return list;
+  return mesche_object_make_list(vm, args, arg_count, EMPTY_VAL);
 }
 
 Value core_car_msc(VM *vm, int arg_count, Value *args) {
@@ -183,6 +202,7 @@ Value core_append_msc(VM *vm, int arg_count, Value *args) {
         // Should we attach the list to the previous list?
         if (IS_CONS(prev_list_end)) {
           AS_CONS(prev_list_end)->cdr = current_list;
+          mesche_gc_write_barrier(vm, AS_OBJECT(prev_list_end));
           prev_list_end = EMPTY_VAL;
         }
 
@@ -218,17 +238,17 @@ Value core_append_msc(VM *vm, int arg_count, Value *args) {
 }
 
 Value core_plus_msc(VM *vm, int arg_count, Value *args) {
-  double result = 0.f;
+  Value result = FIXNUM_VAL(0);
   for (int i = 0; i < arg_count; i++) {
     // TODO: ERROR ON NON-NUMBER
     if (!IS_NUMBER(args[i])) {
       PANIC("Object is not a number: %d\n", AS_OBJECT(args[i])->kind);
     }
 
-    result += AS_NUMBER(args[i]);
+    result = mesche_number_add(result, args[i]);
   }
 
-  return NUMBER_VAL(result);
+  return result;
 }
 
 Value core_minus_msc(VM *vm, int arg_count, Value *args) {
@@ -239,34 +259,34 @@ Value core_minus_msc(VM *vm, int arg_count, Value *args) {
 
   if (arg_count == 1) {
     // Special case, single argument should be zero
-    return NUMBER_VAL(0 - AS_NUMBER(args[0]));
+    return mesche_number_subtract(FIXNUM_VAL(0), args[0]);
   }
 
-  double result = AS_NUMBER(args[0]);
+  Value result = args[0];
   for (int i = 1; i < arg_count; i++) {
     // TODO: ERROR ON NON-NUMBER
     if (!IS_NUMBER(args[i])) {
       PANIC("Object is not a number: %d\n", AS_OBJECT(args[i])->kind);
     }
 
-    result -= AS_NUMBER(args[i]);
+    result = mesche_number_subtract(result, args[i]);
   }
 
-  return NUMBER_VAL(result);
+  return result;
 }
 
 Value core_multiply_msc(VM *vm, int arg_count, Value *args) {
-  double result = 1.f;
+  Value result = FIXNUM_VAL(1);
   for (int i = 0; i < arg_count; i++) {
     // TODO: ERROR ON NON-NUMBER
     if (!IS_NUMBER(args[i])) {
       PANIC("Object is not a number: %d\n", AS_OBJECT(args[i])->kind);
     }
 
-    result *= AS_NUMBER(args[i]);
+    result = mesche_number_multiply(result, args[i]);
   }
 
-  return NUMBER_VAL(result);
+  return result;
 }
 
 Value core_divide_msc(VM *vm, int arg_count, Value *args) {
@@ -277,20 +297,20 @@ Value core_divide_msc(VM *vm, int arg_count, Value *args) {
 
   if (arg_count == 1) {
     // Special case, single argument should be inverted
-    return NUMBER_VAL(1 / AS_NUMBER(args[0]));
+    return mesche_number_divide(FIXNUM_VAL(1), args[0]);
   }
 
-  double result = AS_NUMBER(args[0]);
+  Value result = args[0];
   for (int i = 1; i < arg_count; i++) {
     // TODO: ERROR ON NON-NUMBER
     if (!IS_NUMBER(args[i])) {
       PANIC("Object is not a number: %d\n", AS_OBJECT(args[i])->kind);
     }
 
-    result = result / AS_NUMBER(args[i]);
+    result = mesche_number_divide(result, args[i]);
   }
 
-  return NUMBER_VAL(result);
+  return result;
 }
 
 Value core_symbol_to_string_msc(VM *vm, int arg_count, Value *args) {
@@ -338,6 +358,10 @@ void mesche_core_module_init(VM *vm) {
   mesche_vm_define_native_funcs(
       vm, "mesche core",
       (MescheNativeFuncDetails[]){{"number?", core_number_p_msc, true},
+                                  {"exact?", core_exact_p_msc, true},
+                                  {"inexact?", core_inexact_p_msc, true},
+                                  {"exact", core_exact_msc, true},
+                                  {"inexact", core_inexact_msc, true},
                                   {"boolean?", core_boolean_p_msc, true},
                                   {"pair?", core_pair_p_msc, true},
                                   {"string?", core_string_p_msc, true},
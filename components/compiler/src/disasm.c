@@ -7,6 +7,108 @@
 #include "port.h"
 #include "value.h"
 
+static const char *opcode_names[] = {
+    [OP_NOP] = "OP_NOP",
+    [OP_CONSTANT] = "OP_CONSTANT",
+    [OP_FALSE] = "OP_FALSE",
+    [OP_TRUE] = "OP_TRUE",
+    [OP_EMPTY] = "OP_EMPTY",
+    [OP_POP] = "OP_POP",
+    [OP_POP_SCOPE] = "OP_POP_SCOPE",
+    [OP_CONS] = "OP_CONS",
+    [OP_LIST] = "OP_LIST",
+    [OP_ADD] = "OP_ADD",
+    [OP_SUBTRACT] = "OP_SUBTRACT",
+    [OP_MULTIPLY] = "OP_MULTIPLY",
+    [OP_DIVIDE] = "OP_DIVIDE",
+    [OP_MODULO] = "OP_MODULO",
+    [OP_NEGATE] = "OP_NEGATE",
+    [OP_NOT] = "OP_NOT",
+    [OP_GREATER_THAN] = "OP_GREATER_THAN",
+    [OP_GREATER_EQUAL] = "OP_GREATER_EQUAL",
+    [OP_LESS_THAN] = "OP_LESS_THAN",
+    [OP_LESS_EQUAL] = "OP_LESS_EQUAL",
+    [OP_EQV] = "OP_EQV",
+    [OP_EQUAL] = "OP_EQUAL",
+    [OP_LOAD_FILE] = "OP_LOAD_FILE",
+    [OP_DEFINE_RECORD] = "OP_DEFINE_RECORD",
+    [OP_DEFINE_MODULE] = "OP_DEFINE_MODULE",
+    [OP_RESOLVE_MODULE] = "OP_RESOLVE_MODULE",
+    [OP_IMPORT_MODULE] = "OP_IMPORT_MODULE",
+    [OP_ENTER_MODULE] = "OP_ENTER_MODULE",
+    [OP_EXPORT_SYMBOL] = "OP_EXPORT_SYMBOL",
+    [OP_DEFINE_GLOBAL] = "OP_DEFINE_GLOBAL",
+    [OP_SET_GLOBAL] = "OP_SET_GLOBAL",
+    [OP_SET_UPVALUE] = "OP_SET_UPVALUE",
+    [OP_SET_LOCAL] = "OP_SET_LOCAL",
+    [OP_READ_GLOBAL] = "OP_READ_GLOBAL",
+    [OP_READ_UPVALUE] = "OP_READ_UPVALUE",
+    [OP_READ_LOCAL] = "OP_READ_LOCAL",
+    [OP_JUMP] = "OP_JUMP",
+    [OP_JUMP_IF_FALSE] = "OP_JUMP_IF_FALSE",
+    [OP_CALL] = "OP_CALL",
+    [OP_TAIL_CALL] = "OP_TAIL_CALL",
+    [OP_CLOSURE] = "OP_CLOSURE",
+    [OP_CLOSE_UPVALUE] = "OP_CLOSE_UPVALUE",
+    [OP_APPLY] = "OP_APPLY",
+    [OP_TAIL_APPLY] = "OP_TAIL_APPLY",
+    [OP_DISPLAY] = "OP_DISPLAY",
+    [OP_RESET] = "OP_RESET",
+    [OP_SHIFT] = "OP_SHIFT",
+    [OP_REIFY] = "OP_REIFY",
+    [OP_BREAK] = "OP_BREAK",
+    [OP_RETURN] = "OP_RETURN",
+    [OP_READ_LOCAL_LOCAL] = "OP_READ_LOCAL_LOCAL",
+    [OP_READ_LOCAL_CONSTANT] = "OP_READ_LOCAL_CONSTANT",
+    [OP_LOCAL_CONSTANT_ADD] = "OP_LOCAL_CONSTANT_ADD",
+    [OP_LOCAL_CONSTANT_SUBTRACT] = "OP_LOCAL_CONSTANT_SUBTRACT",
+    [OP_LESS_THAN_JUMP_IF_FALSE] = "OP_LESS_THAN_JUMP_IF_FALSE",
+    [OP_LESS_EQUAL_JUMP_IF_FALSE] = "OP_LESS_EQUAL_JUMP_IF_FALSE",
+    [OP_GREATER_THAN_JUMP_IF_FALSE] = "OP_GREATER_THAN_JUMP_IF_FALSE",
+    [OP_GREATER_EQUAL_JUMP_IF_FALSE] = "OP_GREATER_EQUAL_JUMP_IF_FALSE",
+    [OP_ADD_NUM] = "OP_ADD_NUM",
+    [OP_SUBTRACT_NUM] = "OP_SUBTRACT_NUM",
+    [OP_MULTIPLY_NUM] = "OP_MULTIPLY_NUM",
+    [OP_DIVIDE_NUM] = "OP_DIVIDE_NUM",
+    [OP_GREATER_THAN_NUM] = "OP_GREATER_THAN_NUM",
+    [OP_GREATER_EQUAL_NUM] = "OP_GREATER_EQUAL_NUM",
+    [OP_LESS_THAN_NUM] = "OP_LESS_THAN_NUM",
+    [OP_LESS_EQUAL_NUM] = "OP_LESS_EQUAL_NUM",
+    [OP_EQV_NUM] = "OP_EQV_NUM",
+    [OP_EQUAL_NUM] = "OP_EQUAL_NUM",
+    [OP_ADD_FIX] = "OP_ADD_FIX",
+    [OP_SUBTRACT_FIX] = "OP_SUBTRACT_FIX",
+    [OP_MULTIPLY_FIX] = "OP_MULTIPLY_FIX",
+    [OP_GREATER_THAN_FIX] = "OP_GREATER_THAN_FIX",
+    [OP_GREATER_EQUAL_FIX] = "OP_GREATER_EQUAL_FIX",
+    [OP_LESS_THAN_FIX] = "OP_LESS_THAN_FIX",
+    [OP_LESS_EQUAL_FIX] = "OP_LESS_EQUAL_FIX",
+    [OP_EQV_FIX] = "OP_EQV_FIX",
+    [OP_EQUAL_FIX] = "OP_EQUAL_FIX",
+    [OP_ADD_ANY] = "OP_ADD_ANY",
+    [OP_SUBTRACT_ANY] = "OP_SUBTRACT_ANY",
+    [OP_MULTIPLY_ANY] = "OP_MULTIPLY_ANY",
+    [OP_DIVIDE_ANY] = "OP_DIVIDE_ANY",
+    [OP_GREATER_THAN_ANY] = "OP_GREATER_THAN_ANY",
+    [OP_GREATER_EQUAL_ANY] = "OP_GREATER_EQUAL_ANY",
+    [OP_LESS_THAN_ANY] = "OP_LESS_THAN_ANY",
+    [OP_LESS_EQUAL_ANY] = "OP_LESS_EQUAL_ANY",
+    [OP_EQV_ANY] = "OP_EQV_ANY",
+    [OP_EQUAL_ANY] = "OP_EQUAL_ANY",
+    [OP_RECORD_REF] = "OP_RECORD_REF",
+    [OP_TAIL_RECORD_REF] = "OP_TAIL_RECORD_REF",
+    [OP_RECORD_SET] = "OP_RECORD_SET",
+    [OP_TAIL_RECORD_SET] = "OP_TAIL_RECORD_SET",
+};
+
+const char *mesche_disasm_opcode_name(uint8_t opcode) {
+  if (opcode < sizeof(opcode_names) / sizeof(opcode_names[0]) && opcode_names[opcode]) {
+    return opcode_names[opcode];
+  }
+
+  return "OP_UNKNOWN";
+}
+
 int mesche_disasm_simple_instr(MeschePort *port, const char *name, int offset) {
   fprintf(port->data.file.fp, "%s\n", name);
   return offset + 1;
@@ -35,6 +137,16 @@ int mesche_disasm_bytes_instr(MeschePort *port, const char *name, Chunk *chunk,
   return offset + 3;
 }
 
+int mesche_disasm_call_instr(MeschePort *port, const char *name, Chunk *chunk, int offset) {
+  uint8_t arg_count = chunk->code[offset + 1];
+  uint8_t keyword_count = chunk->code[offset + 2];
+  uint16_t cache = (uint16_t)(chunk->code[offset + 3] << 8);
+  cache |= chunk->code[offset + 4];
+  fprintf(port->data.file.fp, "%-16s %4d %4d  [cache %d]\n", name, arg_count, keyword_count,
+          cache);
+  return offset + 5;
+}
+
 int mesche_disasm_jump_instr(MeschePort *port, const char *name, int sign, Chunk *chunk,
                              int offset) {
   uint16_t jump = (uint16_t)(chunk->code[offset + 1] << 8);
@@ -99,6 +211,8 @@ int mesche_disasm_instr(MeschePort *port, Chunk *chunk, int offset) {
     return mesche_disasm_simple_instr(port, "OP_RETURN", offset);
   case OP_APPLY:
     return mesche_disasm_simple_instr(port, "OP_APPLY", offset);
+  case OP_TAIL_APPLY:
+    return mesche_disasm_simple_instr(port, "OP_TAIL_APPLY", offset);
   case OP_RESET:
     return mesche_disasm_simple_instr(port, "OP_RESET", offset);
   case OP_SHIFT:
@@ -142,9 +256,14 @@ int mesche_disasm_instr(MeschePort *port, Chunk *chunk, int offset) {
   case OP_JUMP_IF_FALSE:
     return mesche_disasm_jump_instr(port, "OP_JUMP_IF_FALSE", 1, chunk, offset);
   case OP_CALL:
-    return mesche_disasm_bytes_instr(port, "OP_CALL", chunk, offset);
+    return mesche_disasm_call_instr(port, "OP_CALL", chunk, offset);
   case OP_TAIL_CALL:
-    return mesche_disasm_bytes_instr(port, "OP_TAIL_CALL", chunk, offset);
+    return mesche_disasm_call_instr(port, "OP_TAIL_CALL", chunk, offset);
+  case OP_RECORD_REF:
+  case OP_TAIL_RECORD_REF:
+  case OP_RECORD_SET:
+  case OP_TAIL_RECORD_SET:
+    return mesche_disasm_call_instr(port, mesche_disasm_opcode_name(instr), chunk, offset);
   case OP_CLOSURE: {
     offset++;
     uint8_t constant = chunk->code[offset++];
@@ -165,6 +284,85 @@ int mesche_disasm_instr(MeschePort *port, Chunk *chunk, int offset) {
   }
   case OP_CLOSE_UPVALUE:
     return mesche_disasm_simple_instr(port, "OP_CLOSE_UPVALUE", offset);
+
+  // Superinstructions only replace the first opcode of the sequence they
+  // execute, the instructions after them are disassembled as usual
+  case OP_READ_LOCAL_LOCAL:
+    return mesche_disasm_byte_instr(port, "OP_READ_LOCAL_LOCAL", chunk, offset);
+  case OP_READ_LOCAL_CONSTANT:
+    return mesche_disasm_byte_instr(port, "OP_READ_LOCAL_CONSTANT", chunk, offset);
+  case OP_LOCAL_CONSTANT_ADD:
+    return mesche_disasm_byte_instr(port, "OP_LOCAL_CONSTANT_ADD", chunk, offset);
+  case OP_LOCAL_CONSTANT_SUBTRACT:
+    return mesche_disasm_byte_instr(port, "OP_LOCAL_CONSTANT_SUBTRACT", chunk, offset);
+  case OP_LESS_THAN_JUMP_IF_FALSE:
+    return mesche_disasm_simple_instr(port, "OP_LESS_THAN_JUMP_IF_FALSE", offset);
+  case OP_LESS_EQUAL_JUMP_IF_FALSE:
+    return mesche_disasm_simple_instr(port, "OP_LESS_EQUAL_JUMP_IF_FALSE", offset);
+  case OP_GREATER_THAN_JUMP_IF_FALSE:
+    return mesche_disasm_simple_instr(port, "OP_GREATER_THAN_JUMP_IF_FALSE", offset);
+  case OP_GREATER_EQUAL_JUMP_IF_FALSE:
+    return mesche_disasm_simple_instr(port, "OP_GREATER_EQUAL_JUMP_IF_FALSE", offset);
+
+  // Quickened opcodes
+  case OP_ADD_NUM:
+    return mesche_disasm_simple_instr(port, "OP_ADD_NUM", offset);
+  case OP_SUBTRACT_NUM:
+    return mesche_disasm_simple_instr(port, "OP_SUBTRACT_NUM", offset);
+  case OP_MULTIPLY_NUM:
+    return mesche_disasm_simple_instr(port, "OP_MULTIPLY_NUM", offset);
+  case OP_DIVIDE_NUM:
+    return mesche_disasm_simple_instr(port, "OP_DIVIDE_NUM", offset);
+  case OP_GREATER_THAN_NUM:
+    return mesche_disasm_simple_instr(port, "OP_GREATER_THAN_NUM", offset);
+  case OP_GREATER_EQUAL_NUM:
+    return mesche_disasm_simple_instr(port, "OP_GREATER_EQUAL_NUM", offset);
+  case OP_LESS_THAN_NUM:
+    return mesche_disasm_simple_instr(port, "OP_LESS_THAN_NUM", offset);
+  case OP_LESS_EQUAL_NUM:
+    return mesche_disasm_simple_instr(port, "OP_LESS_EQUAL_NUM", offset);
+  case OP_EQV_NUM:
+    return mesche_disasm_simple_instr(port, "OP_EQV_NUM", offset);
+  case OP_EQUAL_NUM:
+    return mesche_disasm_simple_instr(port, "OP_EQUAL_NUM", offset);
+  case OP_ADD_FIX:
+    return mesche_disasm_simple_instr(port, "OP_ADD_FIX", offset);
+  case OP_SUBTRACT_FIX:
+    return mesche_disasm_simple_instr(port, "OP_SUBTRACT_FIX", offset);
+  case OP_MULTIPLY_FIX:
+    return mesche_disasm_simple_instr(port, "OP_MULTIPLY_FIX", offset);
+  case OP_GREATER_THAN_FIX:
+    return mesche_disasm_simple_instr(port, "OP_GREATER_THAN_FIX", offset);
+  case OP_GREATER_EQUAL_FIX:
+    return mesche_disasm_simple_instr(port, "OP_GREATER_EQUAL_FIX", offset);
+  case OP_LESS_THAN_FIX:
+    return mesche_disasm_simple_instr(port, "OP_LESS_THAN_FIX", offset);
+  case OP_LESS_EQUAL_FIX:
+    return mesche_disasm_simple_instr(port, "OP_LESS_EQUAL_FIX", offset);
+  case OP_EQV_FIX:
+    return mesche_disasm_simple_instr(port, "OP_EQV_FIX", offset);
+  case OP_EQUAL_FIX:
+    return mesche_disasm_simple_instr(port, "OP_EQUAL_FIX", offset);
+  case OP_ADD_ANY:
+    return mesche_disasm_simple_instr(port, "OP_ADD_ANY", offset);
+  case OP_SUBTRACT_ANY:
+    return mesche_disasm_simple_instr(port, "OP_SUBTRACT_ANY", offset);
+  case OP_MULTIPLY_ANY:
+    return mesche_disasm_simple_instr(port, "OP_MULTIPLY_ANY", offset);
+  case OP_DIVIDE_ANY:
+    return mesche_disasm_simple_instr(port, "OP_DIVIDE_ANY", offset);
+  case OP_GREATER_THAN_ANY:
+    return mesche_disasm_simple_instr(port, "OP_GREATER_THAN_ANY", offset);
+  case OP_GREATER_EQUAL_ANY:
+    return mesche_disasm_simple_instr(port, "OP_GREATER_EQUAL_ANY", offset);
+  case OP_LESS_THAN_ANY:
+    return mesche_disasm_simple_instr(port, "OP_LESS_THAN_ANY", offset);
+  case OP_LESS_EQUAL_ANY:
+    return mesche_disasm_simple_instr(port, "OP_LESS_EQUAL_ANY", offset);
+  case OP_EQV_ANY:
+    return mesche_disasm_simple_instr(port, "OP_EQV_ANY", offset);
+  case OP_EQUAL_ANY:
+    return mesche_disasm_simple_instr(port, "OP_EQUAL_ANY", offset);
   default:
     fprintf(port->data.file.fp, "Unknown opcode: %d\n", instr);
     return offset + 1;
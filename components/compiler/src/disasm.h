@@ -3,6 +3,7 @@
 
 #include "chunk.h"
 
+const char *mesche_disasm_opcode_name(uint8_t opcode);
 int mesche_disasm_simple_instr(MeschePort *port, const char *name, int offset);
 int mesche_disasm_const_instr(MeschePort *port, const char *name, Chunk *chunk, int offset);
 int mesche_disasm_instr(MeschePort *port, Chunk *chunk, int offset);
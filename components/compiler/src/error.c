@@ -40,4 +40,4 @@ Value mesche_error(VM *vm, const char *format, ...) {
 
 void mesche_error_print(MescheError *error, MeschePort *port) { printf("ERROR\n"); }
 
-void mesche_free_error(VM *vm, MescheError *error) { FREE(vm, MescheError, error); }
+void mesche_free_error(VM *vm, MescheError *error) { FREE_OBJECT(vm, error); }
@@ -141,10 +141,10 @@ Value fs_file_modified_time_msc(VM *vm, int arg_count, Value *args) {
   struct stat file_stat;
 
   if (stat(file_path, &file_stat) != 0) {
-    return NUMBER_VAL(0);
+    return FIXNUM_VAL(0);
   }
 
-  return NUMBER_VAL(file_stat.st_mtime);
+  return FIXNUM_VAL(file_stat.st_mtime);
 }
 
 Value fs_file_read_all_msc(VM *vm, int arg_count, Value *args) {
@@ -40,5 +40,5 @@ ObjectFunction *mesche_object_make_function(VM *vm, FunctionType type) {
 void mesche_free_function(VM *vm, ObjectFunction *function) {
   mesche_chunk_free((MescheMemory *)vm, &function->chunk);
   function_keyword_args_free((MescheMemory *)vm, &function->keyword_args);
-  FREE(vm, ObjectFunction, function);
+  FREE_OBJECT(vm, function);
 }
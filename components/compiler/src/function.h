@@ -2,15 +2,19 @@
 #define mesche_function_h
 
 #include "chunk.h"
+#include "keyword.h"
 #include "mem.h"
 #include "string.h"
 #include "vm.h"
 
 typedef enum { TYPE_FUNCTION, TYPE_SCRIPT } FunctionType;
 
+// Keyword arguments are matched by their interned keyword object.  Each one
+// occupies the local slot after the function's positional and rest parameters
+// in the order they were declared.
 typedef struct {
-  ObjectString *name;
-  uint8_t default_index;
+  ObjectKeyword *keyword;
+  int default_index;
 } KeywordArgument;
 
 typedef struct {
@@ -1,18 +1,153 @@
+#include <limits.h>
+#include <string.h>
+#include <sys/time.h>
+
+#ifdef MESCHE_PARALLEL_GC
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#endif
+
 #include "array.h"
 #include "compiler.h"
 #include "continuation.h"
 #include "error.h"
+#include "gc.h"
+#include "keyword.h"
 #include "native.h"
 #include "object.h"
 #include "process.h"
+#include "profiler.h"
 #include "record.h"
 #include "util.h"
 #include "vm-impl.h"
+#include "weak.h"
+
+// The factor by which the heap has to grow after a major collection before
+// the next collection is a major one
+#define GC_MAJOR_GROW_FACTOR 2
+
+// The number of bytes of objects traced in each slice of incremental marking
+#define GC_MARK_SLICE_SIZE (256 * 1024)
+
+// The number of pages swept in each slice of incremental sweeping
+#define GC_SWEEP_SLICE_PAGES 8
+
+// The number of gray objects a marker shares with the other markers at once
+#define GC_SHARE_SIZE 64
+
+#if defined(MESCHE_GENERATIONAL_GC) || defined(MESCHE_INCREMENTAL_GC)
+// Native pointers trace their references through their type's mark function,
+// so the write barrier can't see when those references change.  Marked
+// pointers like that stay in the remembered set permanently instead.
+static bool gc_is_always_remembered(Object *object) {
+  return object->kind == ObjectKindPointer && ((ObjectPointer *)object)->type != NULL &&
+         ((ObjectPointer *)object)->type->mark_func != NULL;
+}
+#endif
+
+// Objects that don't reference other objects never need to be traced
+static inline bool gc_has_references(Object *object) {
+  return (object->kind != ObjectKindString && object->kind != ObjectKindKeyword &&
+          object->kind != ObjectKindNativeFunction && object->kind != ObjectKindPointer &&
+          object->kind != ObjectKindStackMarker) ||
+         (object->kind == ObjectKindPointer && ((ObjectPointer *)object)->type != NULL &&
+          ((ObjectPointer *)object)->type->mark_func != NULL);
+}
+
+#ifdef MESCHE_PARALLEL_GC
+// Each marker traces the objects on its own gray stack without locking.  When
+// the stack gets deep, part of it is moved to the marker's shared stack where
+// markers that have run out of objects to trace can steal it.
+typedef struct GCMarker {
+  VM *vm;
+  pthread_t thread;
+  Object **gray_stack;
+  int gray_count;
+  int gray_capacity;
+  pthread_mutex_t shared_lock;
+  Object *shared_stack[GC_SHARE_SIZE];
+  int shared_count;
+} GCMarker;
+
+typedef struct GCMarkerPool {
+  GCMarker *markers;
+  int marker_count;
+
+  // Markers other than the collecting thread wait for the epoch to change
+  // before marking and report back when they're done
+  pthread_mutex_t lock;
+  pthread_cond_t start_cond;
+  pthread_cond_t finish_cond;
+  uint64_t epoch;
+  int finished_count;
+  bool is_stopping;
+
+  // The number of markers that are still looking for objects to trace
+  int active_count;
+} GCMarkerPool;
+
+// The marker of the current thread while objects are marked in parallel
+static _Thread_local GCMarker *gc_current_marker = NULL;
+
+static void gc_marker_push(GCMarker *marker, Object *object) {
+  if (marker->gray_capacity < marker->gray_count + 1) {
+    marker->gray_capacity = GROW_CAPACITY(marker->gray_capacity);
+    marker->gray_stack =
+        (Object **)realloc(marker->gray_stack, sizeof(Object *) * marker->gray_capacity);
+
+    if (marker->gray_stack == NULL) {
+      PANIC("GC marker's gray stack could not be reallocated.");
+    }
+  }
+
+  marker->gray_stack[marker->gray_count++] = object;
+}
+#endif
+
+void mesche_gc_remember(VM *vm, Object *object) {
+#ifdef MESCHE_INCREMENTAL_GC
+  // Marks only need to be kept up to date while marking is in progress
+  if (vm->gc_phase != GC_PHASE_MARKING) {
+    return;
+  }
+#endif
+
+  if (vm->remembered_capacity < vm->remembered_count + 1) {
+    vm->remembered_capacity = GROW_CAPACITY(vm->remembered_capacity);
+    vm->remembered_set =
+        (Object **)realloc(vm->remembered_set, sizeof(Object *) * vm->remembered_capacity);
+
+    if (vm->remembered_set == NULL) {
+      PANIC("VM's remembered set could not be reallocated.");
+    }
+  }
+
+  object->is_remembered = true;
+  vm->remembered_set[vm->remembered_count++] = object;
+}
 
 void mesche_gc_mark_object(VM *vm, Object *object) {
   if (object == NULL)
     return;
-  if (object->is_marked)
+
+  if (vm->gc_visit_func != NULL) {
+    vm->gc_visit_func(object, vm->gc_visit_context);
+    return;
+  }
+
+#ifdef MESCHE_PARALLEL_GC
+  // Another marker may be marking the same object at the same time
+  GCMarker *marker = gc_current_marker;
+  if (marker != NULL) {
+    if (mesche_heap_try_mark(object) && gc_has_references(object)) {
+      gc_marker_push(marker, object);
+    }
+    return;
+  }
+#endif
+
+  if (mesche_heap_is_marked(object))
     return;
 
 #ifdef DEBUG_LOG_GC
@@ -21,14 +156,16 @@ void mesche_gc_mark_object(VM *vm, Object *object) {
   printf("\n");
 #endif
 
-  object->is_marked = true;
+  mesche_heap_set_marked(object);
+
+#if defined(MESCHE_GENERATIONAL_GC) || defined(MESCHE_INCREMENTAL_GC)
+  if (gc_is_always_remembered(object)) {
+    mesche_gc_remember(vm, object);
+  }
+#endif
 
   // Add the object to the gray stack if it has references to trace
-  if ((object->kind != ObjectKindString && object->kind != ObjectKindKeyword &&
-       object->kind != ObjectKindNativeFunction && object->kind != ObjectKindPointer &&
-       object->kind != ObjectKindStackMarker) ||
-      (object->kind == ObjectKindPointer && ((ObjectPointer *)object)->type != NULL &&
-       ((ObjectPointer *)object)->type->mark_func != NULL)) {
+  if (gc_has_references(object)) {
     // Resize the gray stack if necessary (tracks visited objects)
     if (vm->gray_capacity < vm->gray_count + 1) {
       vm->gray_capacity = GROW_CAPACITY(vm->gray_capacity);
@@ -108,6 +245,22 @@ static void gc_mark_roots(void *target) {
   gc_mark_table(vm, &vm->modules);
 }
 
+// Weak tables are darkened by one marker at most when marking in parallel, but
+// several can add tables at the same time
+static void gc_push_traced_weak_table(VM *vm, ObjectWeakTable *table) {
+  table->is_traced = true;
+#ifdef MESCHE_PARALLEL_GC
+  ObjectWeakTable *head = __atomic_load_n(&vm->weak_tables, __ATOMIC_RELAXED);
+  do {
+    table->next_traced = head;
+  } while (!__atomic_compare_exchange_n(&vm->weak_tables, &head, table, true, __ATOMIC_RELEASE,
+                                        __ATOMIC_RELAXED));
+#else
+  table->next_traced = vm->weak_tables;
+  vm->weak_tables = table;
+#endif
+}
+
 static void gc_darken_object(VM *vm, Object *object) {
 #ifdef DEBUG_LOG_GC
   printf("%p    darken ", (void *)object);
@@ -175,14 +328,23 @@ static void gc_darken_object(VM *vm, Object *object) {
     mesche_gc_mark_object(vm, (Object *)function->name);
     gc_mark_array(vm, &function->chunk.constants);
 
+    // Keep cached callees alive so that a cache entry can never match a new
+    // object allocated at the same address
+    for (int i = 0; i < function->chunk.call_cache_count; i++) {
+      for (int j = 0; j < CALL_CACHE_WAYS; j++) {
+        mesche_gc_mark_object(vm, function->chunk.call_caches[i].callees[j]);
+      }
+      mesche_gc_mark_object(vm, function->chunk.call_caches[i].keyword_callee);
+    }
+
     // Mark the file name string
     if (function->chunk.file_name) {
       mesche_gc_mark_object(vm, (Object *)function->chunk.file_name);
     }
 
-    // Mark strings associated with keyword arguments
+    // Mark keywords associated with keyword arguments
     for (int i = 0; i < function->keyword_args.count; i++) {
-      mesche_gc_mark_object(vm, (Object *)function->keyword_args.args[i].name);
+      mesche_gc_mark_object(vm, (Object *)function->keyword_args.args[i].keyword);
     }
     break;
   }
@@ -200,6 +362,7 @@ static void gc_darken_object(VM *vm, Object *object) {
     ObjectModule *module = (ObjectModule *)object;
     mesche_gc_mark_object(vm, (Object *)module->name);
     gc_mark_table(vm, &module->locals);
+    gc_mark_array(vm, &module->bindings);
     gc_mark_array(vm, &module->imports);
     gc_mark_array(vm, &module->exports);
     mesche_gc_mark_object(vm, (Object *)module->init_function);
@@ -219,11 +382,13 @@ static void gc_darken_object(VM *vm, Object *object) {
     ObjectRecord *record = (ObjectRecord *)object;
     mesche_gc_mark_object(vm, (Object *)record->name);
     gc_mark_array(vm, &record->fields);
+    gc_mark_array(vm, &record->field_defaults);
     break;
   }
   case ObjectKindRecordField: {
     ObjectRecordField *field = (ObjectRecordField *)object;
     mesche_gc_mark_object(vm, (Object *)field->name);
+    mesche_gc_mark_object(vm, (Object *)field->keyword);
     gc_mark_value(vm, field->default_value);
     break;
   }
@@ -239,7 +404,9 @@ static void gc_darken_object(VM *vm, Object *object) {
   }
   case ObjectKindRecordInstance: {
     ObjectRecordInstance *instance = (ObjectRecordInstance *)object;
-    gc_mark_array(vm, &instance->field_values);
+    for (int i = 0; i < instance->field_count; i++) {
+      gc_mark_value(vm, instance->field_values[i]);
+    }
     mesche_gc_mark_object(vm, (Object *)instance->record_type);
     break;
   }
@@ -248,14 +415,257 @@ static void gc_darken_object(VM *vm, Object *object) {
     mesche_gc_mark_object(vm, (Object *)predicate->record_type);
     break;
   }
+  case ObjectKindWeakTable: {
+    // Keys are never marked from the table.  Ephemeron values are only marked
+    // once their keys are, see `gc_mark_ephemerons`, but visitors see them
+    // all.
+    ObjectWeakTable *table = (ObjectWeakTable *)object;
+    if (table->kind == WEAK_TABLE_KEYS || vm->gc_visit_func != NULL) {
+      for (int i = 0; i < table->capacity; i++) {
+        if (table->entries[i].key != NULL) {
+          gc_mark_value(vm, table->entries[i].value);
+        }
+      }
+    }
+
+    if (vm->gc_visit_func == NULL && !table->is_traced) {
+      gc_push_traced_weak_table(vm, table);
+    }
+    break;
+  }
   default:
     break;
   }
 }
 
+#ifdef MESCHE_PARALLEL_GC
+static void gc_marker_share(GCMarker *marker) {
+  // Move objects from the top of the gray stack so that the rest of the stack
+  // stays in place
+  pthread_mutex_lock(&marker->shared_lock);
+  if (marker->shared_count == 0) {
+    marker->gray_count -= GC_SHARE_SIZE;
+    memcpy(marker->shared_stack, marker->gray_stack + marker->gray_count,
+           sizeof(Object *) * GC_SHARE_SIZE);
+    __atomic_store_n(&marker->shared_count, GC_SHARE_SIZE, __ATOMIC_RELEASE);
+  }
+  pthread_mutex_unlock(&marker->shared_lock);
+}
+
+static bool gc_marker_steal_from(GCMarker *marker, GCMarker *victim) {
+  if (__atomic_load_n(&victim->shared_count, __ATOMIC_ACQUIRE) == 0) {
+    return false;
+  }
+
+  pthread_mutex_lock(&victim->shared_lock);
+  int count = victim->shared_count;
+  for (int i = 0; i < count; i++) {
+    gc_marker_push(marker, victim->shared_stack[i]);
+  }
+  __atomic_store_n(&victim->shared_count, 0, __ATOMIC_RELEASE);
+  pthread_mutex_unlock(&victim->shared_lock);
+
+  return count > 0;
+}
+
+static bool gc_marker_steal(GCMarkerPool *pool, GCMarker *marker) {
+  // Take back the marker's own shared objects before stealing from others
+  if (gc_marker_steal_from(marker, marker)) {
+    return true;
+  }
+
+  int index = marker - pool->markers;
+  for (int i = 1; i < pool->marker_count; i++) {
+    if (gc_marker_steal_from(marker, &pool->markers[(index + i) % pool->marker_count])) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+static bool gc_marker_pool_has_shared(GCMarkerPool *pool) {
+  for (int i = 0; i < pool->marker_count; i++) {
+    if (__atomic_load_n(&pool->markers[i].shared_count, __ATOMIC_ACQUIRE) > 0) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+static void gc_marker_trace(GCMarkerPool *pool, GCMarker *marker) {
+  while (true) {
+    while (marker->gray_count > 0) {
+      Object *object = marker->gray_stack[--marker->gray_count];
+      gc_darken_object(marker->vm, object);
+
+      if (marker->gray_count > 2 * GC_SHARE_SIZE &&
+          __atomic_load_n(&marker->shared_count, __ATOMIC_RELAXED) == 0) {
+        gc_marker_share(marker);
+      }
+    }
+
+    if (gc_marker_steal(pool, marker)) {
+      continue;
+    }
+
+    // A marker only stops looking for work once its own shared stack is
+    // empty, so there's nothing left to trace when every marker has stopped
+    __atomic_sub_fetch(&pool->active_count, 1, __ATOMIC_SEQ_CST);
+    while (true) {
+      if (__atomic_load_n(&pool->active_count, __ATOMIC_SEQ_CST) == 0) {
+        return;
+      }
+
+      if (gc_marker_pool_has_shared(pool)) {
+        __atomic_add_fetch(&pool->active_count, 1, __ATOMIC_SEQ_CST);
+        if (gc_marker_steal(pool, marker)) {
+          break;
+        }
+        __atomic_sub_fetch(&pool->active_count, 1, __ATOMIC_SEQ_CST);
+      }
+
+      sched_yield();
+    }
+  }
+}
+
+static void *gc_marker_thread(void *arg) {
+  GCMarker *marker = (GCMarker *)arg;
+  GCMarkerPool *pool = marker->vm->marker_pool;
+  gc_current_marker = marker;
+
+  uint64_t epoch = 0;
+  pthread_mutex_lock(&pool->lock);
+  while (true) {
+    while (pool->epoch == epoch && !pool->is_stopping) {
+      pthread_cond_wait(&pool->start_cond, &pool->lock);
+    }
+
+    if (pool->is_stopping) {
+      break;
+    }
+
+    epoch = pool->epoch;
+    pthread_mutex_unlock(&pool->lock);
+
+    gc_marker_trace(pool, marker);
+
+    pthread_mutex_lock(&pool->lock);
+    pool->finished_count++;
+    pthread_cond_signal(&pool->finish_cond);
+  }
+  pthread_mutex_unlock(&pool->lock);
+
+  return NULL;
+}
+
+static GCMarkerPool *gc_marker_pool_start(VM *vm) {
+  long cpu_count = vm->gc_marker_count > 0 ? vm->gc_marker_count : sysconf(_SC_NPROCESSORS_ONLN);
+
+  GCMarkerPool *pool = malloc(sizeof(GCMarkerPool));
+  if (pool == NULL) {
+    PANIC("GC marker pool could not be allocated.");
+  }
+
+  pool->marker_count = cpu_count < 1 ? 1 : cpu_count > GC_MAX_MARKERS ? GC_MAX_MARKERS : cpu_count;
+  pool->markers = calloc(pool->marker_count, sizeof(GCMarker));
+  if (pool->markers == NULL) {
+    PANIC("GC markers could not be allocated.");
+  }
+
+  pthread_mutex_init(&pool->lock, NULL);
+  pthread_cond_init(&pool->start_cond, NULL);
+  pthread_cond_init(&pool->finish_cond, NULL);
+  pool->epoch = 0;
+  pool->finished_count = 0;
+  pool->is_stopping = false;
+  pool->active_count = 0;
+  vm->marker_pool = pool;
+
+  // The first marker belongs to the thread that collects garbage
+  for (int i = 0; i < pool->marker_count; i++) {
+    GCMarker *marker = &pool->markers[i];
+    marker->vm = vm;
+    pthread_mutex_init(&marker->shared_lock, NULL);
+    if (i > 0 && pthread_create(&marker->thread, NULL, gc_marker_thread, marker) != 0) {
+      PANIC("GC marker thread could not be started.");
+    }
+  }
+
+  return pool;
+}
+
+static void gc_marker_pool_stop(VM *vm) {
+  GCMarkerPool *pool = vm->marker_pool;
+  if (pool == NULL) {
+    return;
+  }
+
+  pthread_mutex_lock(&pool->lock);
+  pool->is_stopping = true;
+  pthread_cond_broadcast(&pool->start_cond);
+  pthread_mutex_unlock(&pool->lock);
+
+  for (int i = 0; i < pool->marker_count; i++) {
+    GCMarker *marker = &pool->markers[i];
+    if (i > 0) {
+      pthread_join(marker->thread, NULL);
+    }
+
+    pthread_mutex_destroy(&marker->shared_lock);
+    free(marker->gray_stack);
+  }
+
+  pthread_mutex_destroy(&pool->lock);
+  pthread_cond_destroy(&pool->start_cond);
+  pthread_cond_destroy(&pool->finish_cond);
+  free(pool->markers);
+  free(pool);
+  vm->marker_pool = NULL;
+}
+
+static void gc_trace_references_parallel(VM *vm) {
+  GCMarkerPool *pool = vm->marker_pool != NULL ? vm->marker_pool : gc_marker_pool_start(vm);
+
+  // The objects marked from the roots become the first marker's gray objects
+  GCMarker *marker = &pool->markers[0];
+  for (int i = 0; i < vm->gray_count; i++) {
+    gc_marker_push(marker, vm->gray_stack[i]);
+  }
+  vm->gray_count = 0;
+
+  pthread_mutex_lock(&pool->lock);
+  pool->active_count = pool->marker_count;
+  pool->finished_count = 0;
+  pool->epoch++;
+  pthread_cond_broadcast(&pool->start_cond);
+  pthread_mutex_unlock(&pool->lock);
+
+  gc_current_marker = marker;
+  gc_marker_trace(pool, marker);
+  gc_current_marker = NULL;
+
+  pthread_mutex_lock(&pool->lock);
+  while (pool->finished_count < pool->marker_count - 1) {
+    pthread_cond_wait(&pool->finish_cond, &pool->lock);
+  }
+  pthread_mutex_unlock(&pool->lock);
+}
+#endif
+
 static void gc_trace_references(MescheMemory *mem) {
   VM *vm = (VM *)mem;
 
+#ifdef MESCHE_PARALLEL_GC
+  // Arena scopes are marked by a visitor on this thread
+  if (vm->mem.bytes_allocated >= vm->gc_parallel_min_heap && vm->gc_visit_func == NULL) {
+    gc_trace_references_parallel(vm);
+    return;
+  }
+#endif
+
   // Loop through the stack (which may get more entries added during the loop)
   // to darken all marked objects
   while (vm->gray_count > 0) {
@@ -264,53 +674,885 @@ static void gc_trace_references(MescheMemory *mem) {
   }
 }
 
-static void gc_table_remove_white(Table *table) {
+#if defined(MESCHE_GENERATIONAL_GC) || defined(MESCHE_INCREMENTAL_GC)
+static void gc_trace_remembered(VM *vm) {
+  // Darken every remembered object so that the young objects it was given
+  // references to get marked.  Objects that get remembered while this happens
+  // are added after the existing entries, which are compacted down to the ones
+  // that stay remembered.
+  int count = vm->remembered_count;
+  int kept_count = 0;
+  for (int i = 0; i < count; i++) {
+    Object *object = vm->remembered_set[i];
+    gc_darken_object(vm, object);
+
+    if (gc_is_always_remembered(object)) {
+      vm->remembered_set[kept_count++] = object;
+    } else {
+      object->is_remembered = false;
+    }
+  }
+
+  if (vm->remembered_count > count) {
+    memmove(vm->remembered_set + kept_count, vm->remembered_set + count,
+            sizeof(Object *) * (vm->remembered_count - count));
+  }
+  vm->remembered_count -= count - kept_count;
+}
+
+static void gc_forget_remembered(VM *vm) {
+  for (int i = 0; i < vm->remembered_count; i++) {
+    vm->remembered_set[i]->is_remembered = false;
+  }
+
+  vm->remembered_count = 0;
+}
+#endif
+
+#ifdef MESCHE_GENERATIONAL_GC
+static void gc_clear_marks(VM *vm) {
+  // A major collection starts over with every object unmarked
+  mesche_heap_clear_marks(&vm->mem.heap);
+  gc_forget_remembered(vm);
+}
+#endif
+
+static void gc_table_remove_white(VM *vm, Table *table) {
   for (int i = 0; i < table->capacity; i++) {
     Entry *entry = &table->entries[i];
-    if (entry->key != NULL && !entry->key->object.is_marked) {
+    if (entry->key != NULL && !mesche_heap_is_live(&vm->mem.heap, entry->key)) {
       mesche_table_delete(table, entry->key);
     }
   }
 }
 
-static void gc_sweep_objects(VM *vm) {
-  Object *previous = NULL;
-  Object *object = vm->objects;
+// A guardian holds the objects registered with it weakly.  When one of them
+// is found to be unreachable it's kept alive and moved to the ready list,
+// where Scheme code can take it to clean up after it.
+typedef struct GCGuardian {
+  // The pointer object that the guardian belongs to
+  Object *object;
+  struct GCGuardian *next;
 
-  // Walk through the object linked list
-  while (object != NULL) {
-    // If the object is marked, move to the next object, retaining
-    // a pointer this one so that the next live object can be linked
-    // to it
-    if (object->is_marked) {
-      object->is_marked = false; // Seeya next time...
-      previous = object;
-      object = object->next;
-    } else {
-      // If the object is unmarked, remove it from the linked list
-      // and free it
-      Object *unreached = object;
-      object = object->next;
-      if (previous != NULL) {
-        previous->next = object;
+  Object **pending;
+  int pending_count;
+  int pending_capacity;
+
+  Object **ready;
+  int ready_count;
+  int ready_capacity;
+} GCGuardian;
+
+static void gc_guardian_push(Object ***objects, int *count, int *capacity, Object *object) {
+  if (*capacity < *count + 1) {
+    *capacity = GROW_CAPACITY(*capacity);
+    *objects = realloc(*objects, sizeof(Object *) * *capacity);
+    if (*objects == NULL) {
+      PANIC("Guardian's objects could not be reallocated.");
+    }
+  }
+
+  (*objects)[(*count)++] = object;
+}
+
+// Registered objects that weren't marked are moved to their guardian's ready
+// list and marked, returning true if there were any
+static bool gc_resurrect_guarded(VM *vm) {
+  bool found_ready = false;
+  for (GCGuardian *guardian = vm->guardians; guardian != NULL; guardian = guardian->next) {
+    if (!mesche_heap_is_live(&vm->mem.heap, guardian->object)) {
+      continue;
+    }
+
+    int kept_count = 0;
+    for (int i = 0; i < guardian->pending_count; i++) {
+      Object *object = guardian->pending[i];
+      if (mesche_heap_is_live(&vm->mem.heap, object)) {
+        guardian->pending[kept_count++] = object;
       } else {
-        vm->objects = object;
+        gc_guardian_push(&guardian->ready, &guardian->ready_count, &guardian->ready_capacity,
+                         object);
+        mesche_gc_mark_object(vm, object);
+        found_ready = true;
       }
+    }
+
+    guardian->pending_count = kept_count;
+  }
+
+  return found_ready;
+}
+
+// Marks the values of ephemerons whose keys have been marked, returning true
+// if any were
+static bool gc_mark_ephemerons(VM *vm) {
+  bool found_value = false;
+  for (ObjectWeakTable *table = vm->weak_tables; table != NULL; table = table->next_traced) {
+    if (table->kind != WEAK_TABLE_EPHEMERONS) {
+      continue;
+    }
 
-      mesche_object_free(vm, unreached);
+    for (int i = 0; i < table->capacity; i++) {
+      WeakEntry *entry = &table->entries[i];
+      if (entry->key != NULL && mesche_heap_is_live(&vm->mem.heap, entry->key) &&
+          IS_OBJECT(entry->value) && !mesche_heap_is_live(&vm->mem.heap, AS_OBJECT(entry->value))) {
+        mesche_gc_mark_object(vm, AS_OBJECT(entry->value));
+        found_value = true;
+      }
     }
   }
+
+  return found_value;
 }
 
-void mesche_gc_collect_garbage(MescheMemory *mem) {
-  VM *vm = (VM *)mem;
+// Must be called after marking finishes.  Ephemeron values are marked until no
+// more of their keys are reachable, then guardians take the objects that are
+// still unmarked, which can make more keys reachable.  Whatever isn't live
+// after that is garbage, so weak table entries with unmarked keys are removed,
+// guardians that weren't marked are dropped along with the objects registered
+// with them, and so are the escaped objects recorded by open arena scopes.
+static void gc_process_weak_references(VM *vm) {
+  for (;;) {
+    while (gc_mark_ephemerons(vm)) {
+      gc_trace_references((MescheMemory *)vm);
+    }
+
+    if (!gc_resurrect_guarded(vm)) {
+      break;
+    }
+
+    gc_trace_references((MescheMemory *)vm);
+  }
+
+  for (ObjectWeakTable *table = vm->weak_tables; table != NULL; table = table->next_traced) {
+    for (int i = 0; i < table->capacity; i++) {
+      WeakEntry *entry = &table->entries[i];
+      if (entry->key != NULL && !mesche_heap_is_live(&vm->mem.heap, entry->key)) {
+        mesche_weak_table_delete(table, entry->key);
+      }
+    }
+    table->is_traced = false;
+  }
+  vm->weak_tables = NULL;
+
+  GCGuardian **link = &vm->guardians;
+  while (*link != NULL) {
+    if (mesche_heap_is_live(&vm->mem.heap, (*link)->object)) {
+      link = &(*link)->next;
+    } else {
+      *link = (*link)->next;
+    }
+  }
+
+  for (int i = 0; i < vm->arena_count; i++) {
+    GCArena *arena = &vm->arenas[i];
+    int kept_count = 0;
+    for (int j = 0; j < arena->escape_count; j++) {
+      if (mesche_heap_is_live(&vm->mem.heap, arena->escapes[j])) {
+        arena->escapes[kept_count++] = arena->escapes[j];
+      }
+    }
+    arena->escape_count = kept_count;
+  }
+}
+
+static void gc_guardian_mark(MescheMemory *mem, Object *object) {
+  GCGuardian *guardian = (GCGuardian *)object;
+  for (int i = 0; i < guardian->ready_count; i++) {
+    mesche_gc_mark_object((VM *)mem, guardian->ready[i]);
+  }
+}
+
+static void gc_guardian_free(MescheMemory *mem, void *object) {
+  GCGuardian *guardian = (GCGuardian *)object;
+  free(guardian->pending);
+  free(guardian->ready);
+  free(guardian);
+}
+
+static const ObjectPointerType gc_guardian_type = {
+    .name = "guardian", .free_func = gc_guardian_free, .mark_func = gc_guardian_mark};
+
+static void gc_free_object(MescheMemory *mem, void *object) {
+  mesche_object_free((VM *)mem, (Object *)object);
+}
+
+// Queues the release of a collected object's native resource, like closing
+// its file, so that collection pauses don't depend on how long that takes
+void mesche_gc_defer_finalizer(VM *vm, ObjectFreePtr finalize_func, void *data) {
+  if (vm->finalizer_capacity < vm->finalizer_count + 1) {
+    vm->finalizer_capacity = GROW_CAPACITY(vm->finalizer_capacity);
+    vm->finalizers = realloc(vm->finalizers, sizeof(GCFinalizer) * vm->finalizer_capacity);
+    if (vm->finalizers == NULL) {
+      PANIC("VM's finalizers could not be reallocated.");
+    }
+  }
+
+  vm->finalizers[vm->finalizer_count++] =
+      (GCFinalizer){.finalize_func = finalize_func, .data = data};
+}
+
+// Runs up to `max_count` pending finalizers in the order they were queued, or
+// all of them if `max_count` is negative.  Returns the number that ran.
+int mesche_gc_run_finalizers(VM *vm, int max_count) {
+  int run_count = 0;
+  while (vm->finalizer_next < vm->finalizer_count && (max_count < 0 || run_count < max_count)) {
+    // Finalizers may queue more finalizers, so the queue is read each time
+    GCFinalizer finalizer = vm->finalizers[vm->finalizer_next++];
+    finalizer.finalize_func((MescheMemory *)vm, finalizer.data);
+    run_count++;
+  }
+
+  if (vm->finalizer_next == vm->finalizer_count) {
+    vm->finalizer_next = 0;
+    vm->finalizer_count = 0;
+  }
+
+  return run_count;
+}
+
+void mesche_gc_free_objects(VM *vm) {
+#ifdef MESCHE_PARALLEL_GC
+  gc_marker_pool_stop(vm);
+#endif
+
+  mesche_heap_free_all(&vm->mem, gc_free_object);
+  vm->guardians = NULL;
+
+  for (int i = 0; i < vm->arena_count; i++) {
+    free(vm->arenas[i].escapes);
+  }
+
+  free(vm->arenas);
+  vm->arenas = NULL;
+  vm->arena_count = 0;
+  vm->arena_capacity = 0;
+
+  mesche_gc_run_finalizers(vm, -1);
+  free(vm->finalizers);
+  vm->finalizers = NULL;
+  vm->finalizer_capacity = 0;
+}
+
+static void gc_mark_all_roots(VM *vm) {
   gc_mark_roots(vm);
   if (vm->current_compiler != NULL) {
     mesche_compiler_mark_roots(vm->current_compiler);
   }
+}
+
+#ifdef MESCHE_INCREMENTAL_GC
+static void gc_start_cycle(VM *vm) {
+  vm->gc_phase = GC_PHASE_MARKING;
+  gc_mark_all_roots(vm);
+}
+
+static bool gc_mark_slice(VM *vm, size_t budget) {
+  // Trace the objects that were written to since the last slice before
+  // continuing through the gray stack
+  gc_trace_remembered(vm);
+
+  size_t traced_size = 0;
+  while (vm->gray_count > 0 && traced_size < budget) {
+    Object *object = vm->gray_stack[--vm->gray_count];
+    gc_darken_object(vm, object);
+    traced_size += HEAP_PAGE_OF(object)->cell_size;
+  }
+
+  return vm->gray_count == 0;
+}
+
+static void gc_finish_marking(VM *vm) {
+  // The roots aren't covered by the write barrier, so they get marked again
+  // along with the objects written to since the last slice.  Whatever is
+  // still unmarked after that is garbage.
+  gc_mark_all_roots(vm);
+  gc_trace_remembered(vm);
+  gc_trace_references((MescheMemory *)vm);
+  gc_process_weak_references(vm);
+  gc_forget_remembered(vm);
+
+  gc_table_remove_white(vm, &vm->strings);
+  gc_table_remove_white(vm, &vm->symbols);
+  gc_table_remove_white(vm, &vm->keywords);
+  mesche_profiler_sweep(vm);
+
+  vm->gc_phase = GC_PHASE_SWEEPING;
+  mesche_heap_sweep_lazily(&vm->mem, gc_free_object);
+}
+
+static void gc_finish_sweeping(VM *vm) {
+  mesche_heap_sweep_step(&vm->mem, INT_MAX);
+  vm->gc_phase = GC_PHASE_IDLE;
+}
+#endif
+
+// Performs the next slice of an incremental collection cycle, starting a new
+// cycle if none is in progress.  Returns true once the cycle is finished.
+bool mesche_gc_collect_garbage_slice(MescheMemory *mem) {
+#ifdef MESCHE_INCREMENTAL_GC
+  VM *vm = (VM *)mem;
+
+  switch (vm->gc_phase) {
+  case GC_PHASE_IDLE:
+    gc_start_cycle(vm);
+    break;
+  case GC_PHASE_MARKING:
+    if (gc_mark_slice(vm, GC_MARK_SLICE_SIZE)) {
+      gc_finish_marking(vm);
+    }
+    break;
+  case GC_PHASE_SWEEPING:
+    if (mesche_heap_sweep_step(mem, GC_SWEEP_SLICE_PAGES)) {
+      vm->gc_phase = GC_PHASE_IDLE;
+      return true;
+    }
+    break;
+  }
+
+  return false;
+#else
+  mesche_gc_collect_garbage(mem);
+  return true;
+#endif
+}
+
+#ifdef MESCHE_INCREMENTAL_GC
+static long gc_elapsed_usec(struct timeval *start) {
+  struct timeval now;
+  gettimeofday(&now, NULL);
+
+  return (now.tv_sec - start->tv_sec) * 1000000L + (now.tv_usec - start->tv_usec);
+}
+#endif
+
+// Performs slices of incremental collection for up to `budget_usec`
+// microseconds so that a host can get collection work done while it's idle
+// rather than when it next allocates.  A new cycle is only started once the
+// heap is at least halfway to its next collection.  Returns true if a cycle
+// is still in progress.  Does nothing unless garbage is collected
+// incrementally.
+bool mesche_gc_step(VM *vm, long budget_usec) {
+#ifdef MESCHE_INCREMENTAL_GC
+  if (vm->gc_phase == GC_PHASE_IDLE && vm->mem.bytes_allocated < vm->mem.next_gc / 2) {
+    return false;
+  }
+
+  struct timeval start;
+  gettimeofday(&start, NULL);
+  do {
+    mesche_mem_collect_garbage_slice((MescheMemory *)vm);
+  } while (vm->gc_phase != GC_PHASE_IDLE && gc_elapsed_usec(&start) < budget_usec);
+
+  return vm->gc_phase != GC_PHASE_IDLE;
+#else
+  return false;
+#endif
+}
+
+void mesche_gc_collect_garbage(MescheMemory *mem) {
+  VM *vm = (VM *)mem;
+
+#ifdef MESCHE_INCREMENTAL_GC
+  // Finish the cycle in progress since it may have marked objects that are
+  // garbage by now, then run a whole new cycle at once
+  if (vm->gc_phase == GC_PHASE_MARKING) {
+    gc_finish_marking(vm);
+  }
+
+  if (vm->gc_phase == GC_PHASE_SWEEPING) {
+    gc_finish_sweeping(vm);
+  }
+
+  gc_start_cycle(vm);
+  gc_finish_marking(vm);
+  gc_finish_sweeping(vm);
+#else
+#ifdef MESCHE_GENERATIONAL_GC
+  // Collect the whole heap once it has grown enough since the last major
+  // collection or is over its limit, otherwise only collect the young
+  // generation
+  bool is_major = vm->mem.bytes_allocated > vm->next_major_gc ||
+                  (vm->mem.heap_limit > 0 && vm->mem.bytes_allocated > vm->mem.heap_limit);
+  if (is_major) {
+    gc_clear_marks(vm);
+  }
+#endif
+
+  gc_mark_all_roots(vm);
+
+#ifdef MESCHE_GENERATIONAL_GC
+  gc_trace_remembered(vm);
+#endif
+
+  gc_trace_references((MescheMemory *)vm);
+  gc_process_weak_references(vm);
+  gc_table_remove_white(vm, &vm->strings);
+  gc_table_remove_white(vm, &vm->symbols);
+  gc_table_remove_white(vm, &vm->keywords);
+  mesche_profiler_sweep(vm);
+
+#ifdef MESCHE_GENERATIONAL_GC
+  // Objects keep their marks after they're swept so that everything that
+  // survives is promoted to the old generation
+  mesche_heap_sweep(&vm->mem, true, gc_free_object);
+  if (is_major) {
+    vm->next_major_gc = vm->mem.bytes_allocated * GC_MAJOR_GROW_FACTOR;
+  }
+#else
+  mesche_heap_sweep(&vm->mem, false, gc_free_object);
+#endif
+#endif
+}
+
+bool mesche_gc_arena_begin(VM *vm) {
+  if (!mesche_heap_arena_begin(&vm->mem.heap)) {
+    return false;
+  }
+
+  if (vm->arena_capacity < vm->arena_count + 1) {
+    vm->arena_capacity = GROW_CAPACITY(vm->arena_capacity);
+    vm->arenas = realloc(vm->arenas, sizeof(GCArena) * vm->arena_capacity);
+    if (vm->arenas == NULL) {
+      PANIC("VM's arena scopes could not be reallocated.");
+    }
+  }
+
+  vm->arenas[vm->arena_count++] = (GCArena){.escapes = NULL};
+  return true;
+}
+
+// Records an object from outside of the innermost arena scope that was
+// written to while it's open
+void mesche_gc_arena_escape(VM *vm, Object *object) {
+  GCArena *arena = &vm->arenas[vm->arena_count - 1];
+  if (arena->escape_capacity < arena->escape_count + 1) {
+    arena->escape_capacity = GROW_CAPACITY(arena->escape_capacity);
+    arena->escapes = realloc(arena->escapes, sizeof(Object *) * arena->escape_capacity);
+    if (arena->escapes == NULL) {
+      PANIC("Arena scope's escaped objects could not be reallocated.");
+    }
+  }
+
+  object->is_escaped = true;
+  arena->escapes[arena->escape_count++] = object;
+}
+
+// Marks the objects of the arena scope that's ending and ignores the rest,
+// which aren't collected
+static void gc_arena_mark(Object *object, void *context) {
+  VM *vm = (VM *)context;
+  if (HEAP_PAGE_OF(object)->arena_depth != vm->mem.heap.arena_depth ||
+      mesche_heap_is_marked(object)) {
+    return;
+  }
+
+  mesche_heap_set_marked(object);
+  if (!gc_has_references(object)) {
+    return;
+  }
+
+#ifdef MESCHE_GENERATIONAL_GC
+  // Everything that survives the arena is promoted to the old generation, so
+  // it has to be traced by the next minor collection in case it refers to
+  // young objects from outside of the arena
+  if (!object->is_remembered) {
+    mesche_gc_remember(vm, object);
+  }
+#endif
+
+  if (object->kind == ObjectKindWeakTable) {
+    gc_push_traced_weak_table(vm, (ObjectWeakTable *)object);
+  }
+
+  if (vm->gray_capacity < vm->gray_count + 1) {
+    vm->gray_capacity = GROW_CAPACITY(vm->gray_capacity);
+    vm->gray_stack = (Object **)realloc(vm->gray_stack, sizeof(Object *) * vm->gray_capacity);
+    if (vm->gray_stack == NULL) {
+      PANIC("VM's gray stack could not be reallocated.");
+    }
+  }
+
+  vm->gray_stack[vm->gray_count++] = object;
+}
+
+// Objects from outside of the arena can only refer to its objects if they're
+// roots or were written to while it was open, so those are all that need to be
+// traced to find the arena's live objects.  Open arenas share the escaped
+// flag, so the objects recorded by the enclosing arenas are traced too.
+static void gc_arena_trace_escapes(VM *vm) {
+  for (int i = 0; i < vm->arena_count; i++) {
+    GCArena *arena = &vm->arenas[i];
+    for (int j = 0; j < arena->escape_count; j++) {
+      Object *object = arena->escapes[j];
+      if (object->kind == ObjectKindWeakTable && !((ObjectWeakTable *)object)->is_traced) {
+        gc_push_traced_weak_table(vm, (ObjectWeakTable *)object);
+      }
+
+      gc_darken_object(vm, object);
+    }
+  }
+
+#ifdef MESCHE_GENERATIONAL_GC
+  // Native pointers that stay remembered may refer to the arena's objects
+  // without going through the write barrier
+  for (int i = 0; i < vm->remembered_count; i++) {
+    Object *object = vm->remembered_set[i];
+    if (HEAP_PAGE_OF(object)->arena_depth < vm->mem.heap.arena_depth) {
+      gc_darken_object(vm, object);
+    }
+  }
+#endif
+
+  // Guardians outside of the arena hold on to their ready objects
+  for (GCGuardian *guardian = vm->guardians; guardian != NULL; guardian = guardian->next) {
+    if (HEAP_PAGE_OF(guardian->object)->arena_depth < vm->mem.heap.arena_depth) {
+      gc_guardian_mark((MescheMemory *)vm, (Object *)guardian);
+    }
+  }
+}
+
+// Ends the innermost arena scope.  Its objects that are still reachable from
+// the roots or from the objects that were written to while it was open are
+// promoted to the enclosing scope in place, and the rest are freed without
+// tracing anything else in the heap.
+void mesche_gc_arena_end(VM *vm) {
+  if (vm->arena_count == 0) {
+    return;
+  }
+
+#ifdef MESCHE_INCREMENTAL_GC
+  // The arena's pages can't be swept while a cycle is in progress
+  if (vm->gc_phase == GC_PHASE_MARKING) {
+    gc_finish_marking(vm);
+  }
+
+  if (vm->gc_phase == GC_PHASE_SWEEPING) {
+    gc_finish_sweeping(vm);
+  }
+#endif
+
+  MescheHeap *heap = &vm->mem.heap;
+#ifdef MESCHE_GENERATIONAL_GC
+  // Objects that were promoted by minor collections while the arena was open
+  // are collected along with the rest of it
+  mesche_heap_arena_clear_marks(heap);
+#endif
+
+  heap->is_collecting_arena = true;
+  vm->gc_visit_func = gc_arena_mark;
+  vm->gc_visit_context = vm;
+
+  gc_mark_all_roots(vm);
+  gc_arena_trace_escapes(vm);
   gc_trace_references((MescheMemory *)vm);
-  gc_table_remove_white(&vm->strings);
-  gc_table_remove_white(&vm->symbols);
-  gc_table_remove_white(&vm->keywords);
-  gc_sweep_objects(vm);
+  gc_process_weak_references(vm);
+  gc_table_remove_white(vm, &vm->strings);
+  gc_table_remove_white(vm, &vm->symbols);
+  gc_table_remove_white(vm, &vm->keywords);
+  mesche_profiler_sweep(vm);
+
+#ifdef MESCHE_GENERATIONAL_GC
+  // Drop the remembered objects that are about to be freed
+  int kept_count = 0;
+  for (int i = 0; i < vm->remembered_count; i++) {
+    if (mesche_heap_is_live(heap, vm->remembered_set[i])) {
+      vm->remembered_set[kept_count++] = vm->remembered_set[i];
+    }
+  }
+  vm->remembered_count = kept_count;
+#endif
+
+  vm->gc_visit_func = NULL;
+  heap->is_collecting_arena = false;
+
+#ifdef MESCHE_GENERATIONAL_GC
+  mesche_heap_arena_end(&vm->mem, true, gc_free_object);
+#else
+  mesche_heap_arena_end(&vm->mem, false, gc_free_object);
+#endif
+
+  // Escaped objects that are outside of the enclosing arena too might still
+  // refer to its objects
+  GCArena arena = vm->arenas[--vm->arena_count];
+  for (int i = 0; i < arena.escape_count; i++) {
+    Object *object = arena.escapes[i];
+    object->is_escaped = false;
+    if (vm->arena_count > 0 && HEAP_PAGE_OF(object)->arena_depth < heap->arena_depth) {
+      mesche_gc_arena_escape(vm, object);
+    }
+  }
+
+  free(arena.escapes);
+}
+
+// Closes every open arena scope without collecting its objects, which is all
+// that can be done when an error unwinds the stack past them
+void mesche_gc_arena_abandon(VM *vm) {
+  for (int i = 0; i < vm->arena_count; i++) {
+    GCArena *arena = &vm->arenas[i];
+    for (int j = 0; j < arena->escape_count; j++) {
+      arena->escapes[j]->is_escaped = false;
+    }
+
+    free(arena->escapes);
+  }
+
+  vm->arena_count = 0;
+  mesche_heap_arena_abandon(&vm->mem.heap);
+}
+
+static void gc_count_object(void *cell, size_t cell_size, void *context) {
+  MescheObjectStats *stats = (MescheObjectStats *)context;
+  ObjectKind kind = ((Object *)cell)->kind;
+  stats->object_counts[kind]++;
+  stats->object_bytes[kind] += cell_size;
+}
+
+// Counts the objects that are allocated by kind.  Right after a collection
+// these are the live objects.
+void mesche_gc_object_stats(VM *vm, MescheObjectStats *stats) {
+  memset(stats, 0, sizeof(MescheObjectStats));
+  mesche_heap_walk(&vm->mem.heap, gc_count_object, stats);
+}
+
+// Visits the objects that are marked as roots when garbage is collected
+void mesche_gc_visit_roots(VM *vm, GCVisitFunc visit_func, void *context) {
+  vm->gc_visit_func = visit_func;
+  vm->gc_visit_context = context;
+  gc_mark_all_roots(vm);
+  vm->gc_visit_func = NULL;
+}
+
+// Visits the objects that `object` references
+void mesche_gc_visit_references(VM *vm, Object *object, GCVisitFunc visit_func, void *context) {
+  vm->gc_visit_func = visit_func;
+  vm->gc_visit_context = context;
+  gc_darken_object(vm, object);
+  vm->gc_visit_func = NULL;
+}
+
+static void gc_push_keyword(VM *vm, const char *name) {
+  mesche_vm_stack_push(vm, OBJECT_VAL(mesche_object_make_keyword(vm, name, strlen(name))));
+}
+
+// Replaces the values pushed since `start` with a list of them
+static void gc_push_list(VM *vm, int start) {
+  Value list = mesche_object_make_list(vm, vm->stack + start,
+                                       (vm->stack_top - vm->stack) - start, EMPTY_VAL);
+  vm->stack_top = vm->stack + start;
+  mesche_vm_stack_push(vm, list);
+}
+
+Value gc_stats_msc(VM *vm, int arg_count, Value *args) {
+  if (arg_count != 0) {
+    PANIC("Function accepts no parameters.");
+  }
+
+  // Values are kept on the stack while the property list is built.  Offsets
+  // are used since the stack can move as it grows.
+  MescheGCStats *stats = &vm->mem.stats;
+  int start = vm->stack_top - vm->stack;
+
+  gc_push_keyword(vm, "collections");
+  mesche_vm_stack_push(vm, FIXNUM_VAL(stats->collection_count));
+  gc_push_keyword(vm, "pauses");
+  mesche_vm_stack_push(vm, FIXNUM_VAL(stats->pause_count));
+  gc_push_keyword(vm, "pause-total-usec");
+  mesche_vm_stack_push(vm, FIXNUM_VAL((int64_t)(stats->pause_total_seconds * 1e6)));
+  gc_push_keyword(vm, "pause-max-usec");
+  mesche_vm_stack_push(vm, FIXNUM_VAL((int64_t)(stats->pause_max_seconds * 1e6)));
+
+  gc_push_keyword(vm, "pause-histogram");
+  int buckets_start = vm->stack_top - vm->stack;
+  for (int i = 0; i < GC_PAUSE_BUCKET_COUNT; i++) {
+    mesche_vm_stack_push(vm, FIXNUM_VAL(stats->pause_buckets[i]));
+  }
+  gc_push_list(vm, buckets_start);
+
+  gc_push_keyword(vm, "bytes-allocated");
+  mesche_vm_stack_push(vm, FIXNUM_VAL(vm->mem.bytes_allocated));
+  gc_push_keyword(vm, "next-gc");
+  mesche_vm_stack_push(vm, FIXNUM_VAL(vm->mem.next_gc));
+  gc_push_keyword(vm, "bytes-freed");
+  mesche_vm_stack_push(vm, FIXNUM_VAL(stats->bytes_freed));
+  gc_push_keyword(vm, "bytes-freed-total");
+  mesche_vm_stack_push(vm, FIXNUM_VAL(stats->bytes_freed_total));
+  gc_push_keyword(vm, "survival-rate");
+  mesche_vm_stack_push(vm, NUMBER_VAL(stats->survival_rate));
+  gc_push_keyword(vm, "promotion-rate");
+  mesche_vm_stack_push(vm, NUMBER_VAL(stats->promotion_rate));
+
+  // Each kind of object that's allocated maps to its count and bytes
+  MescheObjectStats object_stats;
+  mesche_gc_object_stats(vm, &object_stats);
+  gc_push_keyword(vm, "objects");
+  int objects_start = vm->stack_top - vm->stack;
+  for (int i = 0; i < OBJECT_KIND_COUNT; i++) {
+    if (object_stats.object_counts[i] > 0) {
+      gc_push_keyword(vm, mesche_object_kind_name(i));
+      int entry_start = vm->stack_top - vm->stack;
+      mesche_vm_stack_push(vm, FIXNUM_VAL(object_stats.object_counts[i]));
+      mesche_vm_stack_push(vm, FIXNUM_VAL(object_stats.object_bytes[i]));
+      gc_push_list(vm, entry_start);
+    }
+  }
+  gc_push_list(vm, objects_start);
+
+  gc_push_list(vm, start);
+  return mesche_vm_stack_pop(vm);
+}
+
+Value gc_collect_msc(VM *vm, int arg_count, Value *args) {
+  if (arg_count != 0) {
+    PANIC("Function accepts no parameters.");
+  }
+
+  mesche_mem_collect_garbage((MescheMemory *)vm);
+  return FIXNUM_VAL(vm->mem.bytes_allocated);
+}
+
+Value gc_arena_begin_msc(VM *vm, int arg_count, Value *args) {
+  if (arg_count != 0) {
+    PANIC("Function accepts no parameters.");
+  }
+
+  if (!mesche_gc_arena_begin(vm)) {
+    mesche_vm_raise_error(vm, "Arena scopes can't be nested more than %d deep.",
+                          HEAP_MAX_ARENA_DEPTH);
+    return FALSE_VAL;
+  }
+
+  return TRUE_VAL;
+}
+
+Value gc_arena_end_msc(VM *vm, int arg_count, Value *args) {
+  if (arg_count != 0) {
+    PANIC("Function accepts no parameters.");
+  }
+
+  if (vm->arena_count == 0) {
+    return FALSE_VAL;
+  }
+
+  mesche_gc_arena_end(vm);
+  return FIXNUM_VAL(vm->mem.bytes_allocated);
+}
+
+Value gc_heap_target_set_msc(VM *vm, int arg_count, Value *args) {
+  if (arg_count != 1) {
+    PANIC("Function requires 1 parameter.");
+  }
+
+  int64_t target = AS_INTEGER(args[0]);
+  mesche_mem_set_heap_target((MescheMemory *)vm, target > 0 ? target : 0);
+  return args[0];
+}
+
+Value gc_cpu_percent_set_msc(VM *vm, int arg_count, Value *args) {
+  if (arg_count != 1) {
+    PANIC("Function requires 1 parameter.");
+  }
+
+  mesche_mem_set_gc_cpu_percent((MescheMemory *)vm, AS_INTEGER(args[0]));
+  return args[0];
+}
+
+Value gc_heap_limit_set_msc(VM *vm, int arg_count, Value *args) {
+  if (arg_count != 1) {
+    PANIC("Function requires 1 parameter.");
+  }
+
+  int64_t limit = AS_INTEGER(args[0]);
+  mesche_mem_set_heap_limit((MescheMemory *)vm, limit > 0 ? limit : 0);
+  return args[0];
+}
+
+static GCGuardian *gc_expect_guardian(VM *vm, Value value) {
+  if (!IS_POINTER(value) || AS_POINTER(value)->type != &gc_guardian_type) {
+    mesche_vm_raise_error(vm, "Expected a guardian.");
+    return NULL;
+  }
+
+  return (GCGuardian *)AS_POINTER(value)->ptr;
+}
+
+Value gc_make_guardian_msc(VM *vm, int arg_count, Value *args) {
+  if (arg_count != 0) {
+    PANIC("Function accepts no parameters.");
+  }
+
+  GCGuardian *guardian = calloc(1, sizeof(GCGuardian));
+  if (guardian == NULL) {
+    PANIC("Guardian could not be allocated.");
+  }
+
+  ObjectPointer *pointer = mesche_object_make_pointer_type(vm, guardian, &gc_guardian_type);
+  guardian->object = (Object *)pointer;
+  guardian->next = vm->guardians;
+  vm->guardians = guardian;
+
+  return OBJECT_VAL(pointer);
+}
+
+Value gc_guardian_register_msc(VM *vm, int arg_count, Value *args) {
+  if (arg_count != 2) {
+    PANIC("Function requires 2 parameters.");
+  }
+
+  GCGuardian *guardian = gc_expect_guardian(vm, args[0]);
+  if (guardian == NULL) {
+    return FALSE_VAL;
+  }
+
+  // Values that aren't objects are never collected
+  if (IS_OBJECT(args[1])) {
+    gc_guardian_push(&guardian->pending, &guardian->pending_count, &guardian->pending_capacity,
+                     AS_OBJECT(args[1]));
+  }
+
+  return args[1];
+}
+
+Value gc_guardian_poll_msc(VM *vm, int arg_count, Value *args) {
+  if (arg_count != 1) {
+    PANIC("Function requires 1 parameter.");
+  }
+
+  // Returns the object that became unreachable first, or #f if there is none
+  GCGuardian *guardian = gc_expect_guardian(vm, args[0]);
+  if (guardian == NULL || guardian->ready_count == 0) {
+    return FALSE_VAL;
+  }
+
+  Object *object = guardian->ready[0];
+  guardian->ready_count--;
+  memmove(guardian->ready, guardian->ready + 1, sizeof(Object *) * guardian->ready_count);
+
+  return OBJECT_VAL(object);
+}
+
+Value gc_run_finalizers_msc(VM *vm, int arg_count, Value *args) {
+  if (arg_count != 0) {
+    PANIC("Function accepts no parameters.");
+  }
+
+  return FIXNUM_VAL(mesche_gc_run_finalizers(vm, -1));
+}
+
+void mesche_gc_module_init(VM *vm) {
+  mesche_vm_define_native_funcs(
+      vm, "mesche gc",
+      (MescheNativeFuncDetails[]){{"gc-stats", gc_stats_msc, true},
+                                  {"gc-collect", gc_collect_msc, true},
+                                  {"gc-heap-target-set!", gc_heap_target_set_msc, true},
+                                  {"gc-cpu-percent-set!", gc_cpu_percent_set_msc, true},
+                                  {"gc-heap-limit-set!", gc_heap_limit_set_msc, true},
+                                  {"gc-run-finalizers", gc_run_finalizers_msc, true},
+                                  {"make-guardian", gc_make_guardian_msc, true},
+                                  {"guardian-register!", gc_guardian_register_msc, true},
+                                  {"guardian-poll", gc_guardian_poll_msc, true},
+                                  {"arena-begin", gc_arena_begin_msc, true},
+                                  {"arena-end", gc_arena_end_msc, true},
+                                  {NULL, NULL, false}});
 }
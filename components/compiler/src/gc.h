@@ -7,7 +7,82 @@
 typedef void (*ObjectFreePtr)(MescheMemory *mem, void *object);
 typedef void (*ObjectMarkFuncPtr)(MescheMemory *mem, Object *object);
 
+// The most threads that mark objects in parallel, including the thread that
+// collects garbage.  One thread is used per online CPU up to this limit unless
+// the VM's `gc_marker_count` asks for a number of them.
+#define GC_MAX_MARKERS 8
+
+// Heaps smaller than this are marked on one thread by default since waking up
+// the other markers would take longer than marking the heap
+#define GC_PARALLEL_MIN_HEAP (4 * 1024 * 1024)
+
+// The number of pending finalizers that run at once between calls
+#define GC_FINALIZER_BATCH_SIZE 16
+
+// Releases a native resource of an object that has been collected.  Runs
+// after the collection finishes so it can't touch any managed objects.
+typedef struct GCFinalizer {
+  ObjectFreePtr finalize_func;
+  void *data;
+} GCFinalizer;
+
+// An arena scope allocates its objects from pages of its own so that they can
+// be collected without tracing the rest of the heap when it ends.  Objects
+// from outside of the scope that are written to while it's open might refer
+// to the arena's objects, so the write barrier records them here.
+typedef struct GCArena {
+  Object **escapes;
+  int escape_count;
+  int escape_capacity;
+} GCArena;
+
+// Called for every object that is visited by `mesche_gc_visit_roots` or
+// `mesche_gc_visit_references` instead of marking it
+typedef void (*GCVisitFunc)(Object *object, void *context);
+
+// The number of objects of each kind and the heap bytes they take up
+typedef struct MescheObjectStats {
+  size_t object_counts[OBJECT_KIND_COUNT];
+  size_t object_bytes[OBJECT_KIND_COUNT];
+} MescheObjectStats;
+
 void mesche_gc_mark_object(VM *vm, Object *object);
+void mesche_gc_remember(VM *vm, Object *object);
 void mesche_gc_collect_garbage(MescheMemory *mem);
+bool mesche_gc_collect_garbage_slice(MescheMemory *mem);
+bool mesche_gc_step(VM *vm, long budget_usec);
+void mesche_gc_free_objects(VM *vm);
+void mesche_gc_object_stats(VM *vm, MescheObjectStats *stats);
+void mesche_gc_visit_roots(VM *vm, GCVisitFunc visit_func, void *context);
+void mesche_gc_visit_references(VM *vm, Object *object, GCVisitFunc visit_func, void *context);
+void mesche_gc_defer_finalizer(VM *vm, ObjectFreePtr finalize_func, void *data);
+int mesche_gc_run_finalizers(VM *vm, int max_count);
+bool mesche_gc_arena_begin(VM *vm);
+void mesche_gc_arena_end(VM *vm);
+void mesche_gc_arena_abandon(VM *vm);
+void mesche_gc_arena_escape(VM *vm, Object *object);
+void mesche_gc_module_init(VM *vm);
+
+// Must be called after a reference is stored into an object that might have
+// been marked already.  When garbage is collected generationally, an old
+// object that is written to is remembered so that the next minor collection
+// traces the young objects it now refers to.  When garbage is collected
+// incrementally, an object that was already traced is remembered so that it
+// gets traced again before the cycle's marking finishes.  While an arena
+// scope is open, objects from outside of it that are written to are recorded
+// so that the arena's objects they now refer to survive when it ends.
+static inline void mesche_gc_write_barrier(VM *vm, Object *object) {
+#if defined(MESCHE_GENERATIONAL_GC) || defined(MESCHE_INCREMENTAL_GC)
+  if (mesche_heap_is_marked(object) && !object->is_remembered) {
+    mesche_gc_remember(vm, object);
+  }
+#endif
+
+  MescheHeap *heap = &((MescheMemory *)vm)->heap;
+  if (heap->arena_depth > 0 && HEAP_PAGE_OF(object)->arena_depth < heap->arena_depth &&
+      !object->is_escaped) {
+    mesche_gc_arena_escape(vm, object);
+  }
+}
 
 #endif
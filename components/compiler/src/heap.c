@@ -0,0 +1,539 @@
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "heap.h"
+#include "mem.h"
+#include "util.h"
+
+// Free cells are poisoned in sanitizer builds so that objects which are used
+// after being collected are still caught even though their memory is reused
+#ifdef __SANITIZE_ADDRESS__
+#include <sanitizer/asan_interface.h>
+#define HEAP_POISON(cell, size) ASAN_POISON_MEMORY_REGION(cell, size)
+#define HEAP_UNPOISON(cell, size) ASAN_UNPOISON_MEMORY_REGION(cell, size)
+#else
+#define HEAP_POISON(cell, size)
+#define HEAP_UNPOISON(cell, size)
+#endif
+
+// Cells start after the page header, rounded up to keep them 16-byte aligned
+#define HEAP_CELLS_OFFSET ((sizeof(HeapPage) + 15) & ~(size_t)15)
+
+static const uint32_t heap_size_classes[HEAP_SIZE_CLASS_COUNT] = {
+    16,  24,  32,  40,  48,  56,  64,  80,   96,   112,  128,  160,  192,  224,
+    256, 320, 384, 448, 512, 640, 768, 1024, 1280, 1536, 2048, 2560, 3072, 4096};
+
+static size_t heap_granule_count(size_t size) {
+  return (size + HEAP_GRANULE_SIZE - 1) / HEAP_GRANULE_SIZE;
+}
+
+void mesche_heap_init(MescheHeap *heap) {
+  memset(heap, 0, sizeof(MescheHeap));
+
+  // Precompute the smallest size class that fits each object size
+  int size_class = 0;
+  for (size_t granules = 0; granules <= HEAP_LARGE_OBJECT_SIZE / HEAP_GRANULE_SIZE; granules++) {
+    while (heap_size_classes[size_class] < granules * HEAP_GRANULE_SIZE) {
+      size_class++;
+    }
+
+    heap->size_classes[granules] = size_class;
+  }
+}
+
+size_t mesche_heap_cell_size(MescheHeap *heap, size_t size) {
+  if (size > HEAP_LARGE_OBJECT_SIZE) {
+    return heap_granule_count(size) * HEAP_GRANULE_SIZE;
+  }
+
+  return heap_size_classes[heap->size_classes[heap_granule_count(size)]];
+}
+
+static void *heap_map(size_t size) {
+  // Map an extra page worth of space so that the start can be aligned to the
+  // heap page size, then give back the unaligned ends
+  size_t mapped_size = size + HEAP_PAGE_SIZE;
+  uint8_t *memory =
+      mmap(NULL, mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (memory == MAP_FAILED) {
+    PANIC("Heap page mapping failed!\n");
+  }
+
+  uint8_t *start =
+      (uint8_t *)(((uintptr_t)memory + HEAP_PAGE_SIZE - 1) & ~(uintptr_t)(HEAP_PAGE_SIZE - 1));
+  if (start > memory) {
+    munmap(memory, start - memory);
+  }
+
+  size_t tail_size = (memory + mapped_size) - (start + size);
+  if (tail_size > 0) {
+    munmap(start + size, tail_size);
+  }
+
+  return start;
+}
+
+static inline bool heap_bit_test(uint64_t *bits, size_t granule) {
+  return (bits[granule / 64] >> (granule % 64)) & 1;
+}
+
+static void heap_page_build_free_list(HeapPage *page) {
+  // Thread the free list through every unallocated cell in address order
+  void **link = &page->free_list;
+  uint8_t *cells = (uint8_t *)page + HEAP_CELLS_OFFSET;
+  for (uint32_t i = 0; i < page->cell_count; i++) {
+    uint8_t *cell = cells + i * page->cell_size;
+    if (!heap_bit_test(page->allocated_bits, HEAP_GRANULE_OF(cell))) {
+      HEAP_UNPOISON(cell, sizeof(void *));
+      *link = cell;
+      link = (void **)cell;
+    }
+  }
+
+  *link = NULL;
+}
+
+static HeapPage *heap_page_create(MescheHeap *heap, int size_class) {
+  // Reuse an empty page before mapping a new one
+  HeapPage *page = heap->empty_pages;
+  if (page != NULL) {
+    heap->empty_pages = page->next;
+    heap->empty_page_count--;
+    memset(page->allocated_bits, 0, sizeof(page->allocated_bits));
+    memset(page->mark_bits, 0, sizeof(page->mark_bits));
+  } else {
+    page = heap_map(HEAP_PAGE_SIZE);
+  }
+
+  page->next = NULL;
+  page->mapped_size = HEAP_PAGE_SIZE;
+  page->cell_size = heap_size_classes[size_class];
+  page->cell_count = (HEAP_PAGE_SIZE - HEAP_CELLS_OFFSET) / page->cell_size;
+  page->live_count = 0;
+  page->size_class = size_class;
+  page->is_large = false;
+  page->needs_sweep = false;
+  page->arena_depth = heap->arena_depth;
+
+  HEAP_POISON((uint8_t *)page + HEAP_CELLS_OFFSET, HEAP_PAGE_SIZE - HEAP_CELLS_OFFSET);
+  heap_page_build_free_list(page);
+
+  // Add the page to the end of its size class so that allocation, which only
+  // moves forward through the list, never revisits pages that filled up
+  if (heap->last_pages[size_class] != NULL) {
+    heap->last_pages[size_class]->next = page;
+  } else {
+    heap->pages[size_class] = page;
+  }
+  heap->last_pages[size_class] = page;
+  heap->page_count++;
+
+  return page;
+}
+
+static void *heap_allocate_large(MescheHeap *heap, size_t size) {
+  size_t os_page_size = (size_t)sysconf(_SC_PAGESIZE);
+  size_t mapped_size = (HEAP_CELLS_OFFSET + size + os_page_size - 1) & ~(os_page_size - 1);
+
+  HeapPage *page = heap_map(mapped_size);
+  page->mapped_size = mapped_size;
+  page->cell_size = mesche_heap_cell_size(heap, size);
+  page->cell_count = 1;
+  page->live_count = 1;
+  page->is_large = true;
+  page->arena_depth = heap->arena_depth;
+
+  uint8_t *cell = (uint8_t *)page + HEAP_CELLS_OFFSET;
+  size_t granule = HEAP_GRANULE_OF(cell);
+  page->allocated_bits[granule / 64] |= (uint64_t)1 << (granule % 64);
+
+  page->next = heap->large_pages;
+  heap->large_pages = page;
+  heap->large_page_count++;
+
+  return cell;
+}
+
+static bool heap_page_sweep(MescheMemory *mem, HeapPage *page, bool keep_marks,
+                            HeapFreeFunc free_func);
+
+static void heap_page_sweep_lazily(MescheMemory *mem, HeapPage *page) {
+  if (heap_page_sweep(mem, page, false, mem->heap.lazy_free_func)) {
+    heap_page_build_free_list(page);
+  }
+
+  page->needs_sweep = false;
+  mem->heap.unswept_page_count--;
+}
+
+// Allocates a cell for an object of the given size.  The caller is expected to
+// have accounted for the cell's size with `mesche_mem_reserve` already, so
+// garbage is never collected here, though unswept pages are swept as
+// allocation reaches them.
+void *mesche_heap_allocate(MescheMemory *mem, size_t size) {
+  MescheHeap *heap = &mem->heap;
+  if (size > HEAP_LARGE_OBJECT_SIZE) {
+    return heap_allocate_large(heap, size);
+  }
+
+  // Take a cell from the first page of the current arena scope with free
+  // cells at or after the current page, adding a new page once the size class
+  // is full
+  int size_class = heap->size_classes[heap_granule_count(size)];
+  HeapPage *page = heap->current_pages[size_class];
+  while (page != NULL) {
+    if (page->arena_depth == heap->arena_depth) {
+      if (page->needs_sweep) {
+        heap_page_sweep_lazily(mem, page);
+      }
+
+      if (page->free_list != NULL) {
+        break;
+      }
+    }
+
+    page = page->next;
+  }
+
+  if (page == NULL) {
+    page = heap_page_create(heap, size_class);
+  }
+  heap->current_pages[size_class] = page;
+
+  void *cell = page->free_list;
+  HEAP_UNPOISON(cell, page->cell_size);
+  page->free_list = *(void **)cell;
+
+  size_t granule = HEAP_GRANULE_OF(cell);
+  page->allocated_bits[granule / 64] |= (uint64_t)1 << (granule % 64);
+  page->live_count++;
+
+  return cell;
+}
+
+// Releases a cell.  The cell rejoins its page's free list (or its page is
+// unmapped if it's a large object) the next time the page is swept.
+void mesche_heap_free(MescheMemory *mem, void *cell) {
+  HeapPage *page = HEAP_PAGE_OF(cell);
+  size_t granule = HEAP_GRANULE_OF(cell);
+  uint64_t bit = (uint64_t)1 << (granule % 64);
+  page->allocated_bits[granule / 64] &= ~bit;
+  page->mark_bits[granule / 64] &= ~bit;
+  page->live_count--;
+  mem->bytes_allocated -= page->cell_size;
+
+  if (!page->is_large) {
+    HEAP_POISON(cell, page->cell_size);
+  }
+}
+
+void mesche_heap_clear_marks(MescheHeap *heap) {
+  for (int i = 0; i < HEAP_SIZE_CLASS_COUNT; i++) {
+    for (HeapPage *page = heap->pages[i]; page != NULL; page = page->next) {
+      memset(page->mark_bits, 0, sizeof(page->mark_bits));
+    }
+  }
+
+  for (HeapPage *page = heap->large_pages; page != NULL; page = page->next) {
+    memset(page->mark_bits, 0, sizeof(page->mark_bits));
+  }
+}
+
+static bool heap_page_sweep(MescheMemory *mem, HeapPage *page, bool keep_marks,
+                            HeapFreeFunc free_func) {
+  // Every allocated cell without a mark bit is garbage
+  bool freed = false;
+  for (int i = 0; i < HEAP_BITMAP_WORDS; i++) {
+    uint64_t dead = page->allocated_bits[i] & ~page->mark_bits[i];
+    if (!keep_marks) {
+      page->mark_bits[i] = 0;
+    }
+
+    freed |= dead != 0;
+    while (dead != 0) {
+      int bit = __builtin_ctzll(dead);
+      dead &= dead - 1;
+      free_func(mem, (uint8_t *)page + (i * 64 + bit) * HEAP_GRANULE_SIZE);
+    }
+  }
+
+  return freed;
+}
+
+static void heap_release_empty_pages(MescheHeap *heap, size_t retained_count) {
+  while (heap->empty_page_count > retained_count) {
+    HeapPage *page = heap->empty_pages;
+    heap->empty_pages = page->next;
+    heap->empty_page_count--;
+
+    HEAP_UNPOISON(page, page->mapped_size);
+    munmap(page, page->mapped_size);
+  }
+}
+
+static void heap_collect_empty_pages(MescheHeap *heap) {
+  for (int i = 0; i < HEAP_SIZE_CLASS_COUNT; i++) {
+    HeapPage *previous = NULL;
+    HeapPage *page = heap->pages[i];
+    while (page != NULL) {
+      HeapPage *next = page->next;
+      if (page->live_count == 0) {
+        if (previous != NULL) {
+          previous->next = next;
+        } else {
+          heap->pages[i] = next;
+        }
+
+        page->next = heap->empty_pages;
+        heap->empty_pages = page;
+        heap->empty_page_count++;
+        heap->page_count--;
+      } else {
+        previous = page;
+      }
+
+      page = next;
+    }
+
+    // Allocation starts over from the first page of the size class
+    heap->last_pages[i] = previous;
+    heap->current_pages[i] = heap->pages[i];
+  }
+
+  // Keep enough empty pages to let the heap grow back to twice its current
+  // size without mapping more, and return the rest to the OS
+  heap_release_empty_pages(heap, heap->page_count > HEAP_MIN_EMPTY_PAGES ? heap->page_count
+                                                                        : HEAP_MIN_EMPTY_PAGES);
+}
+
+// Sweeps the large pages that belong to arena scopes at least `arena_depth`
+// deep, which is all of them when it's 0
+static void heap_sweep_large_pages(MescheMemory *mem, bool keep_marks, HeapFreeFunc free_func,
+                                   int arena_depth) {
+  MescheHeap *heap = &mem->heap;
+  HeapPage *previous = NULL;
+  HeapPage *page = heap->large_pages;
+  while (page != NULL) {
+    HeapPage *next = page->next;
+    if (page->arena_depth >= arena_depth) {
+      heap_page_sweep(mem, page, keep_marks, free_func);
+    }
+
+    if (page->live_count == 0) {
+      if (previous != NULL) {
+        previous->next = next;
+      } else {
+        heap->large_pages = next;
+      }
+
+      munmap(page, page->mapped_size);
+      heap->large_page_count--;
+    } else {
+      previous = page;
+    }
+
+    page = next;
+  }
+}
+
+// Frees every allocated cell that isn't marked and rebuilds the free lists of
+// the pages that still hold live cells.  Pages that end up empty are kept for
+// reuse or returned to the OS.  Marks are cleared along the way unless
+// `keep_marks` is set.
+void mesche_heap_sweep(MescheMemory *mem, bool keep_marks, HeapFreeFunc free_func) {
+  MescheHeap *heap = &mem->heap;
+
+  for (int i = 0; i < HEAP_SIZE_CLASS_COUNT; i++) {
+    for (HeapPage *page = heap->pages[i]; page != NULL; page = page->next) {
+      // The free list is still intact if none of the page's cells were freed
+      if (heap_page_sweep(mem, page, keep_marks, free_func)) {
+        heap_page_build_free_list(page);
+      }
+
+      page->needs_sweep = false;
+    }
+  }
+
+  heap->unswept_page_count = 0;
+  heap->sweep_page = NULL;
+
+  heap_collect_empty_pages(heap);
+  heap_sweep_large_pages(mem, keep_marks, free_func, 0);
+}
+
+// Starts sweeping the heap without sweeping any of its small pages yet.  Each
+// page is swept when allocation reaches it or when `mesche_heap_sweep_step`
+// does, so new objects must only be allocated unmarked until the sweep is
+// done.  Large objects are swept straight away.
+void mesche_heap_sweep_lazily(MescheMemory *mem, HeapFreeFunc free_func) {
+  MescheHeap *heap = &mem->heap;
+
+  for (int i = 0; i < HEAP_SIZE_CLASS_COUNT; i++) {
+    for (HeapPage *page = heap->pages[i]; page != NULL; page = page->next) {
+      page->needs_sweep = true;
+    }
+
+    heap->current_pages[i] = heap->pages[i];
+  }
+
+  heap->unswept_page_count = heap->page_count;
+  heap->sweep_size_class = 0;
+  heap->sweep_page = heap->pages[0];
+  heap->lazy_free_func = free_func;
+
+  heap_sweep_large_pages(mem, false, free_func, 0);
+}
+
+// Sweeps up to `page_budget` of the pages that are still waiting to be swept
+// lazily.  Returns true once every page has been swept.
+bool mesche_heap_sweep_step(MescheMemory *mem, int page_budget) {
+  MescheHeap *heap = &mem->heap;
+
+  // Pages are visited in the same order that allocation sweeps them, so the
+  // cursor never needs to move backwards
+  while (heap->unswept_page_count > 0 && page_budget > 0) {
+    if (heap->sweep_page == NULL) {
+      if (++heap->sweep_size_class == HEAP_SIZE_CLASS_COUNT) {
+        PANIC("Heap has %zu unswept pages but none are left to sweep.", heap->unswept_page_count);
+      }
+
+      heap->sweep_page = heap->pages[heap->sweep_size_class];
+      continue;
+    }
+
+    if (heap->sweep_page->needs_sweep) {
+      heap_page_sweep_lazily(mem, heap->sweep_page);
+      page_budget--;
+    }
+
+    heap->sweep_page = heap->sweep_page->next;
+  }
+
+  if (heap->unswept_page_count > 0) {
+    return false;
+  }
+
+  // Pages can only be removed from their size class once none of them are
+  // waiting to be swept
+  heap->sweep_page = NULL;
+  heap_collect_empty_pages(heap);
+
+  return true;
+}
+
+static void heap_page_walk(HeapPage *page, HeapWalkFunc walk_func, void *context) {
+  for (int i = 0; i < HEAP_BITMAP_WORDS; i++) {
+    // Cells in pages that still need to be swept are only live if marked
+    uint64_t live = page->allocated_bits[i];
+    if (page->needs_sweep) {
+      live &= page->mark_bits[i];
+    }
+
+    while (live != 0) {
+      int bit = __builtin_ctzll(live);
+      live &= live - 1;
+      walk_func((uint8_t *)page + (i * 64 + bit) * HEAP_GRANULE_SIZE, page->cell_size, context);
+    }
+  }
+}
+
+// Calls `walk_func` for every allocated cell, skipping the garbage left in
+// pages that haven't been swept yet.  The function must not allocate.
+void mesche_heap_walk(MescheHeap *heap, HeapWalkFunc walk_func, void *context) {
+  for (int i = 0; i < HEAP_SIZE_CLASS_COUNT; i++) {
+    for (HeapPage *page = heap->pages[i]; page != NULL; page = page->next) {
+      heap_page_walk(page, walk_func, context);
+    }
+  }
+
+  for (HeapPage *page = heap->large_pages; page != NULL; page = page->next) {
+    heap_page_walk(page, walk_func, context);
+  }
+}
+
+// Starts allocating objects from fresh pages that belong to a new arena scope.
+// Returns false if arena scopes are already nested as deep as they can be.
+bool mesche_heap_arena_begin(MescheHeap *heap) {
+  if (heap->arena_depth == HEAP_MAX_ARENA_DEPTH) {
+    return false;
+  }
+
+  heap->arena_depth++;
+  for (int i = 0; i < HEAP_SIZE_CLASS_COUNT; i++) {
+    heap->current_pages[i] = NULL;
+  }
+
+  return true;
+}
+
+static void heap_arena_clear_page_marks(HeapPage *page, int arena_depth) {
+  for (; page != NULL; page = page->next) {
+    if (page->arena_depth == arena_depth) {
+      memset(page->mark_bits, 0, sizeof(page->mark_bits));
+    }
+  }
+}
+
+// Clears the marks of the innermost arena's objects so that the objects that
+// were promoted while it was open can be collected with the rest of them
+void mesche_heap_arena_clear_marks(MescheHeap *heap) {
+  for (int i = 0; i < HEAP_SIZE_CLASS_COUNT; i++) {
+    heap_arena_clear_page_marks(heap->pages[i], heap->arena_depth);
+  }
+
+  heap_arena_clear_page_marks(heap->large_pages, heap->arena_depth);
+}
+
+// Frees the unmarked cells of the innermost arena scope's pages and gives the
+// pages to the enclosing scope, or back to the heap if there isn't one.  The
+// heap must not be waiting to be swept lazily.
+void mesche_heap_arena_end(MescheMemory *mem, bool keep_marks, HeapFreeFunc free_func) {
+  MescheHeap *heap = &mem->heap;
+  for (int i = 0; i < HEAP_SIZE_CLASS_COUNT; i++) {
+    for (HeapPage *page = heap->pages[i]; page != NULL; page = page->next) {
+      if (page->arena_depth == heap->arena_depth) {
+        if (heap_page_sweep(mem, page, keep_marks, free_func)) {
+          heap_page_build_free_list(page);
+        }
+
+        page->arena_depth--;
+      }
+    }
+  }
+
+  heap_sweep_large_pages(mem, keep_marks, free_func, heap->arena_depth);
+  for (HeapPage *page = heap->large_pages; page != NULL; page = page->next) {
+    if (page->arena_depth == heap->arena_depth) {
+      page->arena_depth--;
+    }
+  }
+
+  heap->arena_depth--;
+  heap_collect_empty_pages(heap);
+}
+
+// Gives the pages of every open arena scope back to the heap without
+// collecting anything
+void mesche_heap_arena_abandon(MescheHeap *heap) {
+  for (int i = 0; i < HEAP_SIZE_CLASS_COUNT; i++) {
+    for (HeapPage *page = heap->pages[i]; page != NULL; page = page->next) {
+      page->arena_depth = 0;
+    }
+
+    heap->current_pages[i] = heap->pages[i];
+  }
+
+  for (HeapPage *page = heap->large_pages; page != NULL; page = page->next) {
+    page->arena_depth = 0;
+  }
+
+  heap->arena_depth = 0;
+}
+
+void mesche_heap_free_all(MescheMemory *mem, HeapFreeFunc free_func) {
+  mesche_heap_clear_marks(&mem->heap);
+  mesche_heap_sweep(mem, false, free_func);
+  heap_release_empty_pages(&mem->heap, 0);
+}
@@ -0,0 +1,127 @@
+#ifndef mesche_heap_h
+#define mesche_heap_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Objects are allocated from pages that are aligned to the page size so that
+// the page holding an object can be found by masking the object's address.
+// Each page is split into cells of a single size class and tracks which cells
+// are allocated and which are marked in side bitmaps with one bit per 8-byte
+// granule.  Objects bigger than the largest size class get a page of their own
+// that is mapped directly from the OS.
+#define HEAP_PAGE_SIZE (64 * 1024)
+#define HEAP_GRANULE_SIZE 8
+#define HEAP_BITMAP_WORDS (HEAP_PAGE_SIZE / HEAP_GRANULE_SIZE / 64)
+#define HEAP_LARGE_OBJECT_SIZE 4096
+#define HEAP_SIZE_CLASS_COUNT 28
+
+// The minimum number of empty pages that are kept around for reuse rather
+// than being returned to the OS
+#define HEAP_MIN_EMPTY_PAGES 16
+
+// Arena scopes can be nested this deep
+#define HEAP_MAX_ARENA_DEPTH 255
+
+#define HEAP_PAGE_OF(cell) ((HeapPage *)((uintptr_t)(cell) & ~(uintptr_t)(HEAP_PAGE_SIZE - 1)))
+#define HEAP_GRANULE_OF(cell) (((uintptr_t)(cell) & (HEAP_PAGE_SIZE - 1)) / HEAP_GRANULE_SIZE)
+
+struct MescheMemory;
+
+// Called by the sweeper for every cell that is being reclaimed.  The function
+// must release the cell with `mesche_heap_free`.
+typedef void (*HeapFreeFunc)(struct MescheMemory *mem, void *cell);
+
+// Called by `mesche_heap_walk` for every cell that holds an object
+typedef void (*HeapWalkFunc)(void *cell, size_t cell_size, void *context);
+
+typedef struct HeapPage {
+  struct HeapPage *next;
+  void *free_list;
+  size_t mapped_size;
+  uint32_t cell_size;
+  uint32_t cell_count;
+  uint32_t live_count;
+  uint8_t size_class;
+  bool is_large;
+  bool needs_sweep;
+
+  // The depth of the arena scope that the page belongs to, 0 if none
+  uint8_t arena_depth;
+  uint64_t allocated_bits[HEAP_BITMAP_WORDS];
+  uint64_t mark_bits[HEAP_BITMAP_WORDS];
+} HeapPage;
+
+typedef struct MescheHeap {
+  // The pages of each size class in the order they were added, along with
+  // the page that allocation currently takes cells from
+  HeapPage *pages[HEAP_SIZE_CLASS_COUNT];
+  HeapPage *last_pages[HEAP_SIZE_CLASS_COUNT];
+  HeapPage *current_pages[HEAP_SIZE_CLASS_COUNT];
+  HeapPage *large_pages;
+  size_t page_count;
+  size_t large_page_count;
+
+  // Empty pages that can be given to any size class
+  HeapPage *empty_pages;
+  size_t empty_page_count;
+
+  // Pages that still need to be swept when sweeping lazily, which happens as
+  // allocation reaches them or in steps through `mesche_heap_sweep_step`
+  size_t unswept_page_count;
+  int sweep_size_class;
+  HeapPage *sweep_page;
+  HeapFreeFunc lazy_free_func;
+
+  // While arena scopes are open, objects are only allocated from pages of the
+  // innermost one so that they can be swept separately when it ends
+  int arena_depth;
+  bool is_collecting_arena;
+
+  // Maps an object size in granules to its size class
+  uint8_t size_classes[HEAP_LARGE_OBJECT_SIZE / HEAP_GRANULE_SIZE + 1];
+} MescheHeap;
+
+void mesche_heap_init(MescheHeap *heap);
+size_t mesche_heap_cell_size(MescheHeap *heap, size_t size);
+void *mesche_heap_allocate(struct MescheMemory *mem, size_t size);
+void mesche_heap_free(struct MescheMemory *mem, void *cell);
+void mesche_heap_clear_marks(MescheHeap *heap);
+void mesche_heap_sweep(struct MescheMemory *mem, bool keep_marks, HeapFreeFunc free_func);
+void mesche_heap_sweep_lazily(struct MescheMemory *mem, HeapFreeFunc free_func);
+bool mesche_heap_sweep_step(struct MescheMemory *mem, int page_budget);
+void mesche_heap_free_all(struct MescheMemory *mem, HeapFreeFunc free_func);
+void mesche_heap_walk(MescheHeap *heap, HeapWalkFunc walk_func, void *context);
+bool mesche_heap_arena_begin(MescheHeap *heap);
+void mesche_heap_arena_clear_marks(MescheHeap *heap);
+void mesche_heap_arena_end(struct MescheMemory *mem, bool keep_marks, HeapFreeFunc free_func);
+void mesche_heap_arena_abandon(MescheHeap *heap);
+
+static inline bool mesche_heap_is_marked(void *cell) {
+  size_t granule = HEAP_GRANULE_OF(cell);
+  return (HEAP_PAGE_OF(cell)->mark_bits[granule / 64] >> (granule % 64)) & 1;
+}
+
+static inline void mesche_heap_set_marked(void *cell) {
+  size_t granule = HEAP_GRANULE_OF(cell);
+  HEAP_PAGE_OF(cell)->mark_bits[granule / 64] |= (uint64_t)1 << (granule % 64);
+}
+
+// Whether a cell survives the collection whose marking just finished.  When
+// an arena scope is being collected only the cells in its pages can die.
+static inline bool mesche_heap_is_live(MescheHeap *heap, void *cell) {
+  return mesche_heap_is_marked(cell) ||
+         (heap->is_collecting_arena && HEAP_PAGE_OF(cell)->arena_depth < heap->arena_depth);
+}
+
+// Sets the cell's mark bit atomically, returning true if it wasn't set yet
+static inline bool mesche_heap_try_mark(void *cell) {
+  size_t granule = HEAP_GRANULE_OF(cell);
+  uint64_t bit = (uint64_t)1 << (granule % 64);
+  return !(__atomic_fetch_or(&HEAP_PAGE_OF(cell)->mark_bits[granule / 64], bit,
+                             __ATOMIC_RELAXED) &
+           bit);
+}
+
+#endif
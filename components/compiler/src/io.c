@@ -127,9 +127,17 @@ Value mesche_port_close(VM *vm, MeschePort *port) {
   return FALSE_VAL;
 }
 
+static void port_close_file(MescheMemory *mem, void *fp) { fclose((FILE *)fp); }
+
 void mesche_free_port(VM *vm, MeschePort *port) {
-  // First, close the port if it's already open
-  mesche_port_close(vm, port);
+  // Closing a file can block while its buffer is flushed, so a file that's
+  // still open is closed after the collection finishes
+  if (port->data_kind == MeschePortDataKindFile && port->can_close && !port->is_closed &&
+      port->data.file.fp != NULL) {
+    mesche_gc_defer_finalizer(vm, port_close_file, port->data.file.fp);
+    port->data.file.fp = NULL;
+    port->is_closed = true;
+  }
 
   if (port->data_kind == MeschePortDataKindString) {
     // Deallocate the string buffer
@@ -138,7 +146,7 @@ void mesche_free_port(VM *vm, MeschePort *port) {
     port->data.string.index = 0;
   }
 
-  FREE(vm, MeschePort, port);
+  FREE_OBJECT(vm, port);
 }
 
 static void string_port_write_char(MeschePort *port, char c) {
@@ -30,5 +30,5 @@ ObjectKeyword *mesche_object_make_keyword(VM *vm, const char *chars, int length)
 }
 
 void mesche_free_keyword(VM *vm, ObjectKeyword *keyword) {
-  FREE_SIZE(vm, keyword, (sizeof(ObjectKeyword) + keyword->string.length + 1));
+  FREE_OBJECT(vm, keyword);
 }
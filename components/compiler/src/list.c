@@ -26,7 +26,7 @@ Value list_nth_msc(VM *vm, int arg_count, Value *args) {
     PANIC("Function requires 2 parameters.");
   }
 
-  return mesche_list_nth(vm, AS_CONS(args[0]), (int)AS_NUMBER(args[1]));
+  return mesche_list_nth(vm, AS_CONS(args[0]), (int)AS_INTEGER(args[1]));
 }
 
 void mesche_list_module_init(VM *vm) {
@@ -1,3 +1,4 @@
+#include <errno.h>
 #include <math.h>
 #include <stdlib.h>
 #include <time.h>
@@ -7,8 +8,26 @@
 #include "object.h"
 #include "util.h"
 
+Value mesche_number_from_string(const char *chars) {
+  // Integer literals become fixnums as long as they fit, anything with a
+  // fraction or exponent is read as a double
+  char *end = NULL;
+  errno = 0;
+  long long integer = strtoll(chars, &end, 10);
+  if (end != chars && errno == 0 && *end != '.' && *end != 'e' && *end != 'E' &&
+      FIXNUM_FITS(integer)) {
+    return FIXNUM_VAL(integer);
+  }
+
+  return NUMBER_VAL(strtod(chars, NULL));
+}
+
 Value math_floor_msc(VM *vm, int arg_count, Value *args) {
   // TODO: Add type check
+  if (IS_FIXNUM(args[0])) {
+    return args[0];
+  }
+
   return NUMBER_VAL(floor(AS_NUMBER(args[0])));
 }
 
@@ -18,7 +37,7 @@ Value math_rand_int_msc(VM *vm, int arg_count, Value *args) {
   }
 
   // TODO: Add type check
-  return NUMBER_VAL(rand() % (int)AS_NUMBER(args[0]));
+  return FIXNUM_VAL(rand() % (int)AS_INTEGER(args[0]));
 }
 
 Value math_sin_msc(VM *vm, int arg_count, Value *args) {
@@ -36,6 +55,12 @@ Value math_abs_msc(VM *vm, int arg_count, Value *args) {
   }
 
   // TODO: Add type checks
+  if (IS_FIXNUM(args[0])) {
+    // The magnitude of the smallest fixnum is one more than the largest
+    int64_t magnitude = llabs(AS_FIXNUM(args[0]));
+    return FIXNUM_FITS(magnitude) ? FIXNUM_VAL(magnitude) : NUMBER_VAL((double)magnitude);
+  }
+
   return NUMBER_VAL(fabs(AS_NUMBER(args[0])));
 }
 
@@ -45,6 +70,10 @@ Value math_min_msc(VM *vm, int arg_count, Value *args) {
   }
 
   // TODO: Add type checks
+  if (IS_FIXNUM(args[0]) && IS_FIXNUM(args[1])) {
+    return AS_FIXNUM(args[0]) < AS_FIXNUM(args[1]) ? args[0] : args[1];
+  }
+
   return NUMBER_VAL(fmin(AS_NUMBER(args[0]), AS_NUMBER(args[1])));
 }
 
@@ -54,6 +83,10 @@ Value math_max_msc(VM *vm, int arg_count, Value *args) {
   }
 
   // TODO: Add type checks
+  if (IS_FIXNUM(args[0]) && IS_FIXNUM(args[1])) {
+    return AS_FIXNUM(args[0]) > AS_FIXNUM(args[1]) ? args[0] : args[1];
+  }
+
   return NUMBER_VAL(fmax(AS_NUMBER(args[0]), AS_NUMBER(args[1])));
 }
 
@@ -72,6 +105,29 @@ Value math_expt_msc(VM *vm, int arg_count, Value *args) {
   }
 
   // TODO: Add type checks
+  if (IS_FIXNUM(args[0]) && IS_FIXNUM(args[1]) && AS_FIXNUM(args[1]) >= 0) {
+    // Exponentiation by squaring, falling back to pow() if the result
+    // doesn't fit in a fixnum
+    int64_t base = AS_FIXNUM(args[0]);
+    int64_t exponent = AS_FIXNUM(args[1]);
+    int64_t result = 1;
+    bool fits = true;
+    while (exponent > 0 && fits) {
+      if (exponent & 1) {
+        fits = !__builtin_mul_overflow(result, base, &result) && FIXNUM_FITS(result);
+      }
+
+      exponent >>= 1;
+      if (exponent > 0 && fits) {
+        fits = !__builtin_mul_overflow(base, base, &base);
+      }
+    }
+
+    if (fits) {
+      return FIXNUM_VAL(result);
+    }
+  }
+
   return NUMBER_VAL(pow(AS_NUMBER(args[0]), AS_NUMBER(args[1])));
 }
 
@@ -1,8 +1,58 @@
 #ifndef mesche_math_h
 #define mesche_math_h
 
+#include "value.h"
 #include "vm.h"
 
+// Arithmetic on any two numbers.  Exact operands give an exact result unless it
+// falls outside of the fixnum range, then the result is promoted to a double.
+
+static inline Value mesche_number_add(Value a, Value b) {
+  int64_t result;
+  if (IS_FIXNUM(a) && IS_FIXNUM(b) && !__builtin_add_overflow(AS_FIXNUM(a), AS_FIXNUM(b), &result) &&
+      FIXNUM_FITS(result)) {
+    return FIXNUM_VAL(result);
+  }
+
+  return NUMBER_VAL(AS_NUMBER(a) + AS_NUMBER(b));
+}
+
+static inline Value mesche_number_subtract(Value a, Value b) {
+  int64_t result;
+  if (IS_FIXNUM(a) && IS_FIXNUM(b) && !__builtin_sub_overflow(AS_FIXNUM(a), AS_FIXNUM(b), &result) &&
+      FIXNUM_FITS(result)) {
+    return FIXNUM_VAL(result);
+  }
+
+  return NUMBER_VAL(AS_NUMBER(a) - AS_NUMBER(b));
+}
+
+static inline Value mesche_number_multiply(Value a, Value b) {
+  int64_t result;
+  if (IS_FIXNUM(a) && IS_FIXNUM(b) && !__builtin_mul_overflow(AS_FIXNUM(a), AS_FIXNUM(b), &result) &&
+      FIXNUM_FITS(result)) {
+    return FIXNUM_VAL(result);
+  }
+
+  return NUMBER_VAL(AS_NUMBER(a) * AS_NUMBER(b));
+}
+
+static inline Value mesche_number_divide(Value a, Value b) {
+  // There are no exact rationals so only evenly divisible integers stay exact
+  if (IS_FIXNUM(a) && IS_FIXNUM(b) && AS_FIXNUM(b) != 0 && AS_FIXNUM(a) % AS_FIXNUM(b) == 0) {
+    return FIXNUM_VAL(AS_FIXNUM(a) / AS_FIXNUM(b));
+  }
+
+  return NUMBER_VAL(AS_NUMBER(a) / AS_NUMBER(b));
+}
+
+// Compares two numbers with a C comparison operator, using integer comparison
+// when both are exact
+#define NUMBER_COMPARE(a, op, b)                                                                   \
+  ((IS_FIXNUM(a) && IS_FIXNUM(b)) ? (AS_FIXNUM(a) op AS_FIXNUM(b))                                 \
+                                  : (AS_NUMBER(a) op AS_NUMBER(b)))
+
+Value mesche_number_from_string(const char *chars);
 void mesche_math_module_init(VM *vm);
 
 #endif
@@ -1,38 +1,204 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <time.h>
 
 #include "mem.h"
 #include "util.h"
 
 // This is arbitrarily picked, inspired by Crafting Interpreters.
 // It will probably need to be adjusted over time!
-#define GC_INITIAL_LIMIT 1024 * 1024;
+#define GC_INITIAL_LIMIT (1024 * 1024)
 
 // The factor by which the heap limit will be extended after a sweep
-#define GC_HEAP_GROW_FACTOR 2;
+#define GC_HEAP_GROW_FACTOR 2
+
+// The least and most the heap can grow between collections when it's paced
+// by a heap target or GC CPU percent
+#define GC_MIN_HEADROOM (256 * 1024)
+#define GC_MAX_GROW_FACTOR 8
+
+// How much the newest measurement counts toward the pacer's averages
+#define GC_PACER_SMOOTHING 0.5
+
+// The number of bytes that can be allocated between minor collections when
+// garbage is collected generationally
+#define GC_NURSERY_SIZE (256 * 1024)
+
+// The number of bytes that can be allocated between slices of incremental
+// garbage collection
+#define GC_SLICE_SIZE (64 * 1024)
 
 // If this is defined, the GC will be run frequently
 /* #define DEBUG_STRESS_GC 1 */
 
 void mesche_mem_init(MescheMemory *mem, MescheMemoryCollectGarbageFunc collect_garbage_func) {
   mem->collect_garbage_func = collect_garbage_func;
+  mem->collect_garbage_slice_func = NULL;
   mem->bytes_allocated = 0;
   mem->next_gc = GC_INITIAL_LIMIT;
+  mem->heap_target = 0;
+  mem->gc_cpu_percent = 0;
+  mem->heap_limit = 0;
+  mem->is_out_of_memory = false;
+  mem->gc_seconds_per_byte = 0;
+  mem->allocation_rate = 0;
+  mem->survival_rate = 0;
+  mem->last_gc_end = 0;
+  mem->last_live_size = 0;
+  mem->cycle_gc_seconds = 0;
+  mem->cycle_start_bytes = 0;
+  memset(&mem->stats, 0, sizeof(MescheGCStats));
+  mesche_heap_init(&mem->heap);
+}
+
+static double mem_seconds(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+static void mem_record_pause(MescheMemory *mem, double seconds) {
+  MescheGCStats *stats = &mem->stats;
+  stats->pause_count++;
+  stats->pause_total_seconds += seconds;
+  if (seconds > stats->pause_max_seconds) {
+    stats->pause_max_seconds = seconds;
+  }
+
+  int bucket = 0;
+  for (double usec = seconds * 1e6; usec >= 1 && bucket < GC_PAUSE_BUCKET_COUNT - 1; usec /= 2) {
+    bucket++;
+  }
+  stats->pause_buckets[bucket]++;
+}
+
+// Updates the statistics and the pacer's measurements after a collection that took `gc_seconds`
+// and started when `before_size` bytes were allocated
+static void mem_measure_collection(MescheMemory *mem, size_t before_size, double gc_seconds) {
+  double now = mem_seconds();
+  size_t live_size = mem->bytes_allocated;
+
+  // Marking dominates the cost of a collection and it grows with the amount
+  // of memory that survives
+  double seconds_per_byte = gc_seconds / (live_size > 0 ? live_size : 1);
+  double survival_rate = before_size > 0 ? (double)live_size / before_size : 0;
+  if (survival_rate > 1) {
+    survival_rate = 1;
+  }
+
+  MescheGCStats *stats = &mem->stats;
+  stats->collection_count++;
+  stats->bytes_freed = before_size > live_size ? before_size - live_size : 0;
+  stats->bytes_freed_total += stats->bytes_freed;
+  stats->survival_rate = survival_rate;
+  stats->promotion_rate = 0;
+  if (before_size > mem->last_live_size && live_size > mem->last_live_size) {
+    stats->promotion_rate =
+        (double)(live_size - mem->last_live_size) / (before_size - mem->last_live_size);
+  }
+
+  if (mem->last_gc_end > 0) {
+    mem->gc_seconds_per_byte = GC_PACER_SMOOTHING * seconds_per_byte +
+                               (1 - GC_PACER_SMOOTHING) * mem->gc_seconds_per_byte;
+    mem->survival_rate =
+        GC_PACER_SMOOTHING * survival_rate + (1 - GC_PACER_SMOOTHING) * mem->survival_rate;
+
+    // The program allocated the heap's growth since the last collection in
+    // the time that wasn't spent collecting garbage
+    double mutator_seconds = now - mem->last_gc_end - gc_seconds;
+    if (mutator_seconds > 0 && before_size > mem->last_live_size) {
+      double allocation_rate = (before_size - mem->last_live_size) / mutator_seconds;
+      mem->allocation_rate = mem->allocation_rate > 0
+                                 ? GC_PACER_SMOOTHING * allocation_rate +
+                                       (1 - GC_PACER_SMOOTHING) * mem->allocation_rate
+                                 : allocation_rate;
+    }
+  } else {
+    mem->gc_seconds_per_byte = seconds_per_byte;
+    mem->survival_rate = survival_rate;
+  }
+
+  mem->last_gc_end = now;
+  mem->last_live_size = live_size;
+}
+
+// Decides how large the heap can grow before the next collection
+static size_t mem_pace(MescheMemory *mem) {
+  size_t live_size = mem->bytes_allocated;
+  size_t next_gc = live_size * GC_HEAP_GROW_FACTOR;
+
+  if (mem->heap_target > 0) {
+    // Use the memory the target allows, though there must be some room left
+    // once the live objects fill most of it
+    next_gc = mem->heap_target > live_size + GC_MIN_HEADROOM ? mem->heap_target
+                                                             : live_size + GC_MIN_HEADROOM;
+  } else if (mem->gc_cpu_percent > 0 && mem->allocation_rate > 0) {
+    // The next collection's cost grows with the live objects plus the share
+    // of new objects that survive, and the program should get to run for
+    // (100 - percent) / percent times that long before it starts.  Solving
+    // for the allocation that fits in that time gives:
+    //   headroom = k * live / (1 - k * survival_rate)
+    //   where k = allocation_rate * seconds_per_byte * (100 - percent) / percent
+    double k = mem->allocation_rate * mem->gc_seconds_per_byte * (100 - mem->gc_cpu_percent) /
+               mem->gc_cpu_percent;
+    double max_headroom = (double)live_size * (GC_MAX_GROW_FACTOR - 1);
+    double headroom = max_headroom;
+    if (k * mem->survival_rate < 1) {
+      headroom = k * live_size / (1 - k * mem->survival_rate);
+    }
+
+    if (headroom > max_headroom) {
+      headroom = max_headroom;
+    }
+    if (headroom < GC_MIN_HEADROOM) {
+      headroom = GC_MIN_HEADROOM;
+    }
+
+    next_gc = live_size + (size_t)headroom;
+  }
+
+  if (mem->heap_limit > 0 && next_gc > mem->heap_limit) {
+    next_gc = mem->heap_limit;
+  }
+
+  return next_gc;
+}
+
+static void mem_collect_garbage_if_needed(MescheMemory *mem) {
+#ifndef DEBUG_STRESS_GC
+  if (mem->bytes_allocated <= mem->next_gc) {
+    return;
+  }
+#endif
+
+  // Try a full collection before giving up when the heap is over its limit.
+  // There's no need to collect again until the error has been raised.
+  if (mem->heap_limit > 0 && mem->bytes_allocated > mem->heap_limit) {
+    if (!mem->is_out_of_memory) {
+      mesche_mem_collect_garbage(mem);
+      mem->is_out_of_memory = mem->bytes_allocated > mem->heap_limit;
+    }
+    return;
+  }
+
+#ifdef MESCHE_INCREMENTAL_GC
+  mesche_mem_collect_garbage_slice(mem);
+#else
+  mesche_mem_collect_garbage(mem);
+#endif
 }
 
 void *mesche_mem_realloc(MescheMemory *mem, void *mem_ptr, size_t old_size, size_t new_size) {
   // Adjust the memory allocation amount
-  mem->bytes_allocated += (int)new_size - (int)old_size;
+  if (new_size >= old_size) {
+    mem->bytes_allocated += new_size - old_size;
+  } else {
+    mem->bytes_allocated -= old_size - new_size;
+  }
 
   // Decide whether to collect garbage
   if (new_size > old_size) {
-#ifdef DEBUG_STRESS_GC
-    mesche_mem_collect_garbage(mem);
-#else
-    if (mem->bytes_allocated > mem->next_gc) {
-      mesche_mem_collect_garbage(mem);
-    }
-#endif
+    mem_collect_garbage_if_needed(mem);
   }
 
   if (new_size == 0) {
@@ -50,6 +216,16 @@ void *mesche_mem_realloc(MescheMemory *mem, void *mem_ptr, size_t old_size, size
   return new_ptr;
 }
 
+// Accounts for `size` bytes that the caller is about to allocate in several
+// pieces with plain malloc, collecting garbage first if it's time to.  Since
+// the collection can only happen here, the caller doesn't need to keep the
+// pieces reachable while it puts them together.
+void mesche_mem_reserve(MescheMemory *mem, size_t size) {
+  mem->bytes_allocated += size;
+
+  mem_collect_garbage_if_needed(mem);
+}
+
 void mesche_mem_collect_garbage(MescheMemory *mem) {
   if (mem->collect_garbage_func == NULL) {
     PANIC("No garbage collector function is registered.");
@@ -57,21 +233,96 @@ void mesche_mem_collect_garbage(MescheMemory *mem) {
 
 #ifdef DEBUG_LOG_GC
   printf("-- GC starting...\n");
-  size_t before_size = mem->bytes_allocated;
 #endif
 
+  size_t before_size = mem->bytes_allocated;
+  double start_time = mem_seconds();
+
   // Collect garbage and adjust the next GC limit
   mem->collect_garbage_func(mem);
-  mem->next_gc = mem->bytes_allocated * GC_HEAP_GROW_FACTOR;
+  double gc_seconds = mem_seconds() - start_time;
+  mem_record_pause(mem, gc_seconds);
+  mem_measure_collection(mem, before_size, gc_seconds);
+#ifdef MESCHE_GENERATIONAL_GC
+  mem->next_gc = mem->bytes_allocated + GC_NURSERY_SIZE;
+  if (mem->heap_limit > 0 && mem->next_gc > mem->heap_limit) {
+    mem->next_gc = mem->heap_limit;
+  }
+#else
+  mem->next_gc = mem_pace(mem);
+#endif
+
+  // An incremental cycle in progress was finished by the full collection
+  mem->cycle_gc_seconds = 0;
 
 #ifdef DEBUG_LOG_GC
   printf("-- GC finished: freed %zu bytes (from %zu to %zu), next GC at %zu bytes\n",
-         (int)before_size - (int)mem->bytes_allocated, before_size, mem->bytes_allocated,
-         mem->next_gc);
+         before_size - mem->bytes_allocated, before_size, mem->bytes_allocated, mem->next_gc);
 #endif
 }
 
+// Performs the next slice of an incremental collection, starting a new
+// collection cycle if none is in progress.  The next slice happens after
+// another `GC_SLICE_SIZE` bytes are allocated, or once the heap has grown
+// again if the cycle finished.
+void mesche_mem_collect_garbage_slice(MescheMemory *mem) {
+  if (mem->collect_garbage_slice_func == NULL) {
+    PANIC("No incremental garbage collector function is registered.");
+  }
+
+  // The pacer measures the cost of the whole cycle
+  if (mem->cycle_gc_seconds == 0) {
+    mem->cycle_start_bytes = mem->bytes_allocated;
+  }
+
+  double start_time = mem_seconds();
+  bool is_finished = mem->collect_garbage_slice_func(mem);
+  double gc_seconds = mem_seconds() - start_time;
+  mem_record_pause(mem, gc_seconds);
+  mem->cycle_gc_seconds += gc_seconds;
+
+  if (is_finished) {
+    mem_measure_collection(mem, mem->cycle_start_bytes, mem->cycle_gc_seconds);
+    mem->cycle_gc_seconds = 0;
+    mem->next_gc = mem_pace(mem);
+  } else {
+    mem->next_gc = mem->bytes_allocated + GC_SLICE_SIZE;
+  }
+}
+
 void mesche_mem_report(MescheMemory *mem) {
   printf("-- %zu bytes allocated in memory, next GC at %zu bytes\n", mem->bytes_allocated,
          mem->next_gc);
+  printf("-- %zu collections in %zu pauses, %.3f ms total, %.3f ms max\n",
+         mem->stats.collection_count, mem->stats.pause_count,
+         mem->stats.pause_total_seconds * 1000, mem->stats.pause_max_seconds * 1000);
+}
+
+// Sets the heap size that the heap can grow to between collections, or 0 to
+// grow it by a fixed factor of the live objects.  Takes effect after the next
+// collection.
+void mesche_mem_set_heap_target(MescheMemory *mem, size_t heap_target) {
+  mem->heap_target = heap_target;
+}
+
+// Sets the share of the program's time that should be spent collecting
+// garbage, from 1 to 99, or 0 to stop pacing by time.  Takes effect after the
+// next collection.
+void mesche_mem_set_gc_cpu_percent(MescheMemory *mem, int gc_cpu_percent) {
+  if (gc_cpu_percent < 0) {
+    gc_cpu_percent = 0;
+  } else if (gc_cpu_percent > 99) {
+    gc_cpu_percent = 99;
+  }
+
+  mem->gc_cpu_percent = gc_cpu_percent;
+}
+
+// Sets the most memory that objects can take up, or 0 for no limit
+void mesche_mem_set_heap_limit(MescheMemory *mem, size_t heap_limit) {
+  mem->heap_limit = heap_limit;
+  mem->is_out_of_memory = false;
+  if (heap_limit > 0 && mem->next_gc > heap_limit) {
+    mem->next_gc = heap_limit;
+  }
 }
@@ -4,20 +4,96 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "heap.h"
+
 // Log when garbage collection occurs
 /* #define DEBUG_LOG_GC */
 
+// NOTE: Enable this to collect garbage generationally.  Objects that survive a
+// collection are promoted to the old generation and most collections only
+// trace the roots and the old objects that were written to since the last one.
+/* #define MESCHE_GENERATIONAL_GC */
+
+// NOTE: Enable this to collect garbage incrementally.  Marking is done in
+// small slices as memory is allocated and pages are swept lazily, so programs
+// don't pause for a whole collection at once.
+/* #define MESCHE_INCREMENTAL_GC */
+
+// NOTE: Enable this to mark objects on a pool of threads, one per CPU.  The
+// program is still paused for the whole collection but the pause gets shorter
+// with more cores.  Requires linking with -pthread.
+/* #define MESCHE_PARALLEL_GC */
+
+#if defined(MESCHE_GENERATIONAL_GC) && defined(MESCHE_INCREMENTAL_GC)
+#error "Generational and incremental garbage collection can't be enabled together."
+#endif
+
+#if defined(MESCHE_PARALLEL_GC) &&                                                                 \
+    (defined(MESCHE_GENERATIONAL_GC) || defined(MESCHE_INCREMENTAL_GC))
+#error "Parallel marking can't be combined with generational or incremental collection."
+#endif
+
 struct MescheMemory;
 
 // Stores a pointer to the garbage collector (almost certainly from the VM)
 typedef void (*MescheMemoryCollectGarbageFunc)(struct MescheMemory *);
 
+// Performs a slice of incremental garbage collection, returning true once the
+// collection cycle it is part of is complete
+typedef bool (*MescheMemoryCollectGarbageSliceFunc)(struct MescheMemory *);
+
+// Pauses are counted in buckets by their length in microseconds: bucket 0
+// counts pauses under 1us and bucket N those under 2^N us.  The last bucket
+// also counts every longer pause.
+#define GC_PAUSE_BUCKET_COUNT 20
+
+// Statistics that are collected continuously as garbage is collected.  A
+// pause is a full collection or one slice of an incremental collection.
+typedef struct MescheGCStats {
+  size_t collection_count;
+  size_t pause_count;
+  double pause_total_seconds;
+  double pause_max_seconds;
+  size_t pause_buckets[GC_PAUSE_BUCKET_COUNT];
+
+  // Measured by the most recent collection.  The promotion rate is the share
+  // of the bytes allocated since the previous collection that survived, all
+  // of which are promoted when garbage is collected generationally.
+  size_t bytes_freed;
+  size_t bytes_freed_total;
+  double survival_rate;
+  double promotion_rate;
+} MescheGCStats;
+
 // Contains pointers to objects which assist with memory management
 // and object usage tracking.
 typedef struct MescheMemory {
   MescheMemoryCollectGarbageFunc collect_garbage_func;
+  MescheMemoryCollectGarbageSliceFunc collect_garbage_slice_func;
   size_t bytes_allocated;
   size_t next_gc;
+  MescheHeap heap;
+
+  // Pacer goals, each of them is disabled when zero.  A heap target lets the
+  // heap grow up to that size between collections, otherwise a GC CPU percent
+  // sizes the heap so that collection takes about that share of the program's
+  // time.  The heap limit is a hard cap: when a full collection can't bring
+  // the heap back under it, an out of memory error is raised at the next call.
+  size_t heap_target;
+  int gc_cpu_percent;
+  size_t heap_limit;
+  bool is_out_of_memory;
+
+  // Pacer measurements from previous collections
+  double gc_seconds_per_byte;
+  double allocation_rate;
+  double survival_rate;
+  double last_gc_end;
+  size_t last_live_size;
+  double cycle_gc_seconds;
+  size_t cycle_start_bytes;
+
+  MescheGCStats stats;
 } MescheMemory;
 
 #define GROW_CAPACITY(capacity) ((capacity) < 8 ? 8 : (capacity)*2);
@@ -31,7 +107,12 @@ typedef struct MescheMemory {
 
 void mesche_mem_init(MescheMemory *mem, MescheMemoryCollectGarbageFunc collect_garbage_func);
 void *mesche_mem_realloc(MescheMemory *mem, void *mem_ptr, size_t old_size, size_t new_size);
+void mesche_mem_reserve(MescheMemory *mem, size_t size);
 void mesche_mem_collect_garbage(MescheMemory *mem);
+void mesche_mem_collect_garbage_slice(MescheMemory *mem);
 void mesche_mem_report(MescheMemory *mem);
+void mesche_mem_set_heap_target(MescheMemory *mem, size_t heap_target);
+void mesche_mem_set_gc_cpu_percent(MescheMemory *mem, int gc_cpu_percent);
+void mesche_mem_set_heap_limit(MescheMemory *mem, size_t heap_limit);
 
 #endif
@@ -2,6 +2,7 @@
 #include <stdlib.h>
 
 #include "fs.h"
+#include "gc.h"
 #include "module.h"
 #include "native.h"
 #include "object.h"
@@ -18,6 +19,7 @@ ObjectModule *mesche_object_make_module(VM *vm, ObjectString *name) {
 
   // Initialize binding tables
   mesche_table_init(&module->locals);
+  mesche_value_array_init(&module->bindings);
   mesche_value_array_init(&module->imports);
   mesche_value_array_init(&module->exports);
 
@@ -26,9 +28,10 @@ ObjectModule *mesche_object_make_module(VM *vm, ObjectString *name) {
 
 void mesche_free_module(VM *vm, ObjectModule *module) {
   mesche_table_free((MescheMemory *)vm, &module->locals);
+  mesche_value_array_free((MescheMemory *)vm, &module->bindings);
   mesche_value_array_free((MescheMemory *)vm, &module->imports);
   mesche_value_array_free((MescheMemory *)vm, &module->exports);
-  FREE(vm, ObjectModule, module);
+  FREE_OBJECT(vm, module);
 }
 
 void mesche_module_print_name(ObjectModule *module) { printf("(%s)", module->name->chars); }
@@ -145,9 +148,49 @@ void mesche_module_import(VM *vm, ObjectModule *from_module, ObjectModule *to_mo
   for (int i = 0; i < from_module->exports.count; i++) {
     Value export_value = FALSE_VAL;
     ObjectString *export_name = AS_STRING(from_module->exports.values[i]);
-    mesche_table_get(&from_module->locals, export_name, &export_value);
-    mesche_table_set((MescheMemory *)vm, &to_module->locals, export_name, export_value);
+    int slot = mesche_module_binding_find(from_module, export_name);
+    if (slot >= 0) {
+      export_value = from_module->bindings.values[slot];
+    }
+
+    mesche_module_binding_define(vm, to_module, export_name, export_value);
+  }
+}
+
+int mesche_module_binding_find(ObjectModule *module, ObjectString *name) {
+  Value slot_value;
+  if (mesche_table_get(&module->locals, name, &slot_value)) {
+    return (int)AS_FIXNUM(slot_value);
+  }
+
+  return -1;
+}
+
+int mesche_module_binding_define(VM *vm, ObjectModule *module, ObjectString *name, Value value) {
+  // Reuse the existing slot if the name is already bound
+  int slot = mesche_module_binding_find(module, name);
+  if (slot >= 0) {
+    module->bindings.values[slot] = value;
+    mesche_gc_write_barrier(vm, (Object *)module);
+    return slot;
   }
+
+  // Keep the name and value reachable while the binding storage grows
+  mesche_vm_stack_push(vm, OBJECT_VAL(name));
+  mesche_vm_stack_push(vm, value);
+
+  slot = module->bindings.count;
+  mesche_value_array_write((MescheMemory *)vm, &module->bindings, value);
+  mesche_table_set((MescheMemory *)vm, &module->locals, name, FIXNUM_VAL(slot));
+  mesche_gc_write_barrier(vm, (Object *)module);
+
+  mesche_vm_stack_pop(vm);
+  mesche_vm_stack_pop(vm);
+
+  // A new name can shadow a binding that cached global lookups resolved to
+  vm->binding_epoch++;
+
+  return slot;
 }
 
 Value module_current_msc(VM *vm, int arg_count, Value *args) {
@@ -10,7 +10,11 @@
 
 typedef struct ObjectModule {
   Object object;
+
+  // Module-level bindings live in `bindings`, `locals` maps each binding name
+  // to its index in that array
   Table locals;
+  ValueArray bindings;
   ValueArray imports;
   ValueArray exports;
   ObjectString *name;
@@ -27,6 +31,8 @@ void mesche_module_print_name(ObjectModule *module);
 ObjectModule *mesche_module_resolve_by_name(VM *vm, ObjectString *module_name, bool run_init);
 ObjectModule *mesche_module_resolve_by_name_string(VM *vm, const char *module_name, bool run_init);
 void mesche_module_import(VM *vm, ObjectModule *from_module, ObjectModule *to_module);
+int mesche_module_binding_find(ObjectModule *module, ObjectString *name);
+int mesche_module_binding_define(VM *vm, ObjectModule *module, ObjectString *name, Value value);
 
 void mesche_module_module_init(VM *vm);
 
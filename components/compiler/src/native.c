@@ -11,7 +11,7 @@ ObjectNativeFunction *mesche_object_make_native_function(VM *vm, FunctionPtr fun
 }
 
 void mesche_free_native_function(VM *vm, ObjectNativeFunction *function) {
-  FREE(vm, ObjectNativeFunction, function);
+  FREE_OBJECT(vm, function);
 }
 
 ObjectPointer *mesche_object_make_pointer(VM *vm, void *ptr, bool is_managed) {
@@ -25,9 +25,10 @@ ObjectPointer *mesche_object_make_pointer(VM *vm, void *ptr, bool is_managed) {
 
 void mesche_free_pointer(VM *vm, ObjectPointer *pointer) {
   if (pointer->ptr != NULL && pointer->is_managed) {
-    // Call the pointer's own free function if there is one
+    // The pointer's own free function can do arbitrary work, so it runs
+    // after the collection finishes
     if (pointer->type != NULL && pointer->type->free_func != NULL) {
-      pointer->type->free_func((MescheMemory *)vm, pointer->ptr);
+      mesche_gc_defer_finalizer(vm, pointer->type->free_func, pointer->ptr);
     } else {
       free(pointer->ptr);
     }
@@ -35,7 +36,7 @@ void mesche_free_pointer(VM *vm, ObjectPointer *pointer) {
     pointer->ptr = NULL;
   }
 
-  FREE(vm, ObjectPointer, pointer);
+  FREE_OBJECT(vm, pointer);
 }
 
 ObjectPointer *mesche_object_make_pointer_type(VM *vm, void *ptr, const ObjectPointerType *type) {
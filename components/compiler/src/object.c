@@ -1,4 +1,5 @@
 #include <stdio.h>
+#include <stdlib.h>
 
 #include "array.h"
 #include "closure.h"
@@ -11,29 +12,38 @@
 #include "native.h"
 #include "object.h"
 #include "process.h"
+#include "profiler.h"
 #include "record.h"
 #include "string.h"
 #include "symbol.h"
 #include "syntax.h"
 #include "util.h"
 #include "vm-impl.h"
+#include "weak.h"
 
-Object *mesche_object_allocate(VM *vm, size_t size, ObjectKind kind) {
-  Object *object = (Object *)mesche_mem_realloc((MescheMemory *)vm, NULL, 0, size);
+static Object *object_init(VM *vm, Object *object, size_t size, ObjectKind kind) {
   object->kind = kind;
-
-  // Keep track of the object for garbage collection
-  object->is_marked = false;
-  object->next = vm->objects;
-  vm->objects = object;
+  object->is_remembered = false;
+  object->is_escaped = false;
 
 #ifdef DEBUG_LOG_GC
   printf("%p    allocate %zu for %d\n", (void *)object, size, kind);
 #endif
 
+  if (vm->profiler != NULL) {
+    mesche_profiler_count(vm, vm->profiler, object, size);
+  }
+
   return object;
 }
 
+Object *mesche_object_allocate(VM *vm, size_t size, ObjectKind kind) {
+  // Collect garbage before taking a cell from the heap
+  mesche_mem_reserve((MescheMemory *)vm, mesche_heap_cell_size(&vm->mem.heap, size));
+  Object *object = (Object *)mesche_heap_allocate(&vm->mem, size);
+  return object_init(vm, object, size, kind);
+}
+
 ObjectCons *mesche_object_make_cons(VM *vm, Value car, Value cdr) {
   ObjectCons *cons = ALLOC_OBJECT(vm, ObjectCons, ObjectKindCons);
   cons->car = car;
@@ -42,8 +52,28 @@ ObjectCons *mesche_object_make_cons(VM *vm, Value car, Value cdr) {
   return cons;
 }
 
+Value mesche_object_make_list(VM *vm, Value *values, int count, Value tail) {
+  // Reserve the memory for all of the list's pairs at once so that garbage
+  // collection can't happen while the list is partially built.  The values
+  // and tail must already be reachable, usually from the value stack.
+  mesche_mem_reserve((MescheMemory *)vm,
+                     mesche_heap_cell_size(&vm->mem.heap, sizeof(ObjectCons)) * count);
+
+  Value list = tail;
+  for (int i = count - 1; i >= 0; i--) {
+    ObjectCons *cons = mesche_heap_allocate(&vm->mem, sizeof(ObjectCons));
+
+    object_init(vm, (Object *)cons, sizeof(ObjectCons), ObjectKindCons);
+    cons->car = values[i];
+    cons->cdr = list;
+    list = OBJECT_VAL(cons);
+  }
+
+  return list;
+}
+
 ObjectStackMarker *mesche_object_make_stack_marker(VM *vm, StackMarkerKind kind,
-                                                   uint8_t frame_index) {
+                                                   int frame_index) {
   ObjectStackMarker *marker = ALLOC_OBJECT(vm, ObjectStackMarker, ObjectKindStackMarker);
   marker->kind = kind;
   marker->frame_index = frame_index;
@@ -73,7 +103,7 @@ void mesche_object_free(VM *vm, Object *object) {
     mesche_free_syntax(vm, (ObjectSyntax *)object);
     break;
   case ObjectKindCons:
-    FREE(vm, ObjectCons, object);
+    FREE_OBJECT(vm, object);
     break;
   case ObjectKindArray:
     mesche_free_array(vm, (ObjectArray *)object);
@@ -92,7 +122,7 @@ void mesche_object_free(VM *vm, Object *object) {
     break;
   case ObjectKindStackMarker: {
     ObjectStackMarker *marker = (ObjectStackMarker *)object;
-    FREE(vm, ObjectStackMarker, object);
+    FREE_OBJECT(vm, object);
     break;
   }
   case ObjectKindNativeFunction:
@@ -114,24 +144,24 @@ void mesche_object_free(VM *vm, Object *object) {
     mesche_free_record(vm, (ObjectRecord *)object);
     break;
   }
-  case ObjectKindRecordInstance: {
-    ObjectRecordInstance *instance = (ObjectRecordInstance *)object;
-    mesche_value_array_free((MescheMemory *)vm, &instance->field_values);
-    FREE(vm, ObjectRecordInstance, object);
+  case ObjectKindRecordInstance:
+    mesche_free_record_instance(vm, (ObjectRecordInstance *)object);
     break;
-  }
   case ObjectKindRecordPredicate: {
-    FREE(vm, ObjectRecordPredicate, object);
+    FREE_OBJECT(vm, object);
     break;
   }
   case ObjectKindRecordField:
-    FREE(vm, ObjectRecordField, object);
+    FREE_OBJECT(vm, object);
     break;
   case ObjectKindRecordFieldAccessor:
-    FREE(vm, ObjectRecordFieldAccessor, object);
+    FREE_OBJECT(vm, object);
     break;
   case ObjectKindRecordFieldSetter:
-    FREE(vm, ObjectRecordFieldSetter, object);
+    FREE_OBJECT(vm, object);
+    break;
+  case ObjectKindWeakTable:
+    mesche_free_weak_table(vm, (ObjectWeakTable *)object);
     break;
   case ObjectKindError:
     mesche_free_error(vm, (MescheError *)object);
@@ -272,6 +302,12 @@ void mesche_object_print_ex(MeschePort *port, Value value, MeschePrintStyle styl
     fprintf(port->data.file.fp, "#<predicate '%s?'>", predicate->record_type->name->chars);
     break;
   }
+  case ObjectKindWeakTable: {
+    ObjectWeakTable *table = AS_WEAK_TABLE(value);
+    fprintf(port->data.file.fp, "#<%s table %p>",
+            table->kind == WEAK_TABLE_EPHEMERONS ? "ephemeron" : "weak", table);
+    break;
+  }
   default:
     fprintf(port->data.file.fp, "#<unknown>");
     break;
@@ -282,6 +318,37 @@ inline bool mesche_object_is_kind(Value value, ObjectKind kind) {
   return IS_OBJECT(value) && AS_OBJECT(value)->kind == kind;
 }
 
+const char *mesche_object_kind_name(ObjectKind kind) {
+  static const char *kind_names[OBJECT_KIND_COUNT] = {
+      [ObjectKindString] = "string",
+      [ObjectKindSymbol] = "symbol",
+      [ObjectKindKeyword] = "keyword",
+      [ObjectKindSyntax] = "syntax",
+      [ObjectKindCons] = "cons",
+      [ObjectKindArray] = "array",
+      [ObjectKindUpvalue] = "upvalue",
+      [ObjectKindFunction] = "function",
+      [ObjectKindClosure] = "closure",
+      [ObjectKindContinuation] = "continuation",
+      [ObjectKindStackMarker] = "stack-marker",
+      [ObjectKindNativeFunction] = "native-function",
+      [ObjectKindPointer] = "pointer",
+      [ObjectKindModule] = "module",
+      [ObjectKindPort] = "port",
+      [ObjectKindProcess] = "process",
+      [ObjectKindRecord] = "record",
+      [ObjectKindRecordInstance] = "record-instance",
+      [ObjectKindRecordPredicate] = "record-predicate",
+      [ObjectKindRecordField] = "record-field",
+      [ObjectKindRecordFieldAccessor] = "record-field-accessor",
+      [ObjectKindRecordFieldSetter] = "record-field-setter",
+      [ObjectKindWeakTable] = "weak-table",
+      [ObjectKindError] = "error",
+  };
+
+  return kind < OBJECT_KIND_COUNT ? kind_names[kind] : "unknown";
+}
+
 bool mesche_object_string_equalsp(Object *left, Object *right) {
   if (left == NULL || right == NULL) {
     // TODO: Report an error?
@@ -4,13 +4,21 @@
 #include <stdint.h>
 
 #include "io.h"
+#include "mem.h"
 #include "value.h"
 #include "vm.h"
 
+#ifdef MESCHE_NAN_BOXING
+#define IS_OBJECT(value) (((value) & (QNAN | SIGN_BIT)) == (QNAN | SIGN_BIT))
+#define AS_OBJECT(value) ((Object *)(uintptr_t)((value) & ~(SIGN_BIT | QNAN)))
+
+#define OBJECT_VAL(value) ((Value)(SIGN_BIT | QNAN | (uint64_t)(uintptr_t)(value)))
+#else
 #define IS_OBJECT(value) ((value).kind == VALUE_OBJECT)
 #define AS_OBJECT(value) ((value).as.object)
 
 #define OBJECT_VAL(value) ((Value){VALUE_OBJECT, {.object = (Object *)value}})
+#endif
 #define OBJECT_KIND(value) (AS_OBJECT(value)->kind)
 
 #define IS_CONS(value) mesche_object_is_kind(value, ObjectKindCons)
@@ -47,15 +55,25 @@ typedef enum {
   ObjectKindRecordField,
   ObjectKindRecordFieldAccessor,
   ObjectKindRecordFieldSetter,
+  ObjectKindWeakTable,
   ObjectKindError
 } ObjectKind;
 
+#define OBJECT_KIND_COUNT (ObjectKindError + 1)
+
+// Every object starts with a small header.  Objects are tracked and marked by
+// the heap pages they're allocated from, so the header only holds the kind,
+// the remembered flag used by the generational collector and the flag that
+// records an object outside of an arena scope being written to inside it.
 struct Object {
-  ObjectKind kind;
-  bool is_marked;
-  struct Object *next;
+  uint32_t kind : 8;
+  uint32_t is_remembered : 1;
+  uint32_t is_escaped : 1;
 };
 
+// Objects are allocated from the heap so they must be freed back to it
+#define FREE_OBJECT(vm, object) mesche_heap_free((MescheMemory *)(vm), (object))
+
 typedef struct ObjectCons {
   struct Object object;
   Value car;
@@ -67,18 +85,20 @@ typedef enum { STACK_MARKER_RESET, STACK_MARKER_SHIFT } StackMarkerKind;
 typedef struct ObjectStackMarker {
   Object object;
   StackMarkerKind kind;
-  uint8_t frame_index;
+  int frame_index;
 } ObjectStackMarker;
 
 ObjectCons *mesche_object_make_cons(VM *vm, Value car, Value cdr);
+Value mesche_object_make_list(VM *vm, Value *values, int count, Value tail);
 ObjectStackMarker *mesche_object_make_stack_marker(VM *vm, StackMarkerKind kind,
-                                                   uint8_t frame_index);
+                                                   int frame_index);
 
 void mesche_object_free(VM *vm, struct Object *object);
 void mesche_object_print(MeschePort *port, Value value);
 void mesche_object_print_ex(MeschePort *port, Value value, MeschePrintStyle style);
 
 bool mesche_object_is_kind(Value value, ObjectKind kind);
+const char *mesche_object_kind_name(ObjectKind kind);
 bool mesche_object_string_equalsp(Object *left, Object *right);
 
 Object *mesche_object_allocate(VM *vm, size_t size, ObjectKind kind);
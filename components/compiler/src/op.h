@@ -45,12 +45,71 @@ typedef enum {
   OP_CLOSURE,
   OP_CLOSE_UPVALUE,
   OP_APPLY,
+  OP_TAIL_APPLY,
   OP_DISPLAY,
   OP_RESET,
   OP_SHIFT,
   OP_REIFY,
   OP_BREAK,
-  OP_RETURN
+  OP_RETURN,
+
+  // Superinstructions, written over the first opcode of a common sequence by
+  // the compiler.  They execute the whole sequence at once and leave the
+  // original operand bytes in place so that jumps into the middle of the
+  // sequence still land on valid instructions.
+  OP_READ_LOCAL_LOCAL,
+  OP_READ_LOCAL_CONSTANT,
+  OP_LOCAL_CONSTANT_ADD,
+  OP_LOCAL_CONSTANT_SUBTRACT,
+  OP_LESS_THAN_JUMP_IF_FALSE,
+  OP_LESS_EQUAL_JUMP_IF_FALSE,
+  OP_GREATER_THAN_JUMP_IF_FALSE,
+  OP_GREATER_EQUAL_JUMP_IF_FALSE,
+
+  // Quickened variants that the VM writes over generic arithmetic and
+  // comparison opcodes once they have seen number operands, `*_NUM` for doubles
+  // and `*_FIX` for fixnums.  They revert to the `*_ANY` variant when the
+  // operands turn out to be something else.
+  OP_ADD_NUM,
+  OP_SUBTRACT_NUM,
+  OP_MULTIPLY_NUM,
+  OP_DIVIDE_NUM,
+  OP_GREATER_THAN_NUM,
+  OP_GREATER_EQUAL_NUM,
+  OP_LESS_THAN_NUM,
+  OP_LESS_EQUAL_NUM,
+  OP_EQV_NUM,
+  OP_EQUAL_NUM,
+  OP_ADD_FIX,
+  OP_SUBTRACT_FIX,
+  OP_MULTIPLY_FIX,
+  OP_GREATER_THAN_FIX,
+  OP_GREATER_EQUAL_FIX,
+  OP_LESS_THAN_FIX,
+  OP_LESS_EQUAL_FIX,
+  OP_EQV_FIX,
+  OP_EQUAL_FIX,
+
+  // Generic variants that never quicken, written over sites that have seen
+  // operands of more than one kind so they don't keep switching back and forth
+  OP_ADD_ANY,
+  OP_SUBTRACT_ANY,
+  OP_MULTIPLY_ANY,
+  OP_DIVIDE_ANY,
+  OP_GREATER_THAN_ANY,
+  OP_GREATER_EQUAL_ANY,
+  OP_LESS_THAN_ANY,
+  OP_LESS_EQUAL_ANY,
+  OP_EQV_ANY,
+  OP_EQUAL_ANY,
+
+  // Specialized forms of OP_CALL and OP_TAIL_CALL that the VM writes over call
+  // sites that invoke a record field accessor or setter.  They keep the call's
+  // operands and revert to the generic call for any other callee.
+  OP_RECORD_REF,
+  OP_TAIL_RECORD_REF,
+  OP_RECORD_SET,
+  OP_TAIL_RECORD_SET
 } MescheOpCode;
 
 #endif
@@ -4,6 +4,7 @@
 #include <unistd.h>
 
 #include "fs.h"
+#include "gc.h"
 #include "io.h"
 #include "keyword.h"
 #include "native.h"
@@ -87,6 +88,9 @@ MescheProcess *mesche_process_start(VM *vm, char *program_path, char *const argv
           AS_PORT(mesche_io_make_file_port(vm, MeschePortKindInput, fp, "stderr", 0));
     }
 
+    // The process may have survived a collection while its ports were created
+    mesche_gc_write_barrier(vm, (Object *)process);
+
     // Remove the process from the stack
     mesche_vm_stack_pop(vm);
 
@@ -144,7 +148,7 @@ void mesche_free_process(VM *vm, MescheProcess *process) {
   process->stdout_port = NULL;
   process->stderr_port = NULL;
 
-  FREE(vm, MescheProcess, process);
+  FREE_OBJECT(vm, process);
 }
 
 char *mesche_process_executable_path(void) {
@@ -298,7 +302,7 @@ Value process_start_sync_msc(VM *vm, int arg_count, Value *args) {
 
 Value process_exit_code_msc(VM *vm, int arg_count, Value *args) {
   MescheProcess *process = (MescheProcess *)AS_PROCESS(args[0]);
-  return NUMBER_VAL(process->exit_code);
+  return FIXNUM_VAL(process->exit_code);
 }
 
 Value process_stdout_msc(VM *vm, int arg_count, Value *args) {
@@ -0,0 +1,340 @@
+#include <math.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "closure.h"
+#include "function.h"
+#include "keyword.h"
+#include "mem.h"
+#include "native.h"
+#include "profiler.h"
+#include "util.h"
+#include "vm-impl.h"
+
+// Allocations are sampled on average once every `sample_rate` bytes.  The
+// distance to the next sample is drawn from an exponential distribution so
+// that the samples don't line up with allocation patterns in the program.
+static void profiler_schedule_sample(MescheProfiler *profiler) {
+  // xorshift64*
+  profiler->random_state ^= profiler->random_state >> 12;
+  profiler->random_state ^= profiler->random_state << 25;
+  profiler->random_state ^= profiler->random_state >> 27;
+  uint64_t random = profiler->random_state * 0x2545F4914F6CDD1DULL;
+
+  // A uniform number in (0, 1]
+  double uniform = ((random >> 11) + 1) / 9007199254740992.0;
+  profiler->bytes_until_sample = (int64_t)(-log(uniform) * profiler->sample_rate) + 1;
+}
+
+void mesche_profiler_start(VM *vm, size_t sample_rate) {
+  MescheProfiler *profiler = vm->profiler;
+  if (profiler == NULL) {
+    profiler = calloc(1, sizeof(MescheProfiler));
+    if (profiler == NULL) {
+      PANIC("Allocation profiler could not be allocated.");
+    }
+
+    profiler->random_state = 0x9E3779B97F4A7C15ULL;
+    vm->profiler = profiler;
+  }
+
+  profiler->sample_rate = sample_rate > 0 ? sample_rate : PROFILER_DEFAULT_SAMPLE_RATE;
+  profiler->is_sampling = true;
+  profiler_schedule_sample(profiler);
+}
+
+// Stops sampling allocations.  Objects that were already sampled are still
+// tracked so that the profile shows which of them are collected later.
+void mesche_profiler_stop(VM *vm) {
+  if (vm->profiler != NULL) {
+    vm->profiler->is_sampling = false;
+  }
+}
+
+void mesche_profiler_free(VM *vm) {
+  MescheProfiler *profiler = vm->profiler;
+  if (profiler == NULL) {
+    return;
+  }
+
+  for (int i = 0; i < profiler->site_count; i++) {
+    free(profiler->sites[i].stack);
+  }
+
+  free(profiler->sites);
+  free(profiler->site_slots);
+  free(profiler->samples);
+  free(profiler->stack_buffer);
+  free(profiler);
+  vm->profiler = NULL;
+}
+
+static void profiler_append(MescheProfiler *profiler, size_t *length, const char *format, ...) {
+  va_list args;
+  while (true) {
+    size_t available = profiler->stack_buffer_capacity - *length;
+    va_start(args, format);
+    int written = vsnprintf(profiler->stack_buffer + *length, available, format, args);
+    va_end(args);
+
+    if (written < 0) {
+      return;
+    }
+
+    if ((size_t)written < available) {
+      *length += written;
+      return;
+    }
+
+    profiler->stack_buffer_capacity = (*length + written + 1) * 2;
+    profiler->stack_buffer = realloc(profiler->stack_buffer, profiler->stack_buffer_capacity);
+    if (profiler->stack_buffer == NULL) {
+      PANIC("Allocation profiler's stack buffer could not be reallocated.");
+    }
+  }
+}
+
+// Writes the folded call stack of the VM into the stack buffer.  Frame names
+// can't contain `;` since it separates the frames.
+static void profiler_fold_stack(VM *vm, MescheProfiler *profiler) {
+  if (profiler->stack_buffer == NULL) {
+    profiler->stack_buffer_capacity = 256;
+    profiler->stack_buffer = malloc(profiler->stack_buffer_capacity);
+    if (profiler->stack_buffer == NULL) {
+      PANIC("Allocation profiler's stack buffer could not be allocated.");
+    }
+  }
+
+  size_t length = 0;
+  profiler->stack_buffer[0] = '\0';
+  if (vm->frame_count == 0) {
+    profiler_append(profiler, &length, "toplevel");
+    return;
+  }
+
+  for (int i = 0; i < vm->frame_count; i++) {
+    CallFrame *frame = &vm->frames[i];
+    ObjectFunction *function = frame->closure->function;
+    const char *name = function->name != NULL        ? function->name->chars
+                       : function->type == TYPE_SCRIPT ? "script"
+                                                       : "lambda";
+
+    // The instruction pointer is past the instruction that is running
+    int line = 0;
+    if (frame->ip > function->chunk.code) {
+      line = function->chunk.lines[frame->ip - function->chunk.code - 1];
+    }
+
+    profiler_append(profiler, &length, "%s%s (%s:%d)", i > 0 ? ";" : "", name,
+                    function->chunk.file_name ? function->chunk.file_name->chars : "script",
+                    line);
+  }
+}
+
+static uint32_t profiler_hash(const char *chars) {
+  // FNV-1a, the same hash that strings use
+  uint32_t hash = 2166136261u;
+  for (const char *c = chars; *c != '\0'; c++) {
+    hash ^= (uint8_t)*c;
+    hash *= 16777619;
+  }
+
+  return hash;
+}
+
+static void profiler_index_site(MescheProfiler *profiler, int site_index) {
+  int mask = profiler->site_slot_capacity - 1;
+  int slot = profiler->sites[site_index].hash & mask;
+  while (profiler->site_slots[slot] != -1) {
+    slot = (slot + 1) & mask;
+  }
+
+  profiler->site_slots[slot] = site_index;
+}
+
+// Finds the site of the stack in the stack buffer, adding it if it's new
+static int profiler_find_site(MescheProfiler *profiler) {
+  uint32_t hash = profiler_hash(profiler->stack_buffer);
+  if (profiler->site_slot_capacity > 0) {
+    int mask = profiler->site_slot_capacity - 1;
+    for (int slot = hash & mask; profiler->site_slots[slot] != -1; slot = (slot + 1) & mask) {
+      ProfileSite *site = &profiler->sites[profiler->site_slots[slot]];
+      if (site->hash == hash && strcmp(site->stack, profiler->stack_buffer) == 0) {
+        return profiler->site_slots[slot];
+      }
+    }
+  }
+
+  if (profiler->site_capacity < profiler->site_count + 1) {
+    profiler->site_capacity = GROW_CAPACITY(profiler->site_capacity);
+    profiler->sites = realloc(profiler->sites, sizeof(ProfileSite) * profiler->site_capacity);
+    if (profiler->sites == NULL) {
+      PANIC("Allocation profiler's sites could not be reallocated.");
+    }
+  }
+
+  int site_index = profiler->site_count++;
+  ProfileSite *site = &profiler->sites[site_index];
+  memset(site, 0, sizeof(ProfileSite));
+  site->stack = strdup(profiler->stack_buffer);
+  site->hash = hash;
+
+  // Keep the index at most half full
+  if (profiler->site_slot_capacity < profiler->site_count * 2) {
+    free(profiler->site_slots);
+    profiler->site_slot_capacity =
+        profiler->site_slot_capacity < 16 ? 16 : profiler->site_slot_capacity * 2;
+    profiler->site_slots = malloc(sizeof(int) * profiler->site_slot_capacity);
+    if (profiler->site_slots == NULL) {
+      PANIC("Allocation profiler's site index could not be allocated.");
+    }
+
+    memset(profiler->site_slots, -1, sizeof(int) * profiler->site_slot_capacity);
+    for (int i = 0; i < profiler->site_count; i++) {
+      profiler_index_site(profiler, i);
+    }
+  } else {
+    profiler_index_site(profiler, site_index);
+  }
+
+  return site_index;
+}
+
+void mesche_profiler_sample(VM *vm, Object *object, size_t size) {
+  MescheProfiler *profiler = vm->profiler;
+  profiler_schedule_sample(profiler);
+
+  // An allocation of `size` bytes is sampled with probability
+  // 1 - e^(-size / rate), so each sample stands for the object's heap cell
+  // divided by that probability
+  double probability = 1 - exp(-(double)size / profiler->sample_rate);
+  size_t bytes = (size_t)(mesche_heap_cell_size(&vm->mem.heap, size) / probability);
+
+  profiler_fold_stack(vm, profiler);
+  int site_index = profiler_find_site(profiler);
+  ProfileSite *site = &profiler->sites[site_index];
+  site->sample_count++;
+  site->allocated_bytes += bytes;
+  site->live_bytes += bytes;
+
+  if (profiler->sample_capacity < profiler->sample_count + 1) {
+    profiler->sample_capacity = GROW_CAPACITY(profiler->sample_capacity);
+    profiler->samples =
+        realloc(profiler->samples, sizeof(ProfileSample) * profiler->sample_capacity);
+    if (profiler->samples == NULL) {
+      PANIC("Allocation profiler's samples could not be reallocated.");
+    }
+  }
+
+  profiler->samples[profiler->sample_count++] =
+      (ProfileSample){.object = object, .site_index = site_index, .bytes = bytes};
+}
+
+// Moves the bytes of sampled objects that won't survive the collection from
+// live to freed.  Must be called after marking finishes and before the heap is
+// swept.
+void mesche_profiler_sweep(VM *vm) {
+  MescheProfiler *profiler = vm->profiler;
+  if (profiler == NULL) {
+    return;
+  }
+
+  int kept_count = 0;
+  for (int i = 0; i < profiler->sample_count; i++) {
+    ProfileSample *sample = &profiler->samples[i];
+    if (mesche_heap_is_live(&vm->mem.heap, sample->object)) {
+      profiler->samples[kept_count++] = *sample;
+    } else {
+      ProfileSite *site = &profiler->sites[sample->site_index];
+      site->live_bytes -= sample->bytes;
+      site->freed_bytes += sample->bytes;
+    }
+  }
+
+  profiler->sample_count = kept_count;
+}
+
+// Writes the profile as folded stacks, one site per line followed by the
+// chosen byte count, which flame graph tools and pprof converters can read
+bool mesche_profiler_write(VM *vm, FILE *fp, MescheProfileValue value) {
+  MescheProfiler *profiler = vm->profiler;
+  if (profiler == NULL) {
+    return false;
+  }
+
+  for (int i = 0; i < profiler->site_count; i++) {
+    ProfileSite *site = &profiler->sites[i];
+    size_t bytes = value == PROFILE_LIVE_BYTES    ? site->live_bytes
+                   : value == PROFILE_FREED_BYTES ? site->freed_bytes
+                                                  : site->allocated_bytes;
+    if (bytes > 0) {
+      fprintf(fp, "%s %zu\n", site->stack, bytes);
+    }
+  }
+
+  return true;
+}
+
+Value profiler_start_msc(VM *vm, int arg_count, Value *args) {
+  if (arg_count > 1) {
+    PANIC("Function accepts at most 1 parameter.");
+  }
+
+  int64_t sample_rate = arg_count == 1 ? AS_INTEGER(args[0]) : 0;
+  mesche_profiler_start(vm, sample_rate > 0 ? sample_rate : 0);
+  return TRUE_VAL;
+}
+
+Value profiler_stop_msc(VM *vm, int arg_count, Value *args) {
+  if (arg_count != 0) {
+    PANIC("Function accepts no parameters.");
+  }
+
+  mesche_profiler_stop(vm);
+  return TRUE_VAL;
+}
+
+Value profiler_write_msc(VM *vm, int arg_count, Value *args) {
+  if (arg_count < 1 || arg_count > 2) {
+    PANIC("Function requires 1 or 2 parameters.");
+  }
+
+  ObjectString *file_path = NULL;
+  EXPECT_OBJECT_KIND(ObjectKindString, 0, AS_STRING, file_path);
+
+  // The second argument picks the bytes to write, either :allocated, :live
+  // or :freed
+  MescheProfileValue value = PROFILE_LIVE_BYTES;
+  if (arg_count == 2 && IS_KEYWORD(args[1])) {
+    const char *name = AS_KEYWORD(args[1])->string.chars;
+    if (strcmp(name, "allocated") == 0) {
+      value = PROFILE_ALLOCATED_BYTES;
+    } else if (strcmp(name, "freed") == 0) {
+      value = PROFILE_FREED_BYTES;
+    }
+  }
+
+  if (file_path == NULL) {
+    return FALSE_VAL;
+  }
+
+  FILE *fp = fopen(file_path->chars, "w");
+  if (fp == NULL) {
+    return FALSE_VAL;
+  }
+
+  bool written = mesche_profiler_write(vm, fp, value);
+  fclose(fp);
+
+  return BOOL_VAL(written);
+}
+
+void mesche_profiler_module_init(VM *vm) {
+  mesche_vm_define_native_funcs(
+      vm, "mesche profiler",
+      (MescheNativeFuncDetails[]){{"profiler-start", profiler_start_msc, true},
+                                  {"profiler-stop", profiler_stop_msc, true},
+                                  {"profiler-write", profiler_write_msc, true},
+                                  {NULL, NULL, false}});
+}
@@ -0,0 +1,80 @@
+#ifndef mesche_profiler_h
+#define mesche_profiler_h
+
+#include <stdio.h>
+
+#include "object.h"
+#include "vm.h"
+
+// The average number of bytes allocated between samples by default
+#define PROFILER_DEFAULT_SAMPLE_RATE (512 * 1024)
+
+typedef enum {
+  PROFILE_ALLOCATED_BYTES,
+  PROFILE_LIVE_BYTES,
+  PROFILE_FREED_BYTES
+} MescheProfileValue;
+
+// An allocation site is identified by the call stack that allocated, stored
+// in folded form: the frames from outermost to innermost separated by `;`.
+// Byte counts are estimates scaled up from the sampled allocations.
+typedef struct ProfileSite {
+  char *stack;
+  uint32_t hash;
+  size_t sample_count;
+  size_t allocated_bytes;
+  size_t live_bytes;
+  size_t freed_bytes;
+} ProfileSite;
+
+// A sampled object that hasn't been collected yet
+typedef struct ProfileSample {
+  Object *object;
+  int site_index;
+  size_t bytes;
+} ProfileSample;
+
+typedef struct MescheProfiler {
+  bool is_sampling;
+  size_t sample_rate;
+  int64_t bytes_until_sample;
+  uint64_t random_state;
+
+  ProfileSite *sites;
+  int site_count;
+  int site_capacity;
+
+  // Open-addressed index of the sites by the hash of their stacks
+  int *site_slots;
+  int site_slot_capacity;
+
+  ProfileSample *samples;
+  int sample_count;
+  int sample_capacity;
+
+  // Scratch space for building folded stacks
+  char *stack_buffer;
+  size_t stack_buffer_capacity;
+} MescheProfiler;
+
+void mesche_profiler_start(VM *vm, size_t sample_rate);
+void mesche_profiler_stop(VM *vm);
+void mesche_profiler_free(VM *vm);
+void mesche_profiler_sample(VM *vm, Object *object, size_t size);
+void mesche_profiler_sweep(VM *vm);
+bool mesche_profiler_write(VM *vm, FILE *fp, MescheProfileValue value);
+void mesche_profiler_module_init(VM *vm);
+
+// Counts an allocation toward the next sample.  Must be called after the
+// object's header is initialized but can't allocate.
+static inline void mesche_profiler_count(VM *vm, MescheProfiler *profiler, Object *object,
+                                         size_t size) {
+  if (profiler->is_sampling) {
+    profiler->bytes_until_sample -= size;
+    if (profiler->bytes_until_sample <= 0) {
+      mesche_profiler_sample(vm, object, size);
+    }
+  }
+}
+
+#endif
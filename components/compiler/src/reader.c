@@ -2,7 +2,9 @@
 #include <stdlib.h>
 
 #include "array.h"
+#include "gc.h"
 #include "keyword.h"
+#include "math.h"
 #include "native.h"
 #include "object.h"
 #include "reader.h"
@@ -101,6 +103,7 @@ Value mesche_reader_read_next(Reader *reader) {
       ObjectSyntax *value_syntax;                                                                  \
       SYNTAX(value_syntax, value, token)                                                           \
       current_cons->cdr = OBJECT_VAL(value_syntax);                                                \
+      mesche_gc_write_barrier(reader->vm, (Object *)current_cons);                                 \
       is_cons_dotted = false;                                                                      \
     } else {                                                                                       \
       /* Add the value to the end of the existing list. */                                         \
@@ -113,6 +116,7 @@ Value mesche_reader_read_next(Reader *reader) {
       mesche_vm_stack_push(reader->vm, OBJECT_VAL(next_cons));                                     \
       SYNTAX(cons_syntax, OBJECT_VAL(next_cons), token)                                            \
       current_cons->cdr = OBJECT_VAL(cons_syntax);                                                 \
+      mesche_gc_write_barrier(reader->vm, (Object *)current_cons);                                 \
       current_cons = next_cons;                                                                    \
       mesche_vm_stack_pop(reader->vm);                                                             \
       mesche_vm_stack_pop(reader->vm);                                                             \
@@ -122,6 +126,7 @@ Value mesche_reader_read_next(Reader *reader) {
     ObjectSyntax *value_syntax;                                                                    \
     SYNTAX(value_syntax, value, token)                                                             \
     current_head->car = OBJECT_VAL(value_syntax);                                                  \
+    mesche_gc_write_barrier(reader->vm, (Object *)current_head);                                   \
     current_cons = current_head;                                                                   \
   } else {                                                                                         \
     /* Simply return the value wrapped in a syntax object. */                                      \
@@ -160,11 +165,13 @@ Value mesche_reader_read_next(Reader *reader) {
 
     // Which kind of token is it?
     if (current.kind == TokenKindTrue) {
-      FINISH(TRUE_VAL, current);
+      Value boolean = TRUE_VAL;
+      FINISH(boolean, current);
     } else if (current.kind == TokenKindFalse) {
-      FINISH(FALSE_VAL, current);
+      Value boolean = FALSE_VAL;
+      FINISH(boolean, current);
     } else if (current.kind == TokenKindNumber) {
-      Value number = NUMBER_VAL(strtod(current.start, NULL));
+      Value number = mesche_number_from_string(current.start);
       FINISH(number, current);
     } else if (current.kind == TokenKindCharacter) {
       Value character = reader_interpret_char_literal(current);
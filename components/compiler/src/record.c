@@ -1,28 +1,48 @@
+#include <string.h>
+
+#include "gc.h"
 #include "mem.h"
 #include "record.h"
+#include "vm-impl.h"
 
 ObjectRecord *mesche_object_make_record(VM *vm, ObjectString *name) {
   ObjectRecord *record = ALLOC_OBJECT(vm, ObjectRecord, ObjectKindRecord);
   record->name = name;
   mesche_value_array_init(&record->fields);
+  mesche_value_array_init(&record->field_defaults);
 
   return record;
 }
 
 void mesche_free_record(VM *vm, ObjectRecord *record) {
   mesche_value_array_free((MescheMemory *)vm, &record->fields);
-  FREE(vm, ObjectRecord, record);
+  mesche_value_array_free((MescheMemory *)vm, &record->field_defaults);
+  FREE_OBJECT(vm, record);
 }
 
 ObjectRecordField *mesche_object_make_record_field(VM *vm, ObjectString *name,
                                                    Value default_value) {
+  // Intern the keyword used to pass the field's value to the record constructor
+  ObjectKeyword *keyword = mesche_object_make_keyword(vm, name->chars, name->length);
+  mesche_vm_stack_push(vm, OBJECT_VAL(keyword));
+
   ObjectRecordField *field = ALLOC_OBJECT(vm, ObjectRecordField, ObjectKindRecordField);
   field->name = name;
+  field->keyword = keyword;
   field->default_value = default_value;
 
+  mesche_vm_stack_pop(vm);
+
   return field;
 }
 
+void mesche_record_field_add(VM *vm, ObjectRecord *record, ObjectRecordField *field) {
+  field->field_index = record->fields.count;
+  mesche_value_array_write((MescheMemory *)vm, &record->fields, OBJECT_VAL(field));
+  mesche_value_array_write((MescheMemory *)vm, &record->field_defaults, field->default_value);
+  mesche_gc_write_barrier(vm, (Object *)record);
+}
+
 ObjectRecordFieldAccessor *mesche_object_make_record_accessor(VM *vm, ObjectRecord *record_type,
                                                               int field_index) {
   ObjectRecordFieldAccessor *accessor =
@@ -44,13 +64,23 @@ ObjectRecordFieldSetter *mesche_object_make_record_setter(VM *vm, ObjectRecord *
 }
 
 ObjectRecordInstance *mesche_object_make_record_instance(VM *vm, ObjectRecord *record_type) {
-  ObjectRecordInstance *instance = ALLOC_OBJECT(vm, ObjectRecordInstance, ObjectKindRecordInstance);
+  // The field values are stored inline after the instance's fields and start
+  // out with the record type's defaults
+  int field_count = record_type->field_defaults.count;
+  ObjectRecordInstance *instance = ALLOC_OBJECT_EX(vm, ObjectRecordInstance,
+                                                   sizeof(Value) * field_count,
+                                                   ObjectKindRecordInstance);
   instance->record_type = record_type;
-  mesche_value_array_init(&instance->field_values);
+  instance->field_count = field_count;
+  memcpy(instance->field_values, record_type->field_defaults.values, sizeof(Value) * field_count);
 
   return instance;
 }
 
+void mesche_free_record_instance(VM *vm, ObjectRecordInstance *instance) {
+  FREE_OBJECT(vm, instance);
+}
+
 ObjectRecordPredicate *mesche_object_make_record_predicate(VM *vm, ObjectRecord *record_type) {
   ObjectRecordPredicate *predicate =
       ALLOC_OBJECT(vm, ObjectRecordPredicate, ObjectKindRecordPredicate);
@@ -1,6 +1,7 @@
 #ifndef mesche_record_h
 #define mesche_record_h
 
+#include "keyword.h"
 #include "object.h"
 #include "string.h"
 #include "vm.h"
@@ -23,9 +24,13 @@
 #define IS_RECORD_PREDICATE(value) mesche_object_is_kind(value, ObjectKindRecordPredicate)
 #define AS_RECORD_PREDICATE(value) ((ObjectRecordPredicate *)AS_OBJECT(value))
 
+// A record type's fields are kept in declaration order.  `field_defaults` holds
+// the default value of each field in the same order and is copied wholesale
+// into every new instance before the constructor's arguments are applied.
 typedef struct ObjectRecord {
   Object object;
   ValueArray fields;
+  ValueArray field_defaults;
   ObjectString *name;
 } ObjectRecord;
 
@@ -46,12 +51,14 @@ typedef struct ObjectRecordField {
   Value default_value;
   int field_index;
   ObjectString *name;
+  ObjectKeyword *keyword;
 } ObjectRecordField;
 
 typedef struct ObjectRecordInstance {
   Object object;
-  ValueArray field_values;
   ObjectRecord *record_type;
+  int field_count;
+  Value field_values[];
 } ObjectRecordInstance;
 
 typedef struct ObjectRecordPredicate {
@@ -63,11 +70,13 @@ ObjectRecord *mesche_object_make_record(VM *vm, ObjectString *name);
 void mesche_free_record(VM *vm, ObjectRecord *record);
 
 ObjectRecordField *mesche_object_make_record_field(VM *vm, ObjectString *name, Value default_value);
+void mesche_record_field_add(VM *vm, ObjectRecord *record, ObjectRecordField *field);
 ObjectRecordFieldAccessor *mesche_object_make_record_accessor(VM *vm, ObjectRecord *record_type,
                                                               int field_index);
 ObjectRecordFieldSetter *mesche_object_make_record_setter(VM *vm, ObjectRecord *record_type,
                                                           int field_index);
 ObjectRecordInstance *mesche_object_make_record_instance(VM *vm, ObjectRecord *record_type);
+void mesche_free_record_instance(VM *vm, ObjectRecordInstance *instance);
 ObjectRecordPredicate *mesche_object_make_record_predicate(VM *vm, ObjectRecord *record_type);
 
 #endif
@@ -0,0 +1,733 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "closure.h"
+#include "function.h"
+#include "gc.h"
+#include "keyword.h"
+#include "module.h"
+#include "native.h"
+#include "record.h"
+#include "snapshot.h"
+#include "symbol.h"
+#include "util.h"
+#include "vm-impl.h"
+
+typedef struct SnapshotWriter {
+  VM *vm;
+  FILE *fp;
+  uint64_t object_count;
+
+  // Scratch space for the references of the object being written
+  uint64_t *references;
+  uint32_t reference_count;
+  uint32_t reference_capacity;
+
+  SnapshotRoot *roots;
+  size_t root_count;
+  size_t root_capacity;
+  uint8_t root_kind;
+  const char *root_label;
+} SnapshotWriter;
+
+static void snapshot_write_u8(FILE *fp, uint8_t value) { fwrite(&value, sizeof(value), 1, fp); }
+static void snapshot_write_u16(FILE *fp, uint16_t value) { fwrite(&value, sizeof(value), 1, fp); }
+static void snapshot_write_u32(FILE *fp, uint32_t value) { fwrite(&value, sizeof(value), 1, fp); }
+static void snapshot_write_u64(FILE *fp, uint64_t value) { fwrite(&value, sizeof(value), 1, fp); }
+
+static void snapshot_write_chars(FILE *fp, const char *chars) {
+  size_t length = chars != NULL ? strlen(chars) : 0;
+  if (length > HEAP_SNAPSHOT_MAX_NAME) {
+    length = HEAP_SNAPSHOT_MAX_NAME;
+  }
+
+  snapshot_write_u16(fp, length);
+  if (length > 0) {
+    fwrite(chars, 1, length, fp);
+  }
+}
+
+static const char *snapshot_object_name(Object *object) {
+  ObjectString *name = NULL;
+  switch (object->kind) {
+  case ObjectKindString:
+    return ((ObjectString *)object)->chars;
+  case ObjectKindKeyword:
+    return ((ObjectKeyword *)object)->string.chars;
+  case ObjectKindSymbol:
+    name = ((ObjectSymbol *)object)->name;
+    break;
+  case ObjectKindModule:
+    name = ((ObjectModule *)object)->name;
+    break;
+  case ObjectKindFunction:
+    name = ((ObjectFunction *)object)->name;
+    break;
+  case ObjectKindClosure:
+    name = ((ObjectClosure *)object)->function->name;
+    break;
+  case ObjectKindRecord:
+    name = ((ObjectRecord *)object)->name;
+    break;
+  case ObjectKindRecordInstance:
+    name = ((ObjectRecordInstance *)object)->record_type->name;
+    break;
+  default:
+    break;
+  }
+
+  return name != NULL ? name->chars : NULL;
+}
+
+static void snapshot_count_object(void *cell, size_t cell_size, void *context) {
+  ((SnapshotWriter *)context)->object_count++;
+}
+
+static void snapshot_add_reference(Object *object, void *context) {
+  SnapshotWriter *writer = (SnapshotWriter *)context;
+  if (writer->reference_capacity < writer->reference_count + 1) {
+    writer->reference_capacity = GROW_CAPACITY(writer->reference_capacity);
+    writer->references =
+        realloc(writer->references, sizeof(uint64_t) * writer->reference_capacity);
+    if (writer->references == NULL) {
+      PANIC("Heap snapshot's references could not be reallocated.");
+    }
+  }
+
+  writer->references[writer->reference_count++] = (uint64_t)(uintptr_t)object;
+}
+
+static void snapshot_write_object(void *cell, size_t cell_size, void *context) {
+  SnapshotWriter *writer = (SnapshotWriter *)context;
+  Object *object = (Object *)cell;
+
+  writer->reference_count = 0;
+  mesche_gc_visit_references(writer->vm, object, snapshot_add_reference, writer);
+
+  snapshot_write_u64(writer->fp, (uint64_t)(uintptr_t)object);
+  snapshot_write_u8(writer->fp, object->kind);
+  snapshot_write_u32(writer->fp, cell_size);
+  snapshot_write_chars(writer->fp, snapshot_object_name(object));
+  snapshot_write_u32(writer->fp, writer->reference_count);
+  fwrite(writer->references, sizeof(uint64_t), writer->reference_count, writer->fp);
+}
+
+static void snapshot_add_root(Object *object, void *context) {
+  SnapshotWriter *writer = (SnapshotWriter *)context;
+  if (writer->root_capacity < writer->root_count + 1) {
+    writer->root_capacity = GROW_CAPACITY(writer->root_capacity);
+    writer->roots = realloc(writer->roots, sizeof(SnapshotRoot) * writer->root_capacity);
+    if (writer->roots == NULL) {
+      PANIC("Heap snapshot's roots could not be reallocated.");
+    }
+  }
+
+  // Labels aren't owned by the writer, they only need to live until the
+  // roots are written
+  writer->roots[writer->root_count++] =
+      (SnapshotRoot){.address = (uint64_t)(uintptr_t)object,
+                     .kind = writer->root_kind,
+                     .label = (char *)writer->root_label,
+                     .object_index = -1};
+}
+
+// Finds the roots that can be labeled more usefully than "vm" first, then
+// adds every root the collector marks so that nothing is missed.  Roots
+// that show up twice are harmless.
+static void snapshot_find_roots(SnapshotWriter *writer) {
+  VM *vm = writer->vm;
+
+  writer->root_kind = SNAPSHOT_ROOT_MODULE;
+  for (int i = 0; i < vm->modules.capacity; i++) {
+    Entry *entry = &vm->modules.entries[i];
+    if (entry->key != NULL && IS_MODULE(entry->value)) {
+      writer->root_label = entry->key->chars;
+      snapshot_add_root(AS_OBJECT(entry->value), writer);
+    }
+  }
+
+  writer->root_kind = SNAPSHOT_ROOT_FRAME;
+  for (int i = 0; i < vm->frame_count; i++) {
+    ObjectFunction *function = vm->frames[i].closure->function;
+    writer->root_label = function->name != NULL ? function->name->chars : "frame";
+    snapshot_add_root((Object *)vm->frames[i].closure, writer);
+  }
+
+  writer->root_kind = SNAPSHOT_ROOT_STACK;
+  writer->root_label = "stack";
+  for (Value *slot = vm->stack; slot < vm->stack_top; slot++) {
+    if (IS_OBJECT(*slot)) {
+      snapshot_add_root(AS_OBJECT(*slot), writer);
+    }
+  }
+
+  writer->root_kind = SNAPSHOT_ROOT_UPVALUE;
+  writer->root_label = "upvalue";
+  for (ObjectUpvalue *upvalue = vm->open_upvalues; upvalue != NULL; upvalue = upvalue->next) {
+    snapshot_add_root((Object *)upvalue, writer);
+  }
+
+  writer->root_kind = SNAPSHOT_ROOT_VM;
+  writer->root_label = "vm";
+  mesche_gc_visit_roots(vm, snapshot_add_root, writer);
+}
+
+// Collects garbage and then writes every object that survived to the file
+bool mesche_heap_snapshot_write(VM *vm, const char *file_path) {
+  FILE *fp = fopen(file_path, "wb");
+  if (fp == NULL) {
+    return false;
+  }
+
+#ifdef MESCHE_GENERATIONAL_GC
+  // Make sure that dead objects in the old generation are collected too
+  vm->next_major_gc = 0;
+#endif
+  mesche_mem_collect_garbage((MescheMemory *)vm);
+
+  SnapshotWriter writer = {.vm = vm, .fp = fp};
+  mesche_heap_walk(&vm->mem.heap, snapshot_count_object, &writer);
+  snapshot_find_roots(&writer);
+
+  fwrite(HEAP_SNAPSHOT_MAGIC, 1, strlen(HEAP_SNAPSHOT_MAGIC), fp);
+  snapshot_write_u32(fp, HEAP_SNAPSHOT_VERSION);
+  snapshot_write_u64(fp, writer.object_count);
+  snapshot_write_u64(fp, writer.root_count);
+
+  mesche_heap_walk(&vm->mem.heap, snapshot_write_object, &writer);
+
+  for (size_t i = 0; i < writer.root_count; i++) {
+    snapshot_write_u64(fp, writer.roots[i].address);
+    snapshot_write_u8(fp, writer.roots[i].kind);
+    snapshot_write_chars(fp, writer.roots[i].label);
+  }
+
+  free(writer.references);
+  free(writer.roots);
+
+  bool failed = ferror(fp);
+  return fclose(fp) == 0 && !failed;
+}
+
+static bool snapshot_read(FILE *fp, void *value, size_t size) {
+  return fread(value, size, 1, fp) == 1;
+}
+
+static bool snapshot_read_chars(FILE *fp, char **chars) {
+  uint16_t length = 0;
+  if (!snapshot_read(fp, &length, sizeof(length))) {
+    return false;
+  }
+
+  *chars = NULL;
+  if (length > 0) {
+    *chars = malloc(length + 1);
+    if (*chars == NULL || fread(*chars, 1, length, fp) != length) {
+      return false;
+    }
+    (*chars)[length] = '\0';
+  }
+
+  return true;
+}
+
+typedef struct SnapshotAddress {
+  uint64_t address;
+  int index;
+} SnapshotAddress;
+
+static int snapshot_compare_addresses(const void *left, const void *right) {
+  uint64_t left_address = ((const SnapshotAddress *)left)->address;
+  uint64_t right_address = ((const SnapshotAddress *)right)->address;
+  return left_address < right_address ? -1 : left_address > right_address;
+}
+
+static int snapshot_find_object(SnapshotAddress *addresses, size_t count, uint64_t address) {
+  SnapshotAddress key = {.address = address};
+  SnapshotAddress *found =
+      bsearch(&key, addresses, count, sizeof(SnapshotAddress), snapshot_compare_addresses);
+  return found != NULL ? found->index : -1;
+}
+
+// Reads a snapshot and resolves the addresses it contains to object indices.
+// Returns NULL if the file can't be read or isn't a heap snapshot.
+MescheHeapSnapshot *mesche_heap_snapshot_read(const char *file_path) {
+  FILE *fp = fopen(file_path, "rb");
+  if (fp == NULL) {
+    return NULL;
+  }
+
+  MescheHeapSnapshot *snapshot = calloc(1, sizeof(MescheHeapSnapshot));
+  if (snapshot == NULL) {
+    PANIC("Heap snapshot could not be allocated.");
+  }
+
+  char magic[sizeof(HEAP_SNAPSHOT_MAGIC) - 1];
+  uint32_t version = 0;
+  uint64_t object_count = 0, root_count = 0;
+  bool valid = snapshot_read(fp, magic, sizeof(magic)) &&
+               memcmp(magic, HEAP_SNAPSHOT_MAGIC, sizeof(magic)) == 0 &&
+               snapshot_read(fp, &version, sizeof(version)) &&
+               version == HEAP_SNAPSHOT_VERSION &&
+               snapshot_read(fp, &object_count, sizeof(object_count)) &&
+               snapshot_read(fp, &root_count, sizeof(root_count)) && object_count < INT32_MAX;
+
+  // References are read as addresses first and resolved once every object
+  // is known
+  uint64_t *reference_addresses = NULL;
+  size_t reference_capacity = 0;
+  if (valid) {
+    snapshot->objects = calloc(object_count, sizeof(SnapshotObject));
+    snapshot->roots = calloc(root_count, sizeof(SnapshotRoot));
+    valid = (snapshot->objects != NULL || object_count == 0) &&
+            (snapshot->roots != NULL || root_count == 0);
+  }
+
+  for (uint64_t i = 0; valid && i < object_count; i++) {
+    SnapshotObject *object = &snapshot->objects[i];
+    valid = snapshot_read(fp, &object->address, sizeof(object->address)) &&
+            snapshot_read(fp, &object->kind, sizeof(object->kind)) &&
+            snapshot_read(fp, &object->size, sizeof(object->size)) &&
+            snapshot_read_chars(fp, &object->name) &&
+            snapshot_read(fp, &object->reference_count, sizeof(object->reference_count));
+    if (!valid) {
+      break;
+    }
+
+    snapshot->object_count++;
+    object->reference_start = snapshot->reference_count;
+    if (reference_capacity < snapshot->reference_count + object->reference_count) {
+      reference_capacity = (snapshot->reference_count + object->reference_count) * 2;
+      reference_addresses = realloc(reference_addresses, sizeof(uint64_t) * reference_capacity);
+      if (reference_addresses == NULL) {
+        PANIC("Heap snapshot's references could not be reallocated.");
+      }
+    }
+
+    valid = fread(reference_addresses + snapshot->reference_count, sizeof(uint64_t),
+                  object->reference_count, fp) == object->reference_count;
+    snapshot->reference_count += object->reference_count;
+  }
+
+  for (uint64_t i = 0; valid && i < root_count; i++) {
+    SnapshotRoot *root = &snapshot->roots[i];
+    valid = snapshot_read(fp, &root->address, sizeof(root->address)) &&
+            snapshot_read(fp, &root->kind, sizeof(root->kind)) &&
+            snapshot_read_chars(fp, &root->label);
+    snapshot->root_count += valid ? 1 : 0;
+  }
+
+  fclose(fp);
+  if (!valid) {
+    free(reference_addresses);
+    mesche_heap_snapshot_free(snapshot);
+    return NULL;
+  }
+
+  SnapshotAddress *addresses = malloc(sizeof(SnapshotAddress) * (snapshot->object_count + 1));
+  snapshot->references = malloc(sizeof(int) * (snapshot->reference_count + 1));
+  if (addresses == NULL || snapshot->references == NULL) {
+    PANIC("Heap snapshot's index could not be allocated.");
+  }
+
+  for (size_t i = 0; i < snapshot->object_count; i++) {
+    addresses[i] = (SnapshotAddress){.address = snapshot->objects[i].address, .index = i};
+  }
+  qsort(addresses, snapshot->object_count, sizeof(SnapshotAddress), snapshot_compare_addresses);
+
+  // References to objects that aren't in the snapshot are dropped
+  size_t kept_count = 0;
+  for (size_t i = 0; i < snapshot->object_count; i++) {
+    SnapshotObject *object = &snapshot->objects[i];
+    size_t start = object->reference_start;
+    object->reference_start = kept_count;
+    for (uint32_t j = 0; j < object->reference_count; j++) {
+      int index = snapshot_find_object(addresses, snapshot->object_count,
+                                       reference_addresses[start + j]);
+      if (index != -1) {
+        snapshot->references[kept_count++] = index;
+      }
+    }
+    object->reference_count = kept_count - object->reference_start;
+  }
+  snapshot->reference_count = kept_count;
+
+  for (size_t i = 0; i < snapshot->root_count; i++) {
+    snapshot->roots[i].object_index =
+        snapshot_find_object(addresses, snapshot->object_count, snapshot->roots[i].address);
+  }
+
+  free(addresses);
+  free(reference_addresses);
+  return snapshot;
+}
+
+static int snapshot_intersect(int *dominators, int *postorder, int left, int right) {
+  while (left != right) {
+    while (postorder[left] < postorder[right]) {
+      left = dominators[left];
+    }
+    while (postorder[right] < postorder[left]) {
+      right = dominators[right];
+    }
+  }
+
+  return left;
+}
+
+// Computes the dominator tree of the objects using the iterative algorithm
+// from Cooper, Harvey and Kennedy's "A Simple, Fast Dominance Algorithm".  A
+// virtual root node that points to every root is added so that the graph has
+// a single entry.
+void mesche_heap_snapshot_analyze(MescheHeapSnapshot *snapshot) {
+  int node_count = snapshot->object_count + 1;
+  int super_root = snapshot->object_count;
+
+  // Give every node a list of successors, where the virtual root's are the
+  // roots of the snapshot
+  int *successor_starts = malloc(sizeof(int) * (node_count + 1));
+  int *successors = malloc(sizeof(int) * (snapshot->reference_count + snapshot->root_count + 1));
+  int *postorder = malloc(sizeof(int) * node_count);
+  int *order = malloc(sizeof(int) * node_count);
+  int *stack = malloc(sizeof(int) * node_count);
+  int *stack_edges = malloc(sizeof(int) * node_count);
+  int *predecessor_starts = calloc(node_count + 1, sizeof(int));
+  int *root_indices = malloc(sizeof(int) * node_count);
+  snapshot->dominators = malloc(sizeof(int) * node_count);
+  snapshot->retained_sizes = calloc(node_count, sizeof(size_t));
+  snapshot->root_of = malloc(sizeof(int) * node_count);
+  if (successor_starts == NULL || successors == NULL || postorder == NULL || order == NULL ||
+      stack == NULL || stack_edges == NULL || predecessor_starts == NULL ||
+      root_indices == NULL || snapshot->dominators == NULL ||
+      snapshot->retained_sizes == NULL || snapshot->root_of == NULL) {
+    PANIC("Heap snapshot analysis could not be allocated.");
+  }
+
+  int successor_count = 0;
+  for (size_t i = 0; i < snapshot->object_count; i++) {
+    SnapshotObject *object = &snapshot->objects[i];
+    successor_starts[i] = successor_count;
+    memcpy(successors + successor_count, snapshot->references + object->reference_start,
+           sizeof(int) * object->reference_count);
+    successor_count += object->reference_count;
+  }
+
+  // The first root that reaches an object directly is the one it's reported
+  // under
+  successor_starts[super_root] = successor_count;
+  for (int i = 0; i < node_count; i++) {
+    root_indices[i] = -1;
+  }
+  for (size_t i = 0; i < snapshot->root_count; i++) {
+    int index = snapshot->roots[i].object_index;
+    if (index != -1 && root_indices[index] == -1) {
+      root_indices[index] = i;
+      successors[successor_count++] = index;
+    }
+  }
+  successor_starts[node_count] = successor_count;
+
+  // Number the reachable nodes in postorder with a depth-first search
+  for (int i = 0; i < node_count; i++) {
+    postorder[i] = -1;
+    snapshot->dominators[i] = -1;
+  }
+
+  int order_count = 0;
+  int stack_count = 0;
+  stack[stack_count] = super_root;
+  stack_edges[stack_count++] = successor_starts[super_root];
+  postorder[super_root] = -2;
+  while (stack_count > 0) {
+    int node = stack[stack_count - 1];
+    int edge = stack_edges[stack_count - 1];
+    if (edge < successor_starts[node + 1]) {
+      stack_edges[stack_count - 1]++;
+      int successor = successors[edge];
+      if (postorder[successor] == -1) {
+        postorder[successor] = -2;
+        stack[stack_count] = successor;
+        stack_edges[stack_count++] = successor_starts[successor];
+      }
+    } else {
+      postorder[node] = order_count;
+      order[order_count++] = node;
+      stack_count--;
+    }
+  }
+
+  // Collect the predecessors of the reachable nodes
+  for (int i = 0; i < order_count; i++) {
+    int node = order[i];
+    for (int edge = successor_starts[node]; edge < successor_starts[node + 1]; edge++) {
+      predecessor_starts[successors[edge] + 1]++;
+    }
+  }
+  for (int i = 0; i < node_count; i++) {
+    predecessor_starts[i + 1] += predecessor_starts[i];
+  }
+
+  int *predecessors = malloc(sizeof(int) * (predecessor_starts[node_count] + 1));
+  if (predecessors == NULL) {
+    PANIC("Heap snapshot analysis could not be allocated.");
+  }
+
+  // Reuse the stack as the insertion point of each node's predecessors
+  memcpy(stack, predecessor_starts, sizeof(int) * node_count);
+  for (int i = 0; i < order_count; i++) {
+    int node = order[i];
+    for (int edge = successor_starts[node]; edge < successor_starts[node + 1]; edge++) {
+      predecessors[stack[successors[edge]]++] = node;
+    }
+  }
+
+  // Refine the dominators in reverse postorder until nothing changes
+  int *dominators = snapshot->dominators;
+  dominators[super_root] = super_root;
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (int i = order_count - 2; i >= 0; i--) {
+      int node = order[i];
+      int dominator = -1;
+      for (int edge = predecessor_starts[node]; edge < predecessor_starts[node + 1]; edge++) {
+        int predecessor = predecessors[edge];
+        if (dominators[predecessor] != -1) {
+          dominator = dominator == -1
+                          ? predecessor
+                          : snapshot_intersect(dominators, postorder, predecessor, dominator);
+        }
+      }
+
+      if (dominators[node] != dominator) {
+        dominators[node] = dominator;
+        changed = true;
+      }
+    }
+  }
+
+  // Dominators come later in postorder than the nodes they dominate, so
+  // each node's retained size is final by the time it's added to its
+  // dominator's
+  snapshot->reachable_size = 0;
+  for (int i = 0; i < order_count - 1; i++) {
+    int node = order[i];
+    snapshot->retained_sizes[node] += snapshot->objects[node].size;
+    snapshot->reachable_size += snapshot->objects[node].size;
+    if (dominators[node] != super_root) {
+      snapshot->retained_sizes[dominators[node]] += snapshot->retained_sizes[node];
+    }
+  }
+
+  // Attribute every object to the root its dominator chain starts from
+  for (int i = 0; i < node_count; i++) {
+    snapshot->root_of[i] = -1;
+  }
+  for (int i = order_count - 2; i >= 0; i--) {
+    int node = order[i];
+    snapshot->root_of[node] =
+        dominators[node] == super_root ? root_indices[node] : snapshot->root_of[dominators[node]];
+  }
+
+  // Objects that are only dominated by the virtual root have no dominator
+  for (int i = 0; i < node_count; i++) {
+    if (dominators[i] == super_root) {
+      dominators[i] = -1;
+    }
+  }
+
+  free(successor_starts);
+  free(successors);
+  free(postorder);
+  free(order);
+  free(stack);
+  free(stack_edges);
+  free(predecessor_starts);
+  free(predecessors);
+  free(root_indices);
+}
+
+static const char *snapshot_kind_name(uint8_t kind) {
+  return kind < OBJECT_KIND_COUNT ? mesche_object_kind_name(kind) : "unknown";
+}
+
+static void snapshot_print_object(FILE *fp, SnapshotObject *object) {
+  fprintf(fp, "%s", snapshot_kind_name(object->kind));
+  if (object->name != NULL) {
+    fprintf(fp, " \"%s\"", object->name);
+  }
+}
+
+static MescheHeapSnapshot *sorting_snapshot = NULL;
+
+static int snapshot_compare_retained(const void *left, const void *right) {
+  size_t left_size = sorting_snapshot->retained_sizes[*(const int *)left];
+  size_t right_size = sorting_snapshot->retained_sizes[*(const int *)right];
+  return left_size > right_size ? -1 : left_size < right_size;
+}
+
+// Prints a summary of the snapshot: the objects by kind, how much memory each
+// module retains and the objects that retain the most, each with the chain of
+// dominators that keeps it alive.  The snapshot must have been analyzed.
+void mesche_heap_snapshot_report(MescheHeapSnapshot *snapshot, FILE *fp, int top_count) {
+  size_t total_size = 0;
+  size_t kind_counts[UINT8_MAX + 1] = {0};
+  size_t kind_sizes[UINT8_MAX + 1] = {0};
+  for (size_t i = 0; i < snapshot->object_count; i++) {
+    SnapshotObject *object = &snapshot->objects[i];
+    total_size += object->size;
+    kind_counts[object->kind]++;
+    kind_sizes[object->kind] += object->size;
+  }
+
+  fprintf(fp, "Heap snapshot: %zu objects, %zu bytes, %zu bytes reachable from %zu roots\n",
+          snapshot->object_count, total_size, snapshot->reachable_size, snapshot->root_count);
+
+  fprintf(fp, "\nObjects by kind:\n");
+  for (int i = 0; i <= UINT8_MAX; i++) {
+    if (kind_counts[i] > 0) {
+      fprintf(fp, "  %-24s %10zu objects %12zu bytes\n", snapshot_kind_name(i), kind_counts[i],
+              kind_sizes[i]);
+    }
+  }
+
+  fprintf(fp, "\nRetained size by module:\n");
+  for (size_t i = 0; i < snapshot->root_count; i++) {
+    SnapshotRoot *root = &snapshot->roots[i];
+    if (root->kind == SNAPSHOT_ROOT_MODULE && root->object_index != -1) {
+      fprintf(fp, "  %-40s %12zu bytes\n", root->label ? root->label : "",
+              snapshot->retained_sizes[root->object_index]);
+    }
+  }
+
+  int *indices = malloc(sizeof(int) * (snapshot->object_count + 1));
+  if (indices == NULL) {
+    PANIC("Heap snapshot report could not be allocated.");
+  }
+
+  for (size_t i = 0; i < snapshot->object_count; i++) {
+    indices[i] = i;
+  }
+  sorting_snapshot = snapshot;
+  qsort(indices, snapshot->object_count, sizeof(int), snapshot_compare_retained);
+  sorting_snapshot = NULL;
+
+  // Objects within a retainer that was already listed are skipped, they
+  // would only repeat its chain.  Since a dominator always retains more than
+  // the objects it dominates it's seen first.
+  bool *is_covered = calloc(snapshot->object_count + 1, sizeof(bool));
+  if (is_covered == NULL) {
+    PANIC("Heap snapshot report could not be allocated.");
+  }
+
+  fprintf(fp, "\nTop retainers:\n");
+  int listed_count = 0;
+  for (size_t i = 0; i < snapshot->object_count && listed_count < top_count; i++) {
+    int index = indices[i];
+    if (snapshot->retained_sizes[index] == 0) {
+      break;
+    }
+
+    int dominator = snapshot->dominators[index];
+    if (dominator != -1 && is_covered[dominator]) {
+      is_covered[index] = true;
+      continue;
+    }
+
+    // Modules are already listed above
+    SnapshotObject *object = &snapshot->objects[index];
+    if (object->kind == ObjectKindModule) {
+      continue;
+    }
+
+    is_covered[index] = true;
+    listed_count++;
+
+    fprintf(fp, "  %12zu bytes  ", snapshot->retained_sizes[index]);
+    snapshot_print_object(fp, object);
+    fprintf(fp, " (%u bytes)\n", object->size);
+
+    // Show the path of dominators from the root down to the object
+    int depth = 0;
+    for (int dominator = snapshot->dominators[index]; dominator != -1 && depth < 8;
+         dominator = snapshot->dominators[dominator], depth++) {
+      fprintf(fp, "      held by ");
+      snapshot_print_object(fp, &snapshot->objects[dominator]);
+      fprintf(fp, "\n");
+    }
+
+    int root_index = snapshot->root_of[index];
+    if (root_index != -1) {
+      SnapshotRoot *root = &snapshot->roots[root_index];
+      fprintf(fp, "      from root %s\n", root->label ? root->label : "");
+    } else {
+      fprintf(fp, "      shared by several roots\n");
+    }
+  }
+
+  free(indices);
+  free(is_covered);
+}
+
+void mesche_heap_snapshot_free(MescheHeapSnapshot *snapshot) {
+  for (size_t i = 0; i < snapshot->object_count; i++) {
+    free(snapshot->objects[i].name);
+  }
+  for (size_t i = 0; i < snapshot->root_count; i++) {
+    free(snapshot->roots[i].label);
+  }
+
+  free(snapshot->objects);
+  free(snapshot->roots);
+  free(snapshot->references);
+  free(snapshot->dominators);
+  free(snapshot->retained_sizes);
+  free(snapshot->root_of);
+  free(snapshot);
+}
+
+Value heap_snapshot_msc(VM *vm, int arg_count, Value *args) {
+  if (arg_count != 1) {
+    PANIC("Function requires 1 parameter.");
+  }
+
+  ObjectString *file_path = NULL;
+  EXPECT_OBJECT_KIND(ObjectKindString, 0, AS_STRING, file_path);
+  if (file_path == NULL) {
+    return FALSE_VAL;
+  }
+
+  return BOOL_VAL(mesche_heap_snapshot_write(vm, file_path->chars));
+}
+
+Value heap_snapshot_report_msc(VM *vm, int arg_count, Value *args) {
+  if (arg_count < 1 || arg_count > 2) {
+    PANIC("Function requires 1 or 2 parameters.");
+  }
+
+  ObjectString *file_path = NULL;
+  EXPECT_OBJECT_KIND(ObjectKindString, 0, AS_STRING, file_path);
+  if (file_path == NULL) {
+    return FALSE_VAL;
+  }
+
+  MescheHeapSnapshot *snapshot = mesche_heap_snapshot_read(file_path->chars);
+  if (snapshot == NULL) {
+    return FALSE_VAL;
+  }
+
+  int top_count = arg_count == 2 ? AS_INTEGER(args[1]) : 20;
+  mesche_heap_snapshot_analyze(snapshot);
+  mesche_heap_snapshot_report(snapshot, stdout, top_count);
+  mesche_heap_snapshot_free(snapshot);
+
+  return TRUE_VAL;
+}
+
+void mesche_snapshot_module_init(VM *vm) {
+  mesche_vm_define_native_funcs(
+      vm, "mesche gc",
+      (MescheNativeFuncDetails[]){{"heap-snapshot", heap_snapshot_msc, true},
+                                  {"heap-snapshot-report", heap_snapshot_report_msc, true},
+                                  {NULL, NULL, false}});
+}
@@ -0,0 +1,77 @@
+#ifndef mesche_snapshot_h
+#define mesche_snapshot_h
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "vm.h"
+
+// A heap snapshot file is written in the byte order of the machine that wrote
+// it and holds, in order:
+//
+//   header:  "MSCHHEAP", u32 version, u64 object count, u64 root count
+//   objects: u64 address, u8 kind, u32 size, u16 name length, name bytes,
+//            u32 reference count, u64 address of each referenced object
+//   roots:   u64 address, u8 root kind, u16 label length, label bytes
+//
+// Names are only written for objects that have one, like strings, symbols,
+// modules and functions.
+#define HEAP_SNAPSHOT_MAGIC "MSCHHEAP"
+#define HEAP_SNAPSHOT_VERSION 1
+#define HEAP_SNAPSHOT_MAX_NAME 64
+
+typedef enum {
+  SNAPSHOT_ROOT_STACK,
+  SNAPSHOT_ROOT_FRAME,
+  SNAPSHOT_ROOT_UPVALUE,
+  SNAPSHOT_ROOT_MODULE,
+  SNAPSHOT_ROOT_VM
+} SnapshotRootKind;
+
+typedef struct SnapshotObject {
+  uint64_t address;
+  uint8_t kind;
+  uint32_t size;
+  char *name;
+  size_t reference_start;
+  uint32_t reference_count;
+} SnapshotObject;
+
+typedef struct SnapshotRoot {
+  uint64_t address;
+  uint8_t kind;
+  char *label;
+  int object_index;
+} SnapshotRoot;
+
+typedef struct MescheHeapSnapshot {
+  SnapshotObject *objects;
+  size_t object_count;
+  SnapshotRoot *roots;
+  size_t root_count;
+
+  // The indices of the objects each object references
+  int *references;
+  size_t reference_count;
+
+  // Filled in by `mesche_heap_snapshot_analyze`.  An object's dominator
+  // is the closest object that every path from the strong roots to it goes
+  // through, or -1 if it's only dominated by the roots themselves.  The
+  // retained size of an object is the memory that would be freed along with
+  // it.  Unreachable objects have a retained size of 0.  `root_of` holds the
+  // index of the root that keeps each object alive, or -1 if there are
+  // several.
+  int *dominators;
+  size_t *retained_sizes;
+  int *root_of;
+  size_t reachable_size;
+} MescheHeapSnapshot;
+
+bool mesche_heap_snapshot_write(VM *vm, const char *file_path);
+MescheHeapSnapshot *mesche_heap_snapshot_read(const char *file_path);
+void mesche_heap_snapshot_analyze(MescheHeapSnapshot *snapshot);
+void mesche_heap_snapshot_report(MescheHeapSnapshot *snapshot, FILE *fp, int top_count);
+void mesche_heap_snapshot_free(MescheHeapSnapshot *snapshot);
+void mesche_snapshot_module_init(VM *vm);
+
+#endif
@@ -1,6 +1,7 @@
 #include <ctype.h>
 #include <stdlib.h>
 
+#include "math.h"
 #include "mem.h"
 #include "native.h"
 #include "object.h"
@@ -81,7 +82,7 @@ ObjectString *mesche_object_make_string(VM *vm, const char *chars, int length) {
 }
 
 void mesche_free_string(VM *vm, ObjectString *string) {
-  FREE_SIZE(vm, string, (sizeof(ObjectString) + string->length + 1));
+  FREE_OBJECT(vm, string);
 }
 
 uint32_t mesche_string_hash(const char *key, int length) {
@@ -138,19 +139,32 @@ ObjectString *mesche_string_join(VM *vm, ObjectString *left, ObjectString *right
 }
 
 Value string_append_msc(VM *vm, int arg_count, Value *args) {
-  // Append all string arguments together
-  ObjectString *result_string = AS_STRING(args[0]);
-  for (int i = 1; i < arg_count; i++) {
-    // Skip all #f's
-    if (IS_FALSE(args[i]))
-      continue;
-
-    mesche_vm_stack_push(vm, OBJECT_VAL(result_string));
-    result_string = mesche_string_join(vm, result_string, AS_STRING(args[i]), NULL);
-    mesche_vm_stack_pop(vm);
+  // Measure all string arguments first so that they can be copied into a
+  // single buffer, skipping all #f's
+  int length = 0;
+  for (int i = 0; i < arg_count; i++) {
+    if (!IS_FALSE(args[i])) {
+      length += AS_STRING(args[i])->length;
+    }
+  }
+
+  char *buffer = malloc(sizeof(char) * (length + 1));
+  if (buffer == NULL) {
+    PANIC("Appended string buffer could not be allocated.");
+  }
+
+  char *copy_ptr = buffer;
+  for (int i = 0; i < arg_count; i++) {
+    if (!IS_FALSE(args[i])) {
+      memcpy(copy_ptr, AS_STRING(args[i])->chars, AS_STRING(args[i])->length);
+      copy_ptr += AS_STRING(args[i])->length;
+    }
   }
 
   // TODO: Support specifying a separator string
+  ObjectString *result_string = mesche_object_make_string(vm, buffer, length);
+  free(buffer);
+
   return OBJECT_VAL(result_string);
 }
 
@@ -197,8 +211,8 @@ Value string_substring_msc(VM *vm, int arg_count, Value *args) {
   ObjectString *str = AS_STRING(args[0]);
 
   // TODO: Verify that end_index is higher than start_index
-  int start_index = AS_NUMBER(args[1]);
-  int end_index = (arg_count > 2) ? AS_NUMBER(args[2]) : strlen(AS_CSTRING(args[0]));
+  int start_index = AS_INTEGER(args[1]);
+  int end_index = (arg_count > 2) ? AS_INTEGER(args[2]) : strlen(AS_CSTRING(args[0]));
 
   return OBJECT_VAL(
       mesche_object_make_string(vm, &str->chars[start_index], end_index - start_index));
@@ -206,7 +220,7 @@ Value string_substring_msc(VM *vm, int arg_count, Value *args) {
 
 Value string_length_msc(VM *vm, int arg_count, Value *args) {
   ObjectString *str = AS_STRING(args[0]);
-  return NUMBER_VAL(strlen(str->chars));
+  return FIXNUM_VAL(strlen(str->chars));
 }
 
 Value string_trim_msc(VM *vm, int arg_count, Value *args) {
@@ -242,14 +256,18 @@ Value string_equal_msc(VM *vm, int arg_count, Value *args) {
 
 Value string_number_to_string_msc(VM *vm, int arg_count, Value *args) {
   char buffer[256];
-  int decimal_places = arg_count > 1 ? (int)AS_NUMBER(args[1]) : 0;
-  sprintf(buffer, "%.*f", decimal_places, AS_NUMBER(args[0]));
+  int decimal_places = arg_count > 1 ? (int)AS_INTEGER(args[1]) : 0;
+  if (IS_FIXNUM(args[0]) && decimal_places == 0) {
+    sprintf(buffer, "%lld", (long long)AS_FIXNUM(args[0]));
+  } else {
+    sprintf(buffer, "%.*f", decimal_places, AS_NUMBER(args[0]));
+  }
   return OBJECT_VAL(mesche_object_make_string(vm, buffer, strlen(buffer)));
 }
 
 Value string_string_to_number_msc(VM *vm, int arg_count, Value *args) {
   ObjectString *str = AS_STRING(args[0]);
-  return NUMBER_VAL(atof(str->chars));
+  return mesche_number_from_string(str->chars);
 }
 
 void mesche_string_module_init(VM *vm) {
@@ -1,7 +1,7 @@
 #include "symbol.h"
 #include "vm-impl.h"
 
-void mesche_free_symbol(VM *vm, ObjectSymbol *symbol) { FREE(vm, ObjectSymbol, symbol); }
+void mesche_free_symbol(VM *vm, ObjectSymbol *symbol) { FREE_OBJECT(vm, symbol); }
 
 ObjectSymbol *mesche_object_make_symbol(VM *vm, const char *chars, int length) {
   // Is the symbol name already interned?
@@ -20,7 +20,7 @@ ObjectSyntax *mesche_object_make_syntax(VM *vm, uint32_t line, uint32_t column,
   return syntax;
 }
 
-void mesche_free_syntax(VM *vm, ObjectSyntax *syntax) { FREE(vm, ObjectSyntax, syntax); }
+void mesche_free_syntax(VM *vm, ObjectSyntax *syntax) { FREE_OBJECT(vm, syntax); }
 
 static void mesche_syntax_print_value(MeschePort *port, Value value, MeschePrintStyle style) {
   if (IS_SYNTAX(value)) {
@@ -89,7 +89,7 @@ Value syntax_line_msc(VM *vm, int arg_count, Value *args) {
   }
 
   ObjectSyntax *syntax = AS_SYNTAX(args[0]);
-  return NUMBER_VAL(syntax->line);
+  return FIXNUM_VAL(syntax->line);
 }
 
 Value syntax_column_msc(VM *vm, int arg_count, Value *args) {
@@ -98,7 +98,7 @@ Value syntax_column_msc(VM *vm, int arg_count, Value *args) {
   }
 
   ObjectSyntax *syntax = AS_SYNTAX(args[0]);
-  return NUMBER_VAL(syntax->column);
+  return FIXNUM_VAL(syntax->column);
 }
 
 Value syntax_position_msc(VM *vm, int arg_count, Value *args) {
@@ -107,7 +107,7 @@ Value syntax_position_msc(VM *vm, int arg_count, Value *args) {
   }
 
   ObjectSyntax *syntax = AS_SYNTAX(args[0]);
-  return NUMBER_VAL(syntax->position);
+  return FIXNUM_VAL(syntax->position);
 }
 
 Value syntax_span_msc(VM *vm, int arg_count, Value *args) {
@@ -116,7 +116,7 @@ Value syntax_span_msc(VM *vm, int arg_count, Value *args) {
   }
 
   ObjectSyntax *syntax = AS_SYNTAX(args[0]);
-  return NUMBER_VAL(syntax->span);
+  return FIXNUM_VAL(syntax->span);
 }
 
 Value syntax_source_msc(VM *vm, int arg_count, Value *args) {
@@ -12,7 +12,7 @@ Value time_current_msec_msc(VM *vm, int arg_count, Value *args) {
   struct timeval tv;
   gettimeofday(&tv, NULL);
 
-  return NUMBER_VAL((((long long)tv.tv_sec) * 1000) + (tv.tv_usec / 1000));
+  return FIXNUM_VAL((((long long)tv.tv_sec) * 1000) + (tv.tv_usec / 1000));
 }
 
 void mesche_time_module_init(VM *vm) {
@@ -35,7 +35,7 @@ void mesche_value_print(MeschePort *port, Value value) {
 }
 
 void mesche_value_print_ex(MeschePort *port, Value value, MeschePrintStyle style) {
-  switch (value.kind) {
+  switch (VALUE_KIND(value)) {
   case VALUE_UNSPECIFIED:
     if (style == PrintStyleData) {
       fprintf(port->data.file.fp, "#<unspecified>");
@@ -44,6 +44,9 @@ void mesche_value_print_ex(MeschePort *port, Value value, MeschePrintStyle style
   case VALUE_NUMBER:
     fprintf(port->data.file.fp, "%g", AS_NUMBER(value));
     break;
+  case VALUE_FIXNUM:
+    fprintf(port->data.file.fp, "%lld", (long long)AS_FIXNUM(value));
+    break;
   case VALUE_CHAR:
     fprintf(port->data.file.fp, "%c", AS_CHAR(value));
     break;
@@ -69,18 +72,32 @@ void mesche_value_print_ex(MeschePort *port, Value value, MeschePrintStyle style
   }
 }
 
+// Numbers are only `eqv?` when they have the same exactness, but they're
+// `equal?` whenever they have the same value
+bool mesche_value_equal_p(Value a, Value b) {
+  if (VALUE_KIND(a) == VALUE_FIXNUM && VALUE_KIND(b) == VALUE_NUMBER) {
+    return (double)AS_FIXNUM(a) == AS_NUMBER(b);
+  } else if (VALUE_KIND(a) == VALUE_NUMBER && VALUE_KIND(b) == VALUE_FIXNUM) {
+    return AS_NUMBER(a) == (double)AS_FIXNUM(b);
+  }
+
+  return mesche_value_eqv_p(a, b);
+}
+
 bool mesche_value_eqv_p(Value a, Value b) {
   // This check also covers comparison of #t and #f
-  if (a.kind != b.kind)
+  if (VALUE_KIND(a) != VALUE_KIND(b))
     return false;
 
-  switch (a.kind) {
+  switch (VALUE_KIND(a)) {
   case VALUE_FALSE:
   case VALUE_TRUE:
   case VALUE_EMPTY:
     return true;
   case VALUE_NUMBER:
     return AS_NUMBER(a) == AS_NUMBER(b);
+  case VALUE_FIXNUM:
+    return AS_FIXNUM(a) == AS_FIXNUM(b);
   case VALUE_CHAR:
     return AS_CHAR(a) == AS_CHAR(b);
   case VALUE_OBJECT: {
@@ -6,32 +6,15 @@
 typedef struct Object Object;
 
 #include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
 
 #include "io.h"
 #include "mem.h"
 
-#define UNSPECIFIED_VAL ((Value){VALUE_UNSPECIFIED, {.number = 0}})
-#define TRUE_VAL ((Value){VALUE_TRUE, {.number = 0}})
-#define FALSE_VAL ((Value){VALUE_FALSE, {.number = 0}})
-#define EMPTY_VAL ((Value){VALUE_EMPTY, {.number = 0}})
-#define EOF_VAL ((Value){VALUE_EOF, {.number = 0}})
-#define NUMBER_VAL(value) ((Value){VALUE_NUMBER, {.number = value}})
-#define CHAR_VAL(value) ((Value){VALUE_CHAR, {.character = value}})
-#define BOOL_VAL(value) ((Value){value ? VALUE_TRUE : VALUE_FALSE, {.number = 0}})
-
-#define AS_NUMBER(value) ((value).as.number)
-#define AS_CHAR(value) ((value).as.character)
-#define AS_BOOL(value) ((value).kind != VALUE_FALSE)
-
-#define IS_ANY(value) (true)
-#define IS_UNSPECIFIED(value) ((value).kind == VALUE_UNSPECIFIED)
-#define IS_TRUE(value) ((value).kind == VALUE_TRUE)
-#define IS_FALSE(value) ((value).kind == VALUE_FALSE)
-#define IS_EMPTY(value) ((value).kind == VALUE_EMPTY)
-#define IS_FALSEY(value) (IS_FALSE(value))
-#define IS_NUMBER(value) ((value).kind == VALUE_NUMBER)
-#define IS_CHAR(value) ((value).kind == VALUE_CHAR)
-#define IS_EOF(value) ((value).kind == VALUE_EOF)
+// NOTE: Enable this to store values as NaN-boxed 64-bit words instead of
+// tagged structs
+/* #define MESCHE_NAN_BOXING */
 
 #define PRINT_VALUE(vm, label, value)                                                              \
   printf(label);                                                                                   \
@@ -44,20 +27,184 @@ typedef enum {
   VALUE_TRUE,
   VALUE_EMPTY,
   VALUE_NUMBER,
+  VALUE_FIXNUM,
   VALUE_CHAR,
   VALUE_OBJECT,
   VALUE_EOF,
 } ValueKind;
 
+// Exact integers (fixnums) are stored unboxed alongside inexact numbers
+// (doubles).  Their range is the same for both value representations so that
+// exactness never depends on the build, results outside of it are promoted to
+// doubles.
+#define FIXNUM_BITS 47
+#define FIXNUM_MIN (-((int64_t)1 << (FIXNUM_BITS - 1)))
+#define FIXNUM_MAX (((int64_t)1 << (FIXNUM_BITS - 1)) - 1)
+#define FIXNUM_FITS(value) ((value) >= FIXNUM_MIN && (value) <= FIXNUM_MAX)
+
+#ifdef MESCHE_NAN_BOXING
+
+// A NaN-boxed value is a 64-bit word.  Inexact numbers are stored as plain
+// doubles.  Every other value lives inside the payload of a quiet NaN: objects
+// set the sign bit and store their pointer in the lower 48 bits, immediates
+// use the lowest 3 bits as a tag.  Fixnums store their two's complement bits
+// above the tag.
+
+typedef uint64_t Value;
+
+#define SIGN_BIT ((uint64_t)0x8000000000000000)
+#define QNAN ((uint64_t)0x7ffc000000000000)
+
+#define TAG_UNSPECIFIED 1
+#define TAG_FALSE 2
+#define TAG_TRUE 3
+#define TAG_EMPTY 4
+#define TAG_EOF 5
+#define TAG_CHAR 6
+#define TAG_FIXNUM 7
+#define TAG_MASK 7
+#define FIXNUM_PAYLOAD_MASK (((uint64_t)1 << FIXNUM_BITS) - 1)
+
+static inline Value mesche_value_from_number(double number) {
+  Value value;
+  memcpy(&value, &number, sizeof(double));
+  return value;
+}
+
+#define IS_FLONUM(value) (((value)&QNAN) != QNAN)
+#define IS_FIXNUM(value) (((value) & (SIGN_BIT | QNAN | TAG_MASK)) == (QNAN | TAG_FIXNUM))
+
+#define FIXNUM_VAL(value)                                                                          \
+  ((Value)(QNAN | (((uint64_t)(int64_t)(value)&FIXNUM_PAYLOAD_MASK) << 3) | TAG_FIXNUM))
+
+// Shift the payload's sign bit up to the top of the word so that the
+// arithmetic shift back down sign extends it
+#define AS_FIXNUM(value) (((int64_t)((value) << (64 - FIXNUM_BITS - 3))) >> (64 - FIXNUM_BITS))
+
+static inline double mesche_value_to_flonum(Value value) {
+  double number;
+  memcpy(&number, &value, sizeof(Value));
+  return number;
+}
+
+static inline double mesche_value_to_number(Value value) {
+  return IS_FIXNUM(value) ? (double)AS_FIXNUM(value) : mesche_value_to_flonum(value);
+}
+
+#define UNSPECIFIED_VAL ((Value)(uint64_t)(QNAN | TAG_UNSPECIFIED))
+#define TRUE_VAL ((Value)(uint64_t)(QNAN | TAG_TRUE))
+#define FALSE_VAL ((Value)(uint64_t)(QNAN | TAG_FALSE))
+#define EMPTY_VAL ((Value)(uint64_t)(QNAN | TAG_EMPTY))
+#define EOF_VAL ((Value)(uint64_t)(QNAN | TAG_EOF))
+#define NUMBER_VAL(value) mesche_value_from_number(value)
+#define CHAR_VAL(value) ((Value)(QNAN | ((uint64_t)(uint8_t)(value) << 8) | TAG_CHAR))
+#define BOOL_VAL(value) ((value) ? TRUE_VAL : FALSE_VAL)
+
+#define AS_NUMBER(value) mesche_value_to_number(value)
+#define AS_FLONUM(value) mesche_value_to_flonum(value)
+#define AS_CHAR(value) ((char)(((value) >> 8) & 0xff))
+#define AS_BOOL(value) ((value) != FALSE_VAL)
+
+#define IS_ANY(value) (true)
+#define IS_UNSPECIFIED(value) ((value) == UNSPECIFIED_VAL)
+#define IS_TRUE(value) ((value) == TRUE_VAL)
+#define IS_FALSE(value) ((value) == FALSE_VAL)
+#define IS_EMPTY(value) ((value) == EMPTY_VAL)
+#define IS_FALSEY(value) (IS_FALSE(value))
+#define IS_NUMBER(value) mesche_value_is_number(value)
+#define IS_CHAR(value) (((value) & (SIGN_BIT | QNAN | TAG_MASK)) == (QNAN | TAG_CHAR))
+
+static inline bool mesche_value_is_number(Value value) {
+  return IS_FLONUM(value) || IS_FIXNUM(value);
+}
+#define IS_EOF(value) ((value) == EOF_VAL)
+
+#define VALUE_KIND(value) mesche_value_kind(value)
+
+static inline ValueKind mesche_value_kind(Value value) {
+  if (IS_FLONUM(value)) {
+    return VALUE_NUMBER;
+  } else if ((value & (SIGN_BIT | QNAN)) == (SIGN_BIT | QNAN)) {
+    return VALUE_OBJECT;
+  }
+
+  switch (value & TAG_MASK) {
+  case TAG_FALSE:
+    return VALUE_FALSE;
+  case TAG_TRUE:
+    return VALUE_TRUE;
+  case TAG_EMPTY:
+    return VALUE_EMPTY;
+  case TAG_EOF:
+    return VALUE_EOF;
+  case TAG_CHAR:
+    return VALUE_CHAR;
+  case TAG_FIXNUM:
+    return VALUE_FIXNUM;
+  default:
+    return VALUE_UNSPECIFIED;
+  }
+}
+
+#else
+
 typedef struct {
   ValueKind kind;
   union {
     char character;
     double number;
+    int64_t fixnum;
     Object *object;
   } as;
 } Value;
 
+#define UNSPECIFIED_VAL ((Value){VALUE_UNSPECIFIED, {.number = 0}})
+#define TRUE_VAL ((Value){VALUE_TRUE, {.number = 0}})
+#define FALSE_VAL ((Value){VALUE_FALSE, {.number = 0}})
+#define EMPTY_VAL ((Value){VALUE_EMPTY, {.number = 0}})
+#define EOF_VAL ((Value){VALUE_EOF, {.number = 0}})
+#define NUMBER_VAL(value) ((Value){VALUE_NUMBER, {.number = value}})
+#define FIXNUM_VAL(value) ((Value){VALUE_FIXNUM, {.fixnum = value}})
+#define CHAR_VAL(value) ((Value){VALUE_CHAR, {.character = value}})
+#define BOOL_VAL(value) ((Value){value ? VALUE_TRUE : VALUE_FALSE, {.number = 0}})
+
+#define AS_NUMBER(value) mesche_value_to_number(value)
+#define AS_FLONUM(value) ((value).as.number)
+#define AS_FIXNUM(value) ((value).as.fixnum)
+#define AS_CHAR(value) ((value).as.character)
+#define AS_BOOL(value) ((value).kind != VALUE_FALSE)
+
+#define IS_ANY(value) (true)
+#define IS_UNSPECIFIED(value) ((value).kind == VALUE_UNSPECIFIED)
+#define IS_TRUE(value) ((value).kind == VALUE_TRUE)
+#define IS_FALSE(value) ((value).kind == VALUE_FALSE)
+#define IS_EMPTY(value) ((value).kind == VALUE_EMPTY)
+#define IS_FALSEY(value) (IS_FALSE(value))
+#define IS_NUMBER(value) mesche_value_is_number(value)
+#define IS_FLONUM(value) ((value).kind == VALUE_NUMBER)
+#define IS_FIXNUM(value) ((value).kind == VALUE_FIXNUM)
+#define IS_CHAR(value) ((value).kind == VALUE_CHAR)
+#define IS_EOF(value) ((value).kind == VALUE_EOF)
+
+#define VALUE_KIND(value) ((value).kind)
+
+static inline bool mesche_value_is_number(Value value) {
+  return value.kind == VALUE_NUMBER || value.kind == VALUE_FIXNUM;
+}
+
+static inline double mesche_value_to_number(Value value) {
+  return value.kind == VALUE_FIXNUM ? (double)value.as.fixnum : value.as.number;
+}
+
+#endif
+
+// Converts any number to an integer, truncating inexact numbers
+static inline int64_t mesche_value_to_integer(Value value) {
+  return IS_FIXNUM(value) ? AS_FIXNUM(value) : (int64_t)AS_NUMBER(value);
+}
+
+#define AS_INTEGER(value) mesche_value_to_integer(value)
+
 typedef struct {
   int capacity;
   int count;
@@ -70,5 +217,6 @@ void mesche_value_array_free(MescheMemory *mem, ValueArray *array);
 void mesche_value_print(MeschePort *port, Value value);
 void mesche_value_print_ex(MeschePort *port, Value value, MeschePrintStyle style);
 bool mesche_value_eqv_p(Value a, Value b);
+bool mesche_value_equal_p(Value a, Value b);
 
 #endif
@@ -15,8 +15,23 @@
 #include "vm.h"
 
 #define UINT8_COUNT (UINT8_MAX + 1)
-#define FRAMES_MAX 64
-#define STACK_MAX (FRAMES_MAX * UINT8_COUNT)
+
+// The phases of an incremental garbage collection cycle
+typedef enum { GC_PHASE_IDLE, GC_PHASE_MARKING, GC_PHASE_SWEEPING } GCPhase;
+
+// The call frame and value stacks start small and grow on demand up to their
+// maximum sizes.  Both limits can be changed per VM with
+// `mesche_vm_stack_configure`.
+#define FRAMES_INITIAL 64
+#define FRAMES_MAX (256 * 1024)
+#define STACK_INITIAL (FRAMES_INITIAL * 16)
+#define STACK_MAX (FRAMES_MAX * 16)
+
+// The number of free value slots guaranteed above the stack top when a native
+// function is called, in addition to the function's code size when a closure
+// is called.  Since jumps only move forward, a function can't push more
+// values than it has bytes of code before it makes another call.
+#define STACK_HEADROOM (UINT8_COUNT * 2)
 
 typedef struct VM {
   // VM is a MescheMemory implementation
@@ -24,10 +39,20 @@ typedef struct VM {
   MescheMemory mem;
 
   // Runtime call and value stack tracking
-  CallFrame frames[FRAMES_MAX];
+  CallFrame *frames;
   int frame_count;
-  Value stack[STACK_MAX]; // TODO: Make this dynamically resizable
+  int frame_capacity;
+  int frame_max;
+  Value *stack;
   Value *stack_top;
+  int stack_capacity;
+  int stack_max;
+
+  // Value stacks that were replaced when the stack grew.  They are kept until
+  // the VM finishes running because native functions may still be reading
+  // their arguments from them.
+  Value **retired_stacks;
+  int retired_stack_count;
   Table strings;
   Table symbols;
   Table keywords;
@@ -48,6 +73,10 @@ typedef struct VM {
   ObjectModule *root_module;
   ObjectModule *core_module;
   ObjectModule *current_module;
+
+  // Incremented whenever a module gains a new binding name so that cached
+  // global variable lookups know to resolve the name again
+  uint32_t binding_epoch;
   ObjectCons *load_paths;
 
   // The most recent reset marker
@@ -61,11 +90,55 @@ typedef struct VM {
   ObjectUpvalue *open_upvalues;
 
   // Memory management
-  Object *objects;
   int gray_count;
   int gray_capacity;
   Object **gray_stack;
 
+  // Generational collection state.  Objects that survived a collection keep
+  // their mark bits, and old objects that have been written to since the last
+  // collection are kept in the remembered set.
+  size_t next_major_gc;
+  int remembered_count;
+  int remembered_capacity;
+  Object **remembered_set;
+
+  // Incremental collection state.  Objects that are written to after they
+  // were marked in the current cycle are kept in the remembered set until
+  // they're traced again.
+  GCPhase gc_phase;
+
+  // Threads that mark objects in parallel, started on the first collection
+  // whose heap is at least `gc_parallel_min_heap` bytes.  There's one per
+  // online CPU unless `gc_marker_count` is set.
+  struct GCMarkerPool *marker_pool;
+  int gc_marker_count;
+  size_t gc_parallel_min_heap;
+
+  // Samples allocations by call stack while it's set, see profiler.c
+  struct MescheProfiler *profiler;
+
+  // Receives the objects that would be marked while it's set
+  void (*gc_visit_func)(struct Object *object, void *context);
+  void *gc_visit_context;
+
+  // Native resources of collected objects that are released after the
+  // collection finishes, in order from `finalizer_next`
+  struct GCFinalizer *finalizers;
+  int finalizer_count;
+  int finalizer_capacity;
+  int finalizer_next;
+
+  // Guardians that are still reachable, see `gc_process_weak_references`
+  struct GCGuardian *guardians;
+
+  // Weak tables that were traced in the current collection
+  struct ObjectWeakTable *weak_tables;
+
+  // The arena scopes that are open, innermost last, see `mesche_gc_arena_end`
+  struct GCArena *arenas;
+  int arena_count;
+  int arena_capacity;
+
   // An application-specific context object
   void *app_context;
 
@@ -78,6 +151,8 @@ typedef struct VM {
 } VM;
 
 InterpretResult mesche_vm_call_closure(VM *vm, ObjectClosure *closure, int arg_count, Value *args);
+void mesche_vm_stack_configure(VM *vm, int initial_frames, int max_frames, int initial_values,
+                               int max_values);
 InterpretResult mesche_vm_load_module(VM *vm, ObjectModule *module, const char *module_path);
 
 #endif
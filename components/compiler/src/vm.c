@@ -1,3 +1,4 @@
+#include <math.h>
 #include <stdarg.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -23,13 +24,16 @@
 #include "op.h"
 #include "port.h"
 #include "process.h"
+#include "profiler.h"
 #include "record.h"
+#include "snapshot.h"
 #include "string.h"
 #include "syntax.h"
 #include "time.h"
 #include "util.h"
 #include "value.h"
 #include "vm-impl.h"
+#include "weak.h"
 
 // Predeclare module init functions
 void mesche_io_module_init(VM *vm);
@@ -37,6 +41,56 @@ void mesche_io_module_init(VM *vm);
 // NOTE: Enable this for diagnostic purposes
 /* #define DEBUG_TRACE_EXECUTION */
 
+// NOTE: Enable this to use the `switch` dispatch loop even when the compiler
+// supports computed goto
+/* #define VM_DISABLE_COMPUTED_GOTO */
+
+// NOTE: Enable this to count how often each pair of opcodes executes back to
+// back and print the most frequent pairs when the VM is freed.  Run a workload
+// with it to find sequences worth fusing into superinstructions.
+/* #define DEBUG_PROFILE_OPCODE_PAIRS */
+
+#ifdef DEBUG_PROFILE_OPCODE_PAIRS
+#define OPCODE_PAIRS_REPORTED 25
+
+static uint64_t opcode_pair_counts[UINT8_COUNT][UINT8_COUNT];
+
+static void vm_print_opcode_pairs(MeschePort *port) {
+  uint64_t total = 0;
+  for (int i = 0; i < UINT8_COUNT; i++) {
+    for (int j = 0; j < UINT8_COUNT; j++) {
+      total += opcode_pair_counts[i][j];
+    }
+  }
+
+  fprintf(port->data.file.fp, "\nMost frequent opcode pairs (%llu total):\n",
+          (unsigned long long)total);
+
+  // Repeatedly pick the largest remaining count, zeroing it once reported
+  for (int n = 0; n < OPCODE_PAIRS_REPORTED; n++) {
+    int first = 0, second = 0;
+    for (int i = 0; i < UINT8_COUNT; i++) {
+      for (int j = 0; j < UINT8_COUNT; j++) {
+        if (opcode_pair_counts[i][j] > opcode_pair_counts[first][second]) {
+          first = i;
+          second = j;
+        }
+      }
+    }
+
+    uint64_t count = opcode_pair_counts[first][second];
+    if (count == 0) {
+      break;
+    }
+
+    fprintf(port->data.file.fp, "  %12llu  %5.2f%%  %s -> %s\n", (unsigned long long)count,
+            total ? 100.0 * count / total : 0.0, mesche_disasm_opcode_name(first),
+            mesche_disasm_opcode_name(second));
+    opcode_pair_counts[first][second] = 0;
+  }
+}
+#endif
+
 #define PRINT_VALUE_STACK()                                                                        \
   printf("\nValue Stack:\n");                                                                      \
   for (Value *slot = vm->stack; slot < vm->stack_top; slot++) {                                    \
@@ -57,7 +111,13 @@ void mesche_io_module_init(VM *vm);
     printf("\n");                                                                                  \
   }
 
+static bool vm_stack_reserve(VM *vm, int count);
+
 void mesche_vm_stack_push(VM *vm, Value value) {
+  if (vm->stack_top == vm->stack + vm->stack_capacity && !vm_stack_reserve(vm, 1)) {
+    PANIC("Value stack has grown past its maximum size of %d!", vm->stack_max);
+  }
+
   *vm->stack_top = value;
   vm->stack_top++;
 }
@@ -73,6 +133,16 @@ Value mesche_vm_stack_pop(VM *vm) {
 
 static Value vm_stack_peek(VM *vm, int distance) { return vm->stack_top[-1 - distance]; }
 
+static void vm_release_retired_stacks(VM *vm) {
+  for (int i = 0; i < vm->retired_stack_count; i++) {
+    free(vm->retired_stacks[i]);
+  }
+
+  free(vm->retired_stacks);
+  vm->retired_stacks = NULL;
+  vm->retired_stack_count = 0;
+}
+
 static void vm_reset_stack(VM *vm) {
   vm->stack_top = vm->stack;
   vm->frame_count = 0;
@@ -81,6 +151,102 @@ static void vm_reset_stack(VM *vm) {
       mesche_object_make_stack_marker(vm, STACK_MARKER_RESET, vm->frame_count);
 }
 
+static void vm_stack_resize(VM *vm, int capacity) {
+  Value *old_stack = vm->stack;
+  Value *new_stack = malloc(sizeof(Value) * capacity);
+  if (new_stack == NULL) {
+    PANIC("VM's value stack could not be reallocated.");
+  }
+
+  int stack_count = vm->stack_top - old_stack;
+  if (old_stack != NULL) {
+    memcpy(new_stack, old_stack, sizeof(Value) * stack_count);
+  }
+
+  // Move every pointer into the old stack to the same location in the new one
+  for (int i = 0; i < vm->frame_count; i++) {
+    vm->frames[i].slots = new_stack + (vm->frames[i].slots - old_stack);
+  }
+
+  for (ObjectUpvalue *upvalue = vm->open_upvalues; upvalue != NULL; upvalue = upvalue->next) {
+    upvalue->location = new_stack + (upvalue->location - old_stack);
+  }
+
+  vm->stack = new_stack;
+  vm->stack_top = new_stack + stack_count;
+  vm->stack_capacity = capacity;
+
+  // Hold on to the old stack until the VM stops running
+  if (old_stack != NULL) {
+    vm->retired_stacks =
+        realloc(vm->retired_stacks, sizeof(Value *) * (vm->retired_stack_count + 1));
+    vm->retired_stacks[vm->retired_stack_count++] = old_stack;
+  }
+}
+
+// Ensures that `count` more values can be pushed onto the value stack, returns
+// false if that would exceed the stack's maximum size
+static bool vm_stack_reserve(VM *vm, int count) {
+  int needed = (vm->stack_top - vm->stack) + count;
+  if (needed <= vm->stack_capacity) {
+    return true;
+  } else if (needed > vm->stack_max) {
+    return false;
+  }
+
+  int capacity = vm->stack_capacity;
+  while (capacity < needed) {
+    capacity *= 2;
+  }
+
+  vm_stack_resize(vm, capacity < vm->stack_max ? capacity : vm->stack_max);
+  return true;
+}
+
+// Ensures that `count` more call frames can be pushed, returns false if that
+// would exceed the maximum call depth
+static bool vm_frames_reserve(VM *vm, int count) {
+  int needed = vm->frame_count + count;
+  if (needed <= vm->frame_capacity) {
+    return true;
+  } else if (needed > vm->frame_max) {
+    return false;
+  }
+
+  int capacity = vm->frame_capacity;
+  while (capacity < needed) {
+    capacity *= 2;
+  }
+
+  vm->frame_capacity = capacity < vm->frame_max ? capacity : vm->frame_max;
+  vm->frames = realloc(vm->frames, sizeof(CallFrame) * vm->frame_capacity);
+  if (vm->frames == NULL) {
+    PANIC("VM's call frame stack could not be reallocated.");
+  }
+
+  return true;
+}
+
+void mesche_vm_stack_configure(VM *vm, int initial_frames, int max_frames, int initial_values,
+                               int max_values) {
+  vm->frame_max = max_frames;
+  vm->stack_max = max_values;
+
+  // Never shrink the stacks below what is currently in use
+  int frames_used = vm->frame_count;
+  int values_used = vm->stack_top - vm->stack;
+  initial_frames = initial_frames > frames_used ? initial_frames : frames_used;
+  initial_values = initial_values > values_used ? initial_values : values_used;
+
+  vm->frame_capacity = initial_frames > 0 ? initial_frames : 1;
+  vm->frames = realloc(vm->frames, sizeof(CallFrame) * vm->frame_capacity);
+  if (vm->frames == NULL) {
+    PANIC("VM's call frame stack could not be reallocated.");
+  }
+
+  vm_stack_resize(vm, initial_values > 0 ? initial_values : 1);
+}
+
 // TODO: This should set a field on VM object which gets read after each function call (?)
 
 void mesche_vm_raise_error(VM *vm, const char *format, ...) {
@@ -101,21 +267,39 @@ void mesche_vm_raise_error(VM *vm, const char *format, ...) {
 
   // TODO: Start debugger if necessary
   vm_reset_stack(vm);
+
+  // The arena scopes that were open can't be ended normally anymore
+  if (vm->arena_count > 0) {
+    mesche_gc_arena_abandon(vm);
+  }
+
+  // The error stops the VM so that the host can evaluate code again
+  vm->is_running = false;
 }
 
+// Opens an arena scope.  Objects allocated until the matching call to
+// `mesche_vm_arena_end` are collected when it ends unless they're still
+// reachable from the stack or from objects that were written to in between.
+// Native pointers whose types have a mark function must call the write barrier
+// when their references change for that to see them.  Returns false without
+// opening a scope if they're already nested as deep as they can be.
+bool mesche_vm_arena_begin(VM *vm) { return mesche_gc_arena_begin(vm); }
+
+void mesche_vm_arena_end(VM *vm) { mesche_gc_arena_end(vm); }
+
 static void vm_free_objects(VM *vm) {
-  Object *object = vm->objects;
-  vm->objects = NULL;
-  while (object != NULL) {
-    Object *next = object->next;
-    mesche_object_free(vm, object);
-    object = next;
-  }
+  mesche_profiler_free(vm);
+  mesche_gc_free_objects(vm);
 
   if (vm->gray_stack) {
     free(vm->gray_stack);
   }
   vm->gray_stack = NULL;
+
+  free(vm->remembered_set);
+  vm->remembered_set = NULL;
+  vm->remembered_count = 0;
+  vm->remembered_capacity = 0;
 }
 
 void mesche_vm_register_core_modules(VM *vm, char *module_path) {
@@ -153,16 +337,21 @@ void mesche_vm_register_core_modules(VM *vm, char *module_path) {
   mesche_math_module_init(vm);
   mesche_time_module_init(vm);
   mesche_array_module_init(vm);
+  mesche_weak_table_module_init(vm);
   mesche_string_module_init(vm);
   mesche_reader_module_init(vm);
   mesche_module_module_init(vm);
   mesche_compiler_module_init(vm);
   mesche_process_module_init(vm);
+  mesche_gc_module_init(vm);
+  mesche_profiler_module_init(vm);
+  mesche_snapshot_module_init(vm);
 }
 
 void mesche_vm_init(VM *vm, int arg_count, char **arg_array) {
   // Initialize the memory manager
   mesche_mem_init(&vm->mem, mesche_gc_collect_garbage);
+  vm->mem.collect_garbage_slice_func = mesche_gc_collect_garbage_slice;
 
   // Initialize the gray stack before allocating anything
   vm->gray_count = 0;
@@ -170,10 +359,30 @@ void mesche_vm_init(VM *vm, int arg_count, char **arg_array) {
   vm->gray_stack = NULL;
 
   vm->is_running = false;
-  vm->objects = NULL;
+  vm->next_major_gc = vm->mem.next_gc;
+  vm->remembered_count = 0;
+  vm->remembered_capacity = 0;
+  vm->remembered_set = NULL;
+  vm->gc_phase = GC_PHASE_IDLE;
+  vm->marker_pool = NULL;
+  vm->gc_marker_count = 0;
+  vm->gc_parallel_min_heap = GC_PARALLEL_MIN_HEAP;
+  vm->profiler = NULL;
+  vm->gc_visit_func = NULL;
+  vm->gc_visit_context = NULL;
+  vm->finalizers = NULL;
+  vm->finalizer_count = 0;
+  vm->finalizer_capacity = 0;
+  vm->finalizer_next = 0;
+  vm->guardians = NULL;
+  vm->weak_tables = NULL;
+  vm->arenas = NULL;
+  vm->arena_count = 0;
+  vm->arena_capacity = 0;
   vm->load_paths = NULL;
   vm->current_compiler = NULL;
   vm->core_module = NULL;
+  vm->binding_epoch = 1;
   vm->expander = NULL;
   vm->quote_symbol = NULL;
   vm->current_reset_marker = NULL;
@@ -181,7 +390,15 @@ void mesche_vm_init(VM *vm, int arg_count, char **arg_array) {
   vm->input_port = NULL;
   vm->output_port = NULL;
   vm->error_port = NULL;
-  vm->stack_top = vm->stack;
+
+  // Allocate the initial call frame and value stacks
+  vm->frames = NULL;
+  vm->frame_count = 0;
+  vm->stack = NULL;
+  vm->stack_top = NULL;
+  vm->retired_stacks = NULL;
+  vm->retired_stack_count = 0;
+  mesche_vm_stack_configure(vm, FRAMES_INITIAL, FRAMES_MAX, STACK_INITIAL, STACK_MAX);
 
   // Initialize the interned string, symbol, and keyword tables
   mesche_table_init(&vm->strings);
@@ -224,6 +441,12 @@ void mesche_vm_init(VM *vm, int arg_count, char **arg_array) {
 }
 
 void mesche_vm_free(VM *vm) {
+#ifdef DEBUG_PROFILE_OPCODE_PAIRS
+  if (vm->output_port) {
+    vm_print_opcode_pairs(vm->output_port);
+  }
+#endif
+
   // Reset stacks to lose references to things allocated there
   vm_reset_stack(vm);
   vm->open_upvalues = NULL;
@@ -242,6 +465,14 @@ void mesche_vm_free(VM *vm) {
   mesche_table_free((MescheMemory *)vm, &vm->strings);
   mesche_table_free((MescheMemory *)vm, &vm->keywords);
   vm_free_objects(vm);
+
+  // Free the stacks
+  vm_release_retired_stacks(vm);
+  free(vm->stack);
+  free(vm->frames);
+  vm->stack = NULL;
+  vm->stack_top = NULL;
+  vm->frames = NULL;
 }
 
 static ObjectUpvalue *vm_capture_upvalue(VM *vm, Value *local) {
@@ -289,12 +520,128 @@ static void vm_close_upvalues(VM *vm, Value *stack_slot) {
     ObjectUpvalue *upvalue = vm->open_upvalues;
     upvalue->closed = *upvalue->location;
     upvalue->location = &upvalue->closed;
+    mesche_gc_write_barrier(vm, (Object *)upvalue);
     vm->open_upvalues = upvalue->next;
   }
 }
 
-static bool vm_call(VM *vm, ObjectClosure *closure, uint8_t arg_count, uint8_t keyword_count,
-                    bool is_tail_call) {
+// Reserves enough frame and value stack space to call the closure, raising an
+// error if either stack would exceed its maximum size.
+static inline bool vm_call_reserve(VM *vm, ObjectClosure *closure, bool is_tail_call) {
+  if (!is_tail_call && !vm_frames_reserve(vm, 1)) {
+    mesche_vm_raise_error(vm, "Call stack overflow, exceeded maximum depth of %d frames.",
+                          vm->frame_max);
+    return false;
+  }
+
+  if (!vm_stack_reserve(vm, closure->function->chunk.count +
+                               closure->function->keyword_args.count + STACK_HEADROOM)) {
+    mesche_vm_raise_error(vm, "Value stack overflow, exceeded maximum size of %d values.",
+                          vm->stack_max);
+    return false;
+  }
+
+  return true;
+}
+
+// Sets up the call frame for a closure whose arguments have already been
+// checked and arranged in the order its locals expect.
+static inline bool vm_call_enter(VM *vm, ObjectClosure *closure, Value *arg_start,
+                                 int total_arg_count, bool is_tail_call) {
+  if (is_tail_call) {
+    // Reuse the existing frame
+    CallFrame *frame = &vm->frames[vm->frame_count - 1];
+
+    // Close out upvalues for any function locals that have been captured by
+    // closures before we wipe them from the stack
+    vm_close_upvalues(vm, frame->slots);
+
+    // Copy the new arguments (and the closure value itself) on top of the old
+    // slots (add 1 to the argument counts because we're also copying the callee
+    // value).
+    //
+    // NOTE: total_arg_count includes values for all keyword arguments because
+    // they will be sent to the call regardless of whether the caller specified
+    // them!
+    memmove(frame->slots, arg_start - 1, sizeof(Value) * (total_arg_count + 1));
+
+    // Reset the top of the value stack to shrink it back to where it was before
+    vm->stack_top = frame->slots + total_arg_count + 1;
+
+    // Set up the closure and instruction pointer to continue execution
+    frame->closure = closure;
+    frame->ip = closure->function->chunk.code;
+    frame->total_arg_count = total_arg_count;
+    return true;
+  } else {
+    CallFrame *frame = &vm->frames[vm->frame_count++];
+    frame->closure = closure;
+    frame->ip = closure->function->chunk.code;
+    frame->slots = arg_start - 1;
+
+    // The total argument count is plain argument count plus number of
+    // keyword arguments because we've removed the keywords from the list
+    // and left either the specified value or the default.
+    frame->total_arg_count = total_arg_count;
+
+    return true;
+  }
+}
+
+// Returns the keyword that is passed to fill the given keyword slot of a
+// function or record type.
+static inline ObjectKeyword *vm_keyword_slot(Object *callee, int slot) {
+  if (callee->kind == ObjectKindFunction) {
+    return ((ObjectFunction *)callee)->keyword_args.args[slot].keyword;
+  } else {
+    return AS_RECORD_FIELD(((ObjectRecord *)callee)->fields.values[slot])->keyword;
+  }
+}
+
+// Finds which of the keyword/value pairs passed to a call supply each of the
+// callee's keyword slots.  Keywords are interned so they are matched by
+// identity, and since the keywords passed at a call site are fixed at compile
+// time the resulting map is stored in the site's cache and reused for as long
+// as the site keeps calling the same function or record type.  Passed keywords
+// that the callee doesn't declare are ignored.
+static const uint8_t *vm_keyword_map(VM *vm, CallCache *cache, Object *callee, int slot_count,
+                                     Value *pairs, int pair_count) {
+  if (cache->keyword_callee == callee) {
+    return cache->keyword_map;
+  }
+
+  if (cache->keyword_map_count < slot_count) {
+    cache->keyword_map = GROW_ARRAY((MescheMemory *)vm, uint8_t, cache->keyword_map,
+                                    cache->keyword_map_count, slot_count);
+    cache->keyword_map_count = slot_count;
+  }
+
+  uint8_t *map = cache->keyword_map;
+  cache->keyword_callee = callee;
+
+  for (int i = 0; i < slot_count; i++) {
+    Object *keyword = (Object *)vm_keyword_slot(callee, i);
+    map[i] = KEYWORD_NOT_PASSED;
+    for (int j = 0; j < pair_count; j++) {
+      if (AS_OBJECT(pairs[j * 2]) == keyword) {
+        map[i] = j;
+        break;
+      }
+    }
+  }
+
+  return map;
+}
+
+static bool vm_call(VM *vm, ObjectClosure *closure, CallCache *cache, int arg_count,
+                    uint8_t keyword_count, bool is_tail_call) {
+  // Keyword/value pairs passed to a function that takes no keyword arguments
+  // are just more positional arguments
+  if (keyword_count > 0 && closure->function->keyword_args.count == 0) {
+    arg_count += keyword_count * 2;
+    keyword_count = 0;
+  }
+
   // Arity checks differ depending on whether a :rest argument is present
   if (closure->function->rest_arg_index == 0 && arg_count != closure->function->arity) {
     mesche_vm_raise_error(vm, "Expected %d arguments but got %d.", closure->function->arity,
@@ -306,110 +653,55 @@ static bool vm_call(VM *vm, ObjectClosure *closure, uint8_t arg_count, uint8_t k
     return false;
   }
 
+  // Make sure the stacks have room for the new frame before taking pointers
+  // into the value stack since growing it could move it
+  if (!vm_call_reserve(vm, closure, is_tail_call)) {
+    return false;
+  }
+
   // Locate the first argument on the value stack
   Value *arg_start = vm->stack_top - (arg_count + (keyword_count * 2));
 
   // Store the number of keyword arguments the function takes, we'll need it later
   int num_keyword_args = closure->function->keyword_args.count;
 
-  // Process keyword arguments, if any
-  if (keyword_count > 0) {
-    if (num_keyword_args == 0) {
-      mesche_vm_raise_error(vm, "Function does not accept keyword arguments.");
-      return false;
-    }
-
-    // This is 15 keyword arguments and their values
-    Value stored_keyword_args[30];
-
-    // Find keyword arguments and copy them to temporary storage
+  // Replace the keyword/value pairs with one value for each of the function's
+  // keyword slots, using the default value of any keyword that wasn't passed.
+  // The slot values are first written above the pairs so that no pair is
+  // overwritten before it has been read.
+  if (num_keyword_args > 0) {
     Value *keyword_start = arg_start + arg_count;
-    Value *keyword_current = keyword_start;
-    for (int i = 0; i < keyword_count * 2; i++) {
-      // Copy the value to temporary storage
-      // TODO: Error if we've reached the storage max
-      stored_keyword_args[i] = *keyword_current;
-      keyword_current++;
-    }
+    const uint8_t *map =
+        keyword_count > 0 ? vm_keyword_map(vm, cache, (Object *)closure->function,
+                                           num_keyword_args, keyword_start, keyword_count)
+                          : NULL;
 
-    // Reset the top of the stack to the location of the first keyword argument
-    vm->stack_top = keyword_start;
-
-    // Now that we know where keywords start in the value stack, push the
-    // keyword default values on so that they line up with the local variables
-    // we've defined
+    Value *slot_values = vm->stack_top;
     KeywordArgument *keyword_arg = closure->function->keyword_args.args;
-    for (int i = 0; i < num_keyword_args; i++) {
-      // Check if the passed keyword args match this keyword
-      bool found_match = false;
-      for (int j = 0; j < keyword_count * 2; j += 2) {
-        if (mesche_object_string_equalsp((Object *)keyword_arg->name,
-                                         (Object *)AS_KEYWORD(stored_keyword_args[j]))) {
-          // Put the value on the stack
-          mesche_vm_stack_push(vm, stored_keyword_args[j + 1]);
-          found_match = true;
-        }
-      }
-
-      // Skip to the next keyword if the previous had a match
-      if (found_match) {
-        keyword_arg++;
-        continue;
-      }
-
-      // Apply default value of keyword argument
-      if (keyword_arg->default_index > 0) {
-        mesche_vm_stack_push(
-            vm, closure->function->chunk.constants.values[keyword_arg->default_index - 1]);
+    for (int i = 0; i < num_keyword_args; i++, keyword_arg++) {
+      if (map && map[i] != KEYWORD_NOT_PASSED) {
+        slot_values[i] = keyword_start[map[i] * 2 + 1];
+      } else if (keyword_arg->default_index > 0) {
+        slot_values[i] = closure->function->chunk.constants.values[keyword_arg->default_index - 1];
       } else {
         // If no default value was provided, choose `#f`
-        mesche_vm_stack_push(vm, FALSE_VAL);
+        slot_values[i] = FALSE_VAL;
       }
-
-      keyword_arg++;
     }
-  } else if (num_keyword_args > 0) {
-    // This branch is reached if the function takes keyword arguments but
-    // the caller didn't specify any.
 
-    KeywordArgument *keyword_arg = closure->function->keyword_args.args;
-    for (int i = 0; i < num_keyword_args; i++) {
-      // Apply default value of keyword argument
-      if (keyword_arg->default_index > 0) {
-        mesche_vm_stack_push(
-            vm, closure->function->chunk.constants.values[keyword_arg->default_index - 1]);
-      } else {
-        // If no default value was provided, choose `#f`
-        mesche_vm_stack_push(vm, FALSE_VAL);
-      }
-
-      keyword_arg++;
-    }
+    memmove(keyword_start, slot_values, sizeof(Value) * num_keyword_args);
+    vm->stack_top = keyword_start + num_keyword_args;
   }
 
   // Only process rest arguments if there is one and the number of passed arguments is
   // clearly enough to trigger it
   if (closure->function->rest_arg_index > 0) {
+    Value *rest_slot = arg_start + closure->function->rest_arg_index - 1;
     if (arg_count >= closure->function->arity) {
-      // Collapse all rest arguments into a single list:
-      // 1. Create a new cons using the value at rest index, save it back in the same spot
-      // 2. Repeat the process until all values have been integrated into the list
-      // 3. Shift the keyword argument values to fill the gap
-
-      mesche_vm_stack_push(vm, EMPTY_VAL);
-      int rest_value_count = (int)arg_count - closure->function->rest_arg_index + 1;
-      int rest_value_start = (int)num_keyword_args + 1;
-      for (int i = rest_value_start; i < rest_value_start + rest_value_count; i++) {
-        // Allocate the new cons pair in a way that avoids GC collection
-        ObjectCons *cons = mesche_object_make_cons(vm, vm_stack_peek(vm, i), vm_stack_peek(vm, 0));
-        mesche_vm_stack_pop(vm);
-        mesche_vm_stack_push(vm, OBJECT_VAL(cons));
-      }
-
-      // Move the new argument list variable into the argument position
-      ObjectCons *arg_list = AS_CONS(mesche_vm_stack_pop(vm));
-      *(vm->stack_top - (rest_value_start + rest_value_count - 1)) = OBJECT_VAL(arg_list);
-      vm->stack_top = arg_start + closure->function->arity + num_keyword_args;
+      // Collapse all rest arguments into a single list that is allocated in
+      // one step, then shift the keyword argument values to fill the gap
+      int rest_value_count = arg_count - closure->function->rest_arg_index + 1;
+      *rest_slot = mesche_object_make_list(vm, rest_slot, rest_value_count, EMPTY_VAL);
 
       // Copy the keyword arguments on top of the old value slots that we collapsed
       // into a single slot.
@@ -421,8 +713,7 @@ static bool vm_call(VM *vm, ObjectClosure *closure, uint8_t arg_count, uint8_t k
         // arg_count specifies the original argument count which includes the
         // individual rest arguments, so we use it to target the keyword values
         // that were placed after rest arguments.
-        memmove(arg_start + closure->function->arity, arg_start + arg_count,
-                sizeof(Value) * num_keyword_args);
+        memmove(rest_slot + 1, arg_start + arg_count, sizeof(Value) * num_keyword_args);
       }
 
       // Update the argument count to reflect the reduced amount
@@ -431,58 +722,43 @@ static bool vm_call(VM *vm, ObjectClosure *closure, uint8_t arg_count, uint8_t k
       // Fill in rest arg with #f if nothing was passed for it
       if (num_keyword_args > 0) {
         // Shift the keyword args forward by 1
-        memmove(arg_start + closure->function->arity + 1, arg_start + closure->function->arity,
-                sizeof(Value) * num_keyword_args);
+        memmove(rest_slot + 1, rest_slot, sizeof(Value) * num_keyword_args);
       }
 
-      // Place the #f value and update the stack top
-      *(vm->stack_top - num_keyword_args) = FALSE_VAL;
-      vm->stack_top = arg_start + closure->function->arity + num_keyword_args;
+      *rest_slot = FALSE_VAL;
+      arg_count++;
     }
-  }
-
-  if (is_tail_call) {
-    // Reuse the existing frame
-    CallFrame *frame = &vm->frames[vm->frame_count - 1];
 
-    // Close out upvalues for any function locals that have been captured by
-    // closures before we wipe them from the stack
-    vm_close_upvalues(vm, frame->slots);
-
-    // Copy the new arguments (and the closure value itself) on top of the old
-    // slots (add 1 to the argument counts because we're also copying the callee
-    // value).
-    //
-    // NOTE: we're using num_keyword_arguments because values for all keyword
-    // arguments will be sent to the call regardless of whether the caller
-    // specified them!
-    memmove(frame->slots, arg_start - 1, sizeof(Value) * (arg_count + num_keyword_args + 1));
+    vm->stack_top = arg_start + arg_count + num_keyword_args;
+  }
 
-    // Reset the top of the value stack to shrink it back to where it was before
-    vm->stack_top = frame->slots + arg_count + num_keyword_args + 1;
+  return vm_call_enter(vm, closure, arg_start, arg_count + num_keyword_args, is_tail_call);
+}
 
-    // Set up the closure and instruction pointer to continue execution
-    frame->closure = closure;
-    frame->ip = closure->function->chunk.code;
-    frame->total_arg_count = arg_count + num_keyword_args;
-    return true;
-  } else {
-    CallFrame *frame = &vm->frames[vm->frame_count++];
-    frame->closure = closure;
-    frame->ip = closure->function->chunk.code;
-    frame->slots = arg_start - 1;
+static inline bool vm_call_native(VM *vm, FunctionPtr func_ptr, int total_args) {
+  // Give the native function room to push temporary values
+  if (!vm_stack_reserve(vm, STACK_HEADROOM)) {
+    mesche_vm_raise_error(vm, "Value stack overflow, exceeded maximum size of %d values.",
+                          vm->stack_max);
+    return false;
+  }
 
-    // The total argument count is plain argument count plus number of
-    // keyword arguments because we've removed the keywords from the list
-    // and left either the specified value or the default.
-    frame->total_arg_count = arg_count + num_keyword_args;
+  // TODO: Need to push the native function on the stack somehow
+  Value result = func_ptr(vm, total_args, vm->stack_top - total_args);
 
-    return true;
+  // The stack has already been reset if the native function raised an error
+  if (!vm->is_running) {
+    return false;
   }
+
+  // Pop off all of the arguments and the function itself, then push the result
+  vm->stack_top -= total_args + 1;
+  mesche_vm_stack_push(vm, result);
+  return true;
 }
 
-static bool vm_call_value(VM *vm, Value callee, uint8_t arg_count, uint8_t keyword_count,
-                          bool is_tail_call) {
+static bool vm_call_value(VM *vm, Value callee, CallCache *cache, int arg_count,
+                          uint8_t keyword_count, bool is_tail_call) {
   if (IS_OBJECT(callee)) {
     switch (OBJECT_KIND(callee)) {
     case ObjectKindFunction: {
@@ -492,62 +768,45 @@ static bool vm_call_value(VM *vm, Value callee, uint8_t arg_count, uint8_t keywo
       mesche_vm_stack_push(vm, OBJECT_VAL(closure));
 
       // Invoke the new closure as a normal call, not a tail call
-      return vm_call(vm, closure, arg_count, keyword_count, false);
+      return vm_call(vm, closure, cache, arg_count, keyword_count, false);
     }
     case ObjectKindClosure:
-      return vm_call(vm, AS_CLOSURE(callee), arg_count, keyword_count, is_tail_call);
-    case ObjectKindNativeFunction: {
-      FunctionPtr func_ptr = AS_NATIVE_FUNC(callee);
-      int total_args = arg_count + keyword_count * 2;
-      // TODO: Need to push the native function on the stack somehow
-      Value result = func_ptr(vm, total_args, vm->stack_top - total_args);
-
-      // Pop off all of the arguments and the function itself
-      for (int i = 0; i < total_args + 1; i++) {
-        mesche_vm_stack_pop(vm);
-      }
-
-      // Push the result to store it
-      mesche_vm_stack_push(vm, result);
-      return true;
-    }
+      return vm_call(vm, AS_CLOSURE(callee), cache, arg_count, keyword_count, is_tail_call);
+    case ObjectKindNativeFunction:
+      return vm_call_native(vm, AS_NATIVE_FUNC(callee), arg_count + keyword_count * 2);
     case ObjectKindRecord: {
       ObjectRecord *record_type = AS_RECORD_TYPE(callee);
-      ObjectRecordInstance *instance = mesche_object_make_record_instance(vm, record_type);
-      mesche_vm_stack_push(vm, OBJECT_VAL(instance));
-
-      // Initialize the value array using keyword values or the default for each field
-      for (int i = 0; i < record_type->fields.count; i++) {
-        bool found_value = false;
-        ObjectRecordField *record_field = AS_RECORD_FIELD(record_type->fields.values[i]);
-
-        // Look for the field's value in the arguments
-        for (int i = arg_count; i >= 0; i -= 2) {
-          ObjectKeyword *keyword_arg = AS_KEYWORD(vm_stack_peek(vm, i));
-          if (mesche_object_string_equalsp((Object *)record_field->name, (Object *)keyword_arg)) {
-            mesche_value_array_write((MescheMemory *)vm, &instance->field_values,
-                                     vm_stack_peek(vm, i - 1));
-            found_value = true;
-            break;
-          }
-        }
-
-        // If the value wasn't found, use the default
-        if (!found_value) {
-          mesche_value_array_write((MescheMemory *)vm, &instance->field_values,
-                                   record_field->default_value);
-        }
+      int field_count = record_type->field_defaults.count;
+      if (arg_count > field_count) {
+        mesche_vm_raise_error(vm, "Record type '%s' has %d fields but received %d values.",
+                              record_type->name->chars, field_count, arg_count);
+        return false;
       }
 
-      // Pop the record instance off the stack first
-      mesche_vm_stack_pop(vm);
+      Value *args = vm->stack_top - arg_count - keyword_count * 2;
+      const uint8_t *map =
+          keyword_count > 0 ? vm_keyword_map(vm, cache, (Object *)record_type, field_count,
+                                             args + arg_count, keyword_count)
+                            : NULL;
 
-      // Pop the record and key/value pairs off the stack
-      for (int i = 0; i < arg_count + 1; i++) {
-        mesche_vm_stack_pop(vm);
+      // The instance starts out with the default value of every field.
+      // Positional values fill the leading fields in order and keyword values
+      // fill the fields they name.
+      ObjectRecordInstance *instance = mesche_object_make_record_instance(vm, record_type);
+      args = vm->stack_top - arg_count - keyword_count * 2;
+      Value *field_values = instance->field_values;
+      memcpy(field_values, args, sizeof(Value) * arg_count);
+      if (map) {
+        Value *pairs = args + arg_count;
+        for (int i = 0; i < field_count; i++) {
+          if (map[i] != KEYWORD_NOT_PASSED) {
+            field_values[i] = pairs[map[i] * 2 + 1];
+          }
+        }
       }
 
-      // Push the record instance back on to the stack as the result
+      // Replace the record type and its arguments with the new instance
+      vm->stack_top = args - 1;
       mesche_vm_stack_push(vm, OBJECT_VAL(instance));
       return true;
     };
@@ -565,7 +824,7 @@ static bool vm_call_value(VM *vm, Value callee, uint8_t arg_count, uint8_t keywo
       if (!IS_OBJECT(possible_instance)) {
         mesche_vm_raise_error(
             vm, "Expected instance of record type %s but received non-object kind %d.",
-            accessor->record_type->name->chars, possible_instance.kind);
+            accessor->record_type->name->chars, VALUE_KIND(possible_instance));
         return false;
       }
 
@@ -590,7 +849,7 @@ static bool vm_call_value(VM *vm, Value callee, uint8_t arg_count, uint8_t keywo
       mesche_vm_stack_pop(vm);
 
       // Return the value on the stack
-      mesche_vm_stack_push(vm, instance->field_values.values[accessor->field_index]);
+      mesche_vm_stack_push(vm, instance->field_values[accessor->field_index]);
       return true;
     }
     case ObjectKindRecordFieldSetter: {
@@ -609,7 +868,7 @@ static bool vm_call_value(VM *vm, Value callee, uint8_t arg_count, uint8_t keywo
       if (!IS_OBJECT(possible_instance)) {
         mesche_vm_raise_error(
             vm, "Expected instance of record type %s but received non-object kind %d.",
-            setter->record_type->name->chars, possible_instance.kind);
+            setter->record_type->name->chars, VALUE_KIND(possible_instance));
         return false;
       }
 
@@ -634,7 +893,8 @@ static bool vm_call_value(VM *vm, Value callee, uint8_t arg_count, uint8_t keywo
       mesche_vm_stack_pop(vm);
 
       // Set the field's value and return that same value
-      instance->field_values.values[setter->field_index] = value;
+      instance->field_values[setter->field_index] = value;
+      mesche_gc_write_barrier(vm, (Object *)instance);
       mesche_vm_stack_push(vm, value);
       return true;
     }
@@ -668,12 +928,147 @@ static bool vm_call_value(VM *vm, Value callee, uint8_t arg_count, uint8_t keywo
   return false;
 }
 
+// Rewrites a call site that invoked a record field accessor or setter into the
+// matching OP_RECORD_REF or OP_RECORD_SET instruction, which keeps the call's
+// operands.  The site's cache holds the accessor or setter it was specialized
+// for so that sites which see several of them stay generic.
+static inline void vm_call_site_specialize(CallCache *cache, uint8_t *op, Object *object,
+                                           uint8_t arg_count, uint8_t keyword_count) {
+  if (keyword_count > 0 || (cache->callees[0] != NULL && cache->callees[0] != object)) {
+    return;
+  }
+
+  bool is_tail_call = *op == OP_TAIL_CALL;
+  if (object->kind == ObjectKindRecordFieldAccessor && arg_count == 1) {
+    *op = is_tail_call ? OP_TAIL_RECORD_REF : OP_RECORD_REF;
+  } else if (object->kind == ObjectKindRecordFieldSetter && arg_count == 2) {
+    *op = is_tail_call ? OP_TAIL_RECORD_SET : OP_RECORD_SET;
+  } else {
+    return;
+  }
+
+  cache->callees[0] = object;
+}
+
+// Call site caches live in the calling function's chunk, which has to be
+// remembered before a cache miss stores a new callee or keyword map in it
+static inline void vm_call_site_barrier(VM *vm) {
+  mesche_gc_write_barrier(vm, (Object *)vm->frames[vm->frame_count - 1].closure->function);
+}
+
+// Calls the callee of an OP_CALL or OP_TAIL_CALL site whose opcode is at `op`.
+// Callees that are found in the site's cache have already had their arity
+// validated for this site so they skip straight to frame setup or the native
+// function pointer.
+static inline bool vm_call_site(VM *vm, CallCache *cache, uint8_t *op, uint8_t arg_count,
+                                uint8_t keyword_count, bool is_tail_call) {
+  // Allocation can't fail in the middle of an instruction, so running out of
+  // memory is reported at the next call.  Every loop goes through a call.
+  if (vm->mem.is_out_of_memory) {
+    vm->mem.is_out_of_memory = false;
+    mesche_vm_raise_error(vm, "Out of memory, exceeded heap limit of %zu bytes.",
+                          vm->mem.heap_limit);
+    return false;
+  }
+
+  // Objects that were collected release their native resources here instead
+  // of while the heap is swept, a batch at a time
+  if (vm->finalizer_count > 0) {
+    mesche_gc_run_finalizers(vm, GC_FINALIZER_BATCH_SIZE);
+  }
+
+  Value callee = vm_stack_peek(vm, arg_count + (keyword_count * 2));
+  if (!IS_OBJECT(callee)) {
+    return vm_call_value(vm, callee, cache, arg_count, keyword_count, is_tail_call);
+  }
+
+  // Closures are cached by their function so that every closure created from
+  // the same lambda hits the same entry
+  Object *object = AS_OBJECT(callee);
+  Object *key = NULL;
+  if (object->kind == ObjectKindClosure) {
+    key = (Object *)((ObjectClosure *)object)->function;
+  } else if (object->kind == ObjectKindNativeFunction) {
+    key = object;
+  } else {
+    vm_call_site_barrier(vm);
+    if (!vm_call_value(vm, callee, cache, arg_count, keyword_count, is_tail_call)) {
+      return false;
+    }
+
+    vm_call_site_specialize(cache, op, object, arg_count, keyword_count);
+    return true;
+  }
+
+  for (int i = 0; i < CALL_CACHE_WAYS; i++) {
+    if (cache->callees[i] == key) {
+      if (key == object) {
+        return vm_call_native(vm, ((ObjectNativeFunction *)object)->function,
+                              arg_count + keyword_count * 2);
+      }
+
+      ObjectClosure *closure = (ObjectClosure *)object;
+      if (!vm_call_reserve(vm, closure, is_tail_call)) {
+        return false;
+      }
+
+      return vm_call_enter(vm, closure, vm->stack_top - arg_count, arg_count, is_tail_call);
+    }
+  }
+
+  // Only closures that need no argument processing at this site can be cached
+  bool cacheable = true;
+  if (key != object) {
+    ObjectFunction *function = (ObjectFunction *)key;
+    cacheable = keyword_count == 0 && function->rest_arg_index == 0 &&
+                function->keyword_args.count == 0 && function->arity == arg_count;
+  }
+
+  vm_call_site_barrier(vm);
+  if (!vm_call_value(vm, callee, cache, arg_count, keyword_count, is_tail_call)) {
+    return false;
+  }
+
+  // Make the new callee the most recent entry, evicting the oldest
+  if (cacheable) {
+    memmove(&cache->callees[1], &cache->callees[0], sizeof(Object *) * (CALL_CACHE_WAYS - 1));
+    cache->callees[0] = key;
+  }
+
+  return true;
+}
+
+// Resolves a global variable name to a binding slot in the given module (or in
+// the core module if `search_core` is set) and stores the result in the cache
+static bool vm_global_resolve(VM *vm, GlobalCache *cache, ObjectModule *module,
+                              ObjectString *name, bool search_core) {
+  ObjectModule *owner = module;
+  int slot = mesche_module_binding_find(module, name);
+  if (slot < 0 && search_core && vm->core_module) {
+    owner = vm->core_module;
+    slot = mesche_module_binding_find(owner, name);
+  }
+
+  if (slot < 0) {
+    return false;
+  }
+
+  cache->module = module;
+  cache->owner = owner;
+  cache->slot = slot;
+  cache->epoch = vm->binding_epoch;
+
+  return true;
+}
+
 static bool vm_create_module_binding(VM *vm, ObjectModule *module, ObjectString *binding_name,
                                      Value value, bool exported) {
-  bool binding_exists = !mesche_table_set((MescheMemory *)vm, &module->locals, binding_name, value);
+  bool binding_exists = mesche_module_binding_find(module, binding_name) >= 0;
+  mesche_module_binding_define(vm, module, binding_name, value);
 
   if (exported) {
     mesche_value_array_write((MescheMemory *)vm, &module->exports, OBJECT_VAL(binding_name));
+    mesche_gc_write_barrier(vm, (Object *)module);
   }
 
   return binding_exists;
@@ -684,28 +1079,279 @@ InterpretResult mesche_vm_run(VM *vm) {
   CallFrame *frame = &vm->frames[vm->frame_count - 1];
   ObjectModule *prev_module = NULL;
 
-#define READ_BYTE() (*frame->ip++)
-#define READ_SHORT() (frame->ip += 2, (uint16_t)((frame->ip[-2] << 8) | frame->ip[-1]))
-#define READ_CONSTANT() (frame->closure->function->chunk.constants.values[READ_BYTE()])
+  // The instruction pointer, value stack top, constants and global caches of
+  // the current frame are cached in locals so that the compiler can keep them in
+  // registers.  They must be written back with SYNC_STATE before calling
+  // anything that reads them through the VM (calls, allocations, errors) and
+  // reloaded with LOAD_STATE afterward since the active frame may change.
+  uint8_t *ip = frame->ip;
+  Value *sp = vm->stack_top;
+  Value *constants = frame->closure->function->chunk.constants.values;
+  GlobalCache *global_caches = frame->closure->function->chunk.global_caches;
+
+#define SYNC_STATE() (frame->ip = ip, vm->stack_top = sp)
+#define LOAD_STATE()                                                                               \
+  do {                                                                                             \
+    frame = &vm->frames[vm->frame_count - 1];                                                      \
+    ip = frame->ip;                                                                                \
+    sp = vm->stack_top;                                                                            \
+    constants = frame->closure->function->chunk.constants.values;                                  \
+    global_caches = frame->closure->function->chunk.global_caches;                                 \
+  } while (false)
+
+#define READ_BYTE() (*ip++)
+#define READ_SHORT() (ip += 2, (uint16_t)((ip[-2] << 8) | ip[-1]))
+#define READ_CONSTANT() (constants[READ_BYTE()])
 #define READ_STRING() AS_STRING(READ_CONSTANT())
 #define CURRENT_MODULE() (frame->closure->module ? frame->closure->module : vm->current_module)
 
-// TODO: Don't pop 'a', manipulate top of stack
-#define BINARY_OP(value_type, pred, cast, op)                                                      \
+#define PUSH(value) (*sp++ = (value))
+#define POP() (*--sp)
+#define PEEK(distance) (sp[-1 - (distance)])
+
+#define RUNTIME_ERROR(...)                                                                         \
+  do {                                                                                             \
+    SYNC_STATE();                                                                                  \
+    mesche_vm_raise_error(vm, __VA_ARGS__);                                                        \
+    return INTERPRET_RUNTIME_ERROR;                                                                \
+  } while (false)
+
+// Superinstruction helpers, see compiler_fuse_instructions for the layout of
+// the fused sequences.  `ip` points just past the superinstruction's opcode.
+#define LOCAL_CONSTANT_OP(number_op)                                                               \
+  do {                                                                                             \
+    Value a = frame->slots[ip[0]];                                                                 \
+    Value b = constants[ip[2]];                                                                    \
+    ip += 4;                                                                                       \
+    if (!IS_NUMBER(a) || !IS_NUMBER(b)) {                                                          \
+      RUNTIME_ERROR("Operands must be numbers.");                                                  \
+    }                                                                                              \
+    PUSH(number_op(a, b));                                                                         \
+  } while (false)
+
+#define COMPARE_JUMP_IF_FALSE(op)                                                                  \
+  do {                                                                                             \
+    Value b = PEEK(0);                                                                             \
+    Value a = PEEK(1);                                                                             \
+    if (!IS_NUMBER(a) || !IS_NUMBER(b)) {                                                          \
+      RUNTIME_ERROR("Operands must be numbers.");                                                  \
+    }                                                                                              \
+    sp -= 2;                                                                                       \
+    if (NUMBER_COMPARE(a, op, b)) {                                                                \
+      /* Skip the OP_JUMP_IF_FALSE and the OP_POP of the true branch */                            \
+      ip += 4;                                                                                     \
+    } else {                                                                                       \
+      /* Jump past the OP_POP at the start of the false branch */                                  \
+      ip += 3 + (uint16_t)((ip[1] << 8) | ip[2]) + 1;                                              \
+    }                                                                                              \
+  } while (false)
+
+// Generic arithmetic and comparison opcodes quicken themselves based on the
+// operands they see: two fixnums turn the opcode into its `*_FIX` variant and
+// two doubles into its `*_NUM` variant so that later executions go straight to
+// that case.  Mixed operands leave the opcode as it is.  Each generic opcode
+// quickens and then falls through to its `*_ANY` variant, which does the work.
+#define QUICKEN(a, b, fixnum_opcode, flonum_opcode)                                                \
+  if (IS_FIXNUM(a) && IS_FIXNUM(b)) {                                                              \
+    ip[-1] = fixnum_opcode;                                                                        \
+  } else if (IS_FLONUM(a) && IS_FLONUM(b)) {                                                       \
+    ip[-1] = flonum_opcode;                                                                        \
+  }
+
+#define ARITHMETIC_OP(number_op)                                                                   \
+  do {                                                                                             \
+    Value b = PEEK(0);                                                                             \
+    Value a = PEEK(1);                                                                             \
+    if (!IS_NUMBER(a) || !IS_NUMBER(b)) {                                                          \
+      RUNTIME_ERROR("Operands must be numbers.");                                                  \
+    }                                                                                              \
+    sp--;                                                                                          \
+    sp[-1] = number_op(a, b);                                                                      \
+  } while (false)
+
+#define COMPARE_OP(op)                                                                             \
+  do {                                                                                             \
+    Value b = PEEK(0);                                                                             \
+    Value a = PEEK(1);                                                                             \
+    if (!IS_NUMBER(a) || !IS_NUMBER(b)) {                                                          \
+      RUNTIME_ERROR("Operands must be numbers.");                                                  \
+    }                                                                                              \
+    sp--;                                                                                          \
+    sp[-1] = BOOL_VAL(NUMBER_COMPARE(a, op, b));                                                   \
+  } while (false)
+
+// Quickened number operations update the top of the stack in place.  If the
+// operands are not of the expected kind, or a fixnum result overflows, the
+// opcode is replaced by its `*_ANY` variant and executed again so that the
+// generic handler decides what to do.  The site stays generic from then on.
+#define DEOPTIMIZE(generic) (ip[-1] = (generic), ip--)
+
+#define FLONUM_OP(value_type, op, generic)                                                         \
+  do {                                                                                             \
+    if (IS_FLONUM(sp[-1]) && IS_FLONUM(sp[-2])) {                                                  \
+      sp--;                                                                                        \
+      sp[-1] = value_type(AS_FLONUM(sp[-1]) op AS_FLONUM(sp[0]));                                  \
+    } else {                                                                                       \
+      DEOPTIMIZE(generic);                                                                         \
+    }                                                                                              \
+  } while (false)
+
+#define FIXNUM_ARITHMETIC_OP(checked_op, generic)                                                  \
+  do {                                                                                             \
+    int64_t result;                                                                                \
+    if (IS_FIXNUM(sp[-1]) && IS_FIXNUM(sp[-2]) &&                                                  \
+        !checked_op(AS_FIXNUM(sp[-2]), AS_FIXNUM(sp[-1]), &result) && FIXNUM_FITS(result)) {       \
+      sp--;                                                                                        \
+      sp[-1] = FIXNUM_VAL(result);                                                                 \
+    } else {                                                                                       \
+      DEOPTIMIZE(generic);                                                                         \
+    }                                                                                              \
+  } while (false)
+
+#define FIXNUM_COMPARE_OP(op, generic)                                                             \
   do {                                                                                             \
-    if (!pred(vm_stack_peek(vm, 0)) || !pred(vm_stack_peek(vm, 1))) {                              \
-      mesche_vm_raise_error(vm, "Operands must be numbers.");                                      \
-      return INTERPRET_RUNTIME_ERROR;                                                              \
+    if (IS_FIXNUM(sp[-1]) && IS_FIXNUM(sp[-2])) {                                                  \
+      sp--;                                                                                        \
+      sp[-1] = BOOL_VAL(AS_FIXNUM(sp[-1]) op AS_FIXNUM(sp[0]));                                    \
+    } else {                                                                                       \
+      DEOPTIMIZE(generic);                                                                         \
     }                                                                                              \
-    double b = cast(mesche_vm_stack_pop(vm));                                                      \
-    double a = cast(mesche_vm_stack_pop(vm));                                                      \
-    mesche_vm_stack_push(vm, value_type(a op b));                                                  \
   } while (false)
 
+// Threaded dispatch: when the compiler supports "labels as values", each
+// instruction handler jumps directly to the handler of the next instruction
+// through a label table instead of looping back to a single `switch`.  This
+// gives the branch predictor one indirect jump per opcode to learn from.
+// Execution tracing and opcode pair profiling need a single place to hook into
+// so they always use the `switch` version.
+#if defined(__GNUC__) && !defined(DEBUG_TRACE_EXECUTION) &&                                        \
+    !defined(DEBUG_PROFILE_OPCODE_PAIRS) && !defined(VM_DISABLE_COMPUTED_GOTO)
+#define VM_COMPUTED_GOTO
+#endif
+
+#ifdef VM_COMPUTED_GOTO
+  static void *dispatch_table[256] = {
+      [0 ... 255] = &&op_UNKNOWN,
+      [OP_NOP] = &&op_OP_NOP,
+      [OP_CONSTANT] = &&op_OP_CONSTANT,
+      [OP_FALSE] = &&op_OP_FALSE,
+      [OP_TRUE] = &&op_OP_TRUE,
+      [OP_EMPTY] = &&op_OP_EMPTY,
+      [OP_POP] = &&op_OP_POP,
+      [OP_POP_SCOPE] = &&op_OP_POP_SCOPE,
+      [OP_CONS] = &&op_OP_CONS,
+      [OP_LIST] = &&op_OP_LIST,
+      [OP_ADD] = &&op_OP_ADD,
+      [OP_SUBTRACT] = &&op_OP_SUBTRACT,
+      [OP_MULTIPLY] = &&op_OP_MULTIPLY,
+      [OP_DIVIDE] = &&op_OP_DIVIDE,
+      [OP_MODULO] = &&op_OP_MODULO,
+      [OP_NOT] = &&op_OP_NOT,
+      [OP_GREATER_THAN] = &&op_OP_GREATER_THAN,
+      [OP_GREATER_EQUAL] = &&op_OP_GREATER_EQUAL,
+      [OP_LESS_THAN] = &&op_OP_LESS_THAN,
+      [OP_LESS_EQUAL] = &&op_OP_LESS_EQUAL,
+      [OP_EQV] = &&op_OP_EQV,
+      [OP_EQUAL] = &&op_OP_EQUAL,
+      [OP_LOAD_FILE] = &&op_OP_LOAD_FILE,
+      [OP_DEFINE_RECORD] = &&op_OP_DEFINE_RECORD,
+      [OP_DEFINE_MODULE] = &&op_OP_DEFINE_MODULE,
+      [OP_IMPORT_MODULE] = &&op_OP_IMPORT_MODULE,
+      [OP_ENTER_MODULE] = &&op_OP_ENTER_MODULE,
+      [OP_EXPORT_SYMBOL] = &&op_OP_EXPORT_SYMBOL,
+      [OP_DEFINE_GLOBAL] = &&op_OP_DEFINE_GLOBAL,
+      [OP_SET_GLOBAL] = &&op_OP_SET_GLOBAL,
+      [OP_SET_UPVALUE] = &&op_OP_SET_UPVALUE,
+      [OP_SET_LOCAL] = &&op_OP_SET_LOCAL,
+      [OP_READ_GLOBAL] = &&op_OP_READ_GLOBAL,
+      [OP_READ_UPVALUE] = &&op_OP_READ_UPVALUE,
+      [OP_READ_LOCAL] = &&op_OP_READ_LOCAL,
+      [OP_JUMP] = &&op_OP_JUMP,
+      [OP_JUMP_IF_FALSE] = &&op_OP_JUMP_IF_FALSE,
+      [OP_CALL] = &&op_OP_CALL,
+      [OP_TAIL_CALL] = &&op_OP_TAIL_CALL,
+      [OP_CLOSURE] = &&op_OP_CLOSURE,
+      [OP_CLOSE_UPVALUE] = &&op_OP_CLOSE_UPVALUE,
+      [OP_APPLY] = &&op_OP_APPLY,
+      [OP_TAIL_APPLY] = &&op_OP_TAIL_APPLY,
+      [OP_RECORD_REF] = &&op_OP_RECORD_REF,
+      [OP_TAIL_RECORD_REF] = &&op_OP_TAIL_RECORD_REF,
+      [OP_RECORD_SET] = &&op_OP_RECORD_SET,
+      [OP_TAIL_RECORD_SET] = &&op_OP_TAIL_RECORD_SET,
+      [OP_DISPLAY] = &&op_OP_DISPLAY,
+      [OP_RESET] = &&op_OP_RESET,
+      [OP_SHIFT] = &&op_OP_SHIFT,
+      [OP_REIFY] = &&op_OP_REIFY,
+      [OP_BREAK] = &&op_OP_BREAK,
+      [OP_RETURN] = &&op_OP_RETURN,
+      [OP_READ_LOCAL_LOCAL] = &&op_OP_READ_LOCAL_LOCAL,
+      [OP_READ_LOCAL_CONSTANT] = &&op_OP_READ_LOCAL_CONSTANT,
+      [OP_LOCAL_CONSTANT_ADD] = &&op_OP_LOCAL_CONSTANT_ADD,
+      [OP_LOCAL_CONSTANT_SUBTRACT] = &&op_OP_LOCAL_CONSTANT_SUBTRACT,
+      [OP_LESS_THAN_JUMP_IF_FALSE] = &&op_OP_LESS_THAN_JUMP_IF_FALSE,
+      [OP_LESS_EQUAL_JUMP_IF_FALSE] = &&op_OP_LESS_EQUAL_JUMP_IF_FALSE,
+      [OP_GREATER_THAN_JUMP_IF_FALSE] = &&op_OP_GREATER_THAN_JUMP_IF_FALSE,
+      [OP_GREATER_EQUAL_JUMP_IF_FALSE] = &&op_OP_GREATER_EQUAL_JUMP_IF_FALSE,
+      [OP_ADD_NUM] = &&op_OP_ADD_NUM,
+      [OP_SUBTRACT_NUM] = &&op_OP_SUBTRACT_NUM,
+      [OP_MULTIPLY_NUM] = &&op_OP_MULTIPLY_NUM,
+      [OP_DIVIDE_NUM] = &&op_OP_DIVIDE_NUM,
+      [OP_GREATER_THAN_NUM] = &&op_OP_GREATER_THAN_NUM,
+      [OP_GREATER_EQUAL_NUM] = &&op_OP_GREATER_EQUAL_NUM,
+      [OP_LESS_THAN_NUM] = &&op_OP_LESS_THAN_NUM,
+      [OP_LESS_EQUAL_NUM] = &&op_OP_LESS_EQUAL_NUM,
+      [OP_EQV_NUM] = &&op_OP_EQV_NUM,
+      [OP_EQUAL_NUM] = &&op_OP_EQUAL_NUM,
+      [OP_ADD_FIX] = &&op_OP_ADD_FIX,
+      [OP_SUBTRACT_FIX] = &&op_OP_SUBTRACT_FIX,
+      [OP_MULTIPLY_FIX] = &&op_OP_MULTIPLY_FIX,
+      [OP_GREATER_THAN_FIX] = &&op_OP_GREATER_THAN_FIX,
+      [OP_GREATER_EQUAL_FIX] = &&op_OP_GREATER_EQUAL_FIX,
+      [OP_LESS_THAN_FIX] = &&op_OP_LESS_THAN_FIX,
+      [OP_LESS_EQUAL_FIX] = &&op_OP_LESS_EQUAL_FIX,
+      [OP_EQV_FIX] = &&op_OP_EQV_FIX,
+      [OP_EQUAL_FIX] = &&op_OP_EQUAL_FIX,
+      [OP_ADD_ANY] = &&op_OP_ADD_ANY,
+      [OP_SUBTRACT_ANY] = &&op_OP_SUBTRACT_ANY,
+      [OP_MULTIPLY_ANY] = &&op_OP_MULTIPLY_ANY,
+      [OP_DIVIDE_ANY] = &&op_OP_DIVIDE_ANY,
+      [OP_GREATER_THAN_ANY] = &&op_OP_GREATER_THAN_ANY,
+      [OP_GREATER_EQUAL_ANY] = &&op_OP_GREATER_EQUAL_ANY,
+      [OP_LESS_THAN_ANY] = &&op_OP_LESS_THAN_ANY,
+      [OP_LESS_EQUAL_ANY] = &&op_OP_LESS_EQUAL_ANY,
+      [OP_EQV_ANY] = &&op_OP_EQV_ANY,
+      [OP_EQUAL_ANY] = &&op_OP_EQUAL_ANY,
+  };
+
+#define DISPATCH() goto *dispatch_table[READ_BYTE()]
+#define CASE(opcode) op_##opcode
+#define NEXT() DISPATCH()
+#define UNKNOWN_OPCODE() op_UNKNOWN
+#else
+#define DISPATCH() switch (READ_BYTE())
+#define CASE(opcode) case opcode
+#define NEXT() break
+#define UNKNOWN_OPCODE() default
+#endif
+
   vm->is_running = true;
 
+#ifdef DEBUG_PROFILE_OPCODE_PAIRS
+  uint8_t previous_opcode = OP_NOP;
+#endif
+
+#ifdef VM_COMPUTED_GOTO
+  DISPATCH();
+#else
   for (;;) {
+#ifdef DEBUG_PROFILE_OPCODE_PAIRS
+    opcode_pair_counts[previous_opcode][*ip]++;
+    previous_opcode = *ip;
+#endif
+
 #ifdef DEBUG_TRACE_EXECUTION
+    SYNC_STATE();
+
     bool TRACE_THIS = false;
     const bool TRACE_ALL = true;
     const int TRACE_INSTRUCTIONS[] = {OP_RESET,     OP_SHIFT,  OP_REIFY, OP_CALL,
@@ -749,44 +1395,38 @@ InterpretResult mesche_vm_run(VM *vm) {
     }
 #endif
 
-    uint8_t instr;
-    Value value;
-    ObjectString *name;
-    uint8_t slot = 0;
-
-    switch (instr = READ_BYTE()) {
-    case OP_NOP:
+    DISPATCH() {
+#endif
+    CASE(OP_NOP) :
       // Do nothing!
-      break;
-    case OP_CONSTANT:
-      value = READ_CONSTANT();
-      mesche_vm_stack_push(vm, value);
-      break;
-    case OP_FALSE:
-      mesche_vm_stack_push(vm, FALSE_VAL);
-      break;
-    case OP_TRUE:
-      mesche_vm_stack_push(vm, TRUE_VAL);
-      break;
-    case OP_EMPTY:
-      mesche_vm_stack_push(vm, EMPTY_VAL);
-      break;
-    case OP_POP:
-      mesche_vm_stack_pop(vm);
-      break;
-    case OP_POP_SCOPE: {
-      // Only start popping if we have locals to clear
+      NEXT();
+    CASE(OP_CONSTANT) :
+      PUSH(READ_CONSTANT());
+      NEXT();
+    CASE(OP_FALSE) :
+      PUSH(FALSE_VAL);
+      NEXT();
+    CASE(OP_TRUE) :
+      PUSH(TRUE_VAL);
+      NEXT();
+    CASE(OP_EMPTY) :
+      PUSH(EMPTY_VAL);
+      NEXT();
+    CASE(OP_POP) :
+      sp--;
+      NEXT();
+    CASE(OP_POP_SCOPE) : {
+      // Drop the scope's locals but keep the result value on top
       uint8_t local_count = READ_BYTE();
       if (local_count > 0) {
-        Value result = mesche_vm_stack_pop(vm);
-        for (int i = 0; i < local_count; i++) {
-          mesche_vm_stack_pop(vm);
-        }
-        mesche_vm_stack_push(vm, result);
+        Value result = PEEK(0);
+        sp -= local_count;
+        sp[-1] = result;
       }
-      break;
+      NEXT();
     }
-    case OP_CONS: {
+    CASE(OP_CONS) : {
+      SYNC_STATE();
       Value car = vm_stack_peek(vm, 1);
       Value cdr = vm_stack_peek(vm, 0);
       Value cons = OBJECT_VAL(mesche_object_make_cons(vm, car, cdr));
@@ -796,11 +1436,13 @@ InterpretResult mesche_vm_run(VM *vm) {
       mesche_vm_stack_pop(vm);
       mesche_vm_stack_push(vm, cons);
 
-      break;
+      LOAD_STATE();
+      NEXT();
     }
-    case OP_LIST: {
-      ObjectCons *list = NULL;
+    CASE(OP_LIST) : {
       uint8_t item_count = READ_BYTE();
+      SYNC_STATE();
+      ObjectCons *list = NULL;
       if (item_count == 0) {
         mesche_vm_stack_push(vm, EMPTY_VAL);
       } else {
@@ -830,66 +1472,156 @@ InterpretResult mesche_vm_run(VM *vm) {
 
         mesche_vm_stack_push(vm, OBJECT_VAL(list));
       }
-      break;
+      LOAD_STATE();
+      NEXT();
     }
-    case OP_ADD:
-      BINARY_OP(NUMBER_VAL, IS_NUMBER, AS_NUMBER, +);
-      break;
-    case OP_SUBTRACT:
-      BINARY_OP(NUMBER_VAL, IS_NUMBER, AS_NUMBER, -);
-      break;
-    case OP_MULTIPLY:
-      BINARY_OP(NUMBER_VAL, IS_NUMBER, AS_NUMBER, *);
-      break;
-    case OP_DIVIDE:
-      BINARY_OP(NUMBER_VAL, IS_NUMBER, AS_NUMBER, /);
-      break;
-    case OP_MODULO: {
-      if (!IS_NUMBER(vm_stack_peek(vm, 0)) || !IS_NUMBER(vm_stack_peek(vm, 1))) {
-        mesche_vm_raise_error(vm, "Operands must be numbers.");
-        return INTERPRET_RUNTIME_ERROR;
+    CASE(OP_ADD) :
+      QUICKEN(PEEK(1), PEEK(0), OP_ADD_FIX, OP_ADD_NUM);
+    CASE(OP_ADD_ANY) :
+      ARITHMETIC_OP(mesche_number_add);
+      NEXT();
+    CASE(OP_SUBTRACT) :
+      QUICKEN(PEEK(1), PEEK(0), OP_SUBTRACT_FIX, OP_SUBTRACT_NUM);
+    CASE(OP_SUBTRACT_ANY) :
+      ARITHMETIC_OP(mesche_number_subtract);
+      NEXT();
+    CASE(OP_MULTIPLY) :
+      QUICKEN(PEEK(1), PEEK(0), OP_MULTIPLY_FIX, OP_MULTIPLY_NUM);
+    CASE(OP_MULTIPLY_ANY) :
+      ARITHMETIC_OP(mesche_number_multiply);
+      NEXT();
+    CASE(OP_DIVIDE) :
+      QUICKEN(PEEK(1), PEEK(0), OP_DIVIDE, OP_DIVIDE_NUM);
+    CASE(OP_DIVIDE_ANY) :
+      ARITHMETIC_OP(mesche_number_divide);
+      NEXT();
+    CASE(OP_MODULO) : {
+      if (!IS_NUMBER(PEEK(0)) || !IS_NUMBER(PEEK(1))) {
+        RUNTIME_ERROR("Operands must be numbers.");
       }
-      int b = (int)AS_NUMBER(mesche_vm_stack_pop(vm));
-      int a = (int)AS_NUMBER(mesche_vm_stack_pop(vm));
-      mesche_vm_stack_push(vm, NUMBER_VAL(a % b));
-      break;
+      Value b = POP();
+      Value a = PEEK(0);
+      if (IS_FIXNUM(a) && IS_FIXNUM(b)) {
+        if (AS_FIXNUM(b) == 0) {
+          RUNTIME_ERROR("Division by zero.");
+        }
+        sp[-1] = FIXNUM_VAL(AS_FIXNUM(a) % AS_FIXNUM(b));
+      } else {
+        sp[-1] = NUMBER_VAL(fmod(AS_NUMBER(a), AS_NUMBER(b)));
+      }
+      NEXT();
     }
-    case OP_NOT:
-      mesche_vm_stack_push(vm, IS_FALSE(mesche_vm_stack_pop(vm)) ? TRUE_VAL : FALSE_VAL);
-      break;
-    case OP_GREATER_THAN:
-      BINARY_OP(BOOL_VAL, IS_NUMBER, AS_NUMBER, >);
-      break;
-    case OP_GREATER_EQUAL:
-      BINARY_OP(BOOL_VAL, IS_NUMBER, AS_NUMBER, >=);
-      break;
-    case OP_LESS_THAN:
-      BINARY_OP(BOOL_VAL, IS_NUMBER, AS_NUMBER, <);
-      break;
-    case OP_LESS_EQUAL:
-      BINARY_OP(BOOL_VAL, IS_NUMBER, AS_NUMBER, <=);
-      break;
-    case OP_EQUAL:
-      // Drop through for now
-    case OP_EQV: {
-      Value b = mesche_vm_stack_pop(vm);
-      Value a = mesche_vm_stack_pop(vm);
-      mesche_vm_stack_push(vm, BOOL_VAL(mesche_value_eqv_p(a, b)));
-      break;
+    CASE(OP_NOT) :
+      sp[-1] = IS_FALSE(PEEK(0)) ? TRUE_VAL : FALSE_VAL;
+      NEXT();
+    CASE(OP_GREATER_THAN) :
+      QUICKEN(PEEK(1), PEEK(0), OP_GREATER_THAN_FIX, OP_GREATER_THAN_NUM);
+    CASE(OP_GREATER_THAN_ANY) :
+      COMPARE_OP(>);
+      NEXT();
+    CASE(OP_GREATER_EQUAL) :
+      QUICKEN(PEEK(1), PEEK(0), OP_GREATER_EQUAL_FIX, OP_GREATER_EQUAL_NUM);
+    CASE(OP_GREATER_EQUAL_ANY) :
+      COMPARE_OP(>=);
+      NEXT();
+    CASE(OP_LESS_THAN) :
+      QUICKEN(PEEK(1), PEEK(0), OP_LESS_THAN_FIX, OP_LESS_THAN_NUM);
+    CASE(OP_LESS_THAN_ANY) :
+      COMPARE_OP(<);
+      NEXT();
+    CASE(OP_LESS_EQUAL) :
+      QUICKEN(PEEK(1), PEEK(0), OP_LESS_EQUAL_FIX, OP_LESS_EQUAL_NUM);
+    CASE(OP_LESS_EQUAL_ANY) :
+      COMPARE_OP(<=);
+      NEXT();
+    CASE(OP_EQUAL) :
+      QUICKEN(PEEK(1), PEEK(0), OP_EQUAL_FIX, OP_EQUAL_NUM);
+    CASE(OP_EQUAL_ANY) : {
+      Value b = POP();
+      Value a = PEEK(0);
+      sp[-1] = BOOL_VAL(mesche_value_equal_p(a, b));
+      NEXT();
     }
-    case OP_JUMP: {
+    CASE(OP_EQV) :
+      QUICKEN(PEEK(1), PEEK(0), OP_EQV_FIX, OP_EQV_NUM);
+    CASE(OP_EQV_ANY) : {
+      Value b = POP();
+      Value a = PEEK(0);
+      sp[-1] = BOOL_VAL(mesche_value_eqv_p(a, b));
+      NEXT();
+    }
+    CASE(OP_ADD_NUM) :
+      FLONUM_OP(NUMBER_VAL, +, OP_ADD_ANY);
+      NEXT();
+    CASE(OP_SUBTRACT_NUM) :
+      FLONUM_OP(NUMBER_VAL, -, OP_SUBTRACT_ANY);
+      NEXT();
+    CASE(OP_MULTIPLY_NUM) :
+      FLONUM_OP(NUMBER_VAL, *, OP_MULTIPLY_ANY);
+      NEXT();
+    CASE(OP_DIVIDE_NUM) :
+      FLONUM_OP(NUMBER_VAL, /, OP_DIVIDE_ANY);
+      NEXT();
+    CASE(OP_GREATER_THAN_NUM) :
+      FLONUM_OP(BOOL_VAL, >, OP_GREATER_THAN_ANY);
+      NEXT();
+    CASE(OP_GREATER_EQUAL_NUM) :
+      FLONUM_OP(BOOL_VAL, >=, OP_GREATER_EQUAL_ANY);
+      NEXT();
+    CASE(OP_LESS_THAN_NUM) :
+      FLONUM_OP(BOOL_VAL, <, OP_LESS_THAN_ANY);
+      NEXT();
+    CASE(OP_LESS_EQUAL_NUM) :
+      FLONUM_OP(BOOL_VAL, <=, OP_LESS_EQUAL_ANY);
+      NEXT();
+    CASE(OP_EQV_NUM) :
+      FLONUM_OP(BOOL_VAL, ==, OP_EQV_ANY);
+      NEXT();
+    CASE(OP_EQUAL_NUM) :
+      FLONUM_OP(BOOL_VAL, ==, OP_EQUAL_ANY);
+      NEXT();
+    CASE(OP_ADD_FIX) :
+      FIXNUM_ARITHMETIC_OP(__builtin_add_overflow, OP_ADD_ANY);
+      NEXT();
+    CASE(OP_SUBTRACT_FIX) :
+      FIXNUM_ARITHMETIC_OP(__builtin_sub_overflow, OP_SUBTRACT_ANY);
+      NEXT();
+    CASE(OP_MULTIPLY_FIX) :
+      FIXNUM_ARITHMETIC_OP(__builtin_mul_overflow, OP_MULTIPLY_ANY);
+      NEXT();
+    CASE(OP_GREATER_THAN_FIX) :
+      FIXNUM_COMPARE_OP(>, OP_GREATER_THAN_ANY);
+      NEXT();
+    CASE(OP_GREATER_EQUAL_FIX) :
+      FIXNUM_COMPARE_OP(>=, OP_GREATER_EQUAL_ANY);
+      NEXT();
+    CASE(OP_LESS_THAN_FIX) :
+      FIXNUM_COMPARE_OP(<, OP_LESS_THAN_ANY);
+      NEXT();
+    CASE(OP_LESS_EQUAL_FIX) :
+      FIXNUM_COMPARE_OP(<=, OP_LESS_EQUAL_ANY);
+      NEXT();
+    CASE(OP_EQV_FIX) :
+      FIXNUM_COMPARE_OP(==, OP_EQV_ANY);
+      NEXT();
+    CASE(OP_EQUAL_FIX) :
+      FIXNUM_COMPARE_OP(==, OP_EQUAL_ANY);
+      NEXT();
+    CASE(OP_JUMP) : {
       uint16_t offset = READ_SHORT();
-      frame->ip += offset;
-      break;
+      ip += offset;
+      NEXT();
     }
-    case OP_JUMP_IF_FALSE: {
+    CASE(OP_JUMP_IF_FALSE) : {
       uint16_t offset = READ_SHORT();
-      if (IS_FALSEY(vm_stack_peek(vm, 0))) {
-        frame->ip += offset;
+      if (IS_FALSEY(PEEK(0))) {
+        ip += offset;
       }
-      break;
+      NEXT();
     }
-    case OP_RESET: {
+    CASE(OP_RESET) : {
+      SYNC_STATE();
+
       // Store the previous reset marker, if any, on the value stack
       mesche_vm_stack_push(vm, OBJECT_VAL(vm->current_reset_marker));
 
@@ -897,9 +1629,12 @@ InterpretResult mesche_vm_run(VM *vm) {
       vm->current_reset_marker =
           mesche_object_make_stack_marker(vm, STACK_MARKER_RESET, vm->frame_count - 1);
 
-      break;
+      LOAD_STATE();
+      NEXT();
     }
-    case OP_SHIFT: {
+    CASE(OP_SHIFT) : {
+      SYNC_STATE();
+
       // Find the most recent reset marker
       // TODO: Add support for shift markers for optimizations?
       ObjectStackMarker *reset_marker = vm->current_reset_marker;
@@ -964,9 +1699,14 @@ InterpretResult mesche_vm_run(VM *vm) {
       mesche_vm_stack_pop(vm);
       mesche_vm_stack_push(vm, OBJECT_VAL(closure));
 
-      break;
+      // Execution continues in the shifted frame so that the OP_CALL after
+      // OP_SHIFT invokes the shift body, only the stack top needs reloading
+      sp = vm->stack_top;
+      NEXT();
     }
-    case OP_REIFY: {
+    CASE(OP_REIFY) : {
+      SYNC_STATE();
+
       // Pull the continuation off the top of the stack and find the continuation
       // parameter so that it can be pushed back onto the stack later
       ObjectContinuation *continuation = AS_CONTINUATION(mesche_vm_stack_pop(vm));
@@ -978,6 +1718,23 @@ InterpretResult mesche_vm_run(VM *vm) {
       mesche_vm_stack_push(vm, param);
       mesche_vm_stack_push(vm, marker);
 
+      // Make room for the reified frames and values.  Each reified frame can
+      // push at most as many values as it has code before it calls again.
+      int needed_values = continuation->stack_count + STACK_HEADROOM;
+      for (int i = 0; i < continuation->frame_count; i++) {
+        needed_values += continuation->frames[i].closure->function->chunk.count;
+      }
+
+      if (!vm_frames_reserve(vm, continuation->frame_count)) {
+        mesche_vm_raise_error(vm, "Call stack overflow, exceeded maximum depth of %d frames.",
+                              vm->frame_max);
+        return INTERPRET_RUNTIME_ERROR;
+      } else if (!vm_stack_reserve(vm, needed_values)) {
+        mesche_vm_raise_error(vm, "Value stack overflow, exceeded maximum size of %d values.",
+                              vm->stack_max);
+        return INTERPRET_RUNTIME_ERROR;
+      }
+
       // Reify the call stack on top of the current context, including the
       // continuation function itself.  This helps preserve the proper reset
       // context when the reified continuation frames fully return.
@@ -989,25 +1746,21 @@ InterpretResult mesche_vm_run(VM *vm) {
       // Move the instruction pointer of the topmost call frame ahead to skip
       // the OP_CALL instruction after OP_SHIFT.  Why doesn't the OP_CALL move
       // past this on its own?
-      vm->frames[vm->frame_count - 1].ip += 3;
+      vm->frames[vm->frame_count - 1].ip += 5;
+
+      // The slot pointers of the captured frames point into the continuation's
+      // copy of the value stack, move them to where those values get appended
+      // on top of the current stack
+      Value *stack_base = vm->stack_top;
+      for (int i = 0; i < continuation->frame_count; i++) {
+        CallFrame *reified_frame = &vm->frames[target_frame_index + i];
+        reified_frame->slots = stack_base + (reified_frame->slots - continuation->stack);
+      }
 
       // Append the reified value stack to the stack top
       if (continuation->stack_count > 0) {
-        // Calculate the stack offset before we mess with the top pointer
-        int stack_offset = vm->stack_top - continuation->frames[0].slots;
-
-        // Copy the continuation values and move the top pointer
         memcpy(vm->stack_top, continuation->stack, sizeof(Value) * continuation->stack_count);
         vm->stack_top += continuation->stack_count;
-
-        // Adjust the slot start pointer of each of the reified frames to ensure
-        // that they look for values in the right locations.  Since we're adding
-        // the frames to the top of the stack, calculate the offset based on how
-        // many values have been added since the first frame was called last.
-        for (int i = 0; i < continuation->frame_count; i++) {
-          Value *old_value = vm->frames[target_frame_index + i].slots;
-          vm->frames[target_frame_index + i].slots += stack_offset;
-        }
       }
 
       // Push the continuation parameter back on the stack again before continuing
@@ -1015,13 +1768,13 @@ InterpretResult mesche_vm_run(VM *vm) {
       mesche_vm_stack_push(vm, param);
 
       // Update the active frame for the next cycle
-      frame = &vm->frames[vm->frame_count - 1];
-
-      break;
+      LOAD_STATE();
+      NEXT();
     }
-    case OP_RETURN:
+    CASE(OP_RETURN) : {
       // Hold on to the function result value before we manipulate the stack
-      value = mesche_vm_stack_pop(vm);
+      Value result = POP();
+      SYNC_STATE();
 
       // Close out upvalues for any function locals that have been captured by
       // closures
@@ -1037,13 +1790,14 @@ InterpretResult mesche_vm_run(VM *vm) {
         // The VM is no longer executing if we've exhausted the call frames
         if (vm->frame_count == 0) {
           vm->is_running = false;
+          vm_release_retired_stacks(vm);
         }
 
         // Pop the entry function off of the stack
         mesche_vm_stack_pop(vm);
 
         // Push the return value back on so that it can be read by the REPL
-        mesche_vm_stack_push(vm, value);
+        mesche_vm_stack_push(vm, result);
 
         return INTERPRET_OK;
       }
@@ -1064,10 +1818,13 @@ InterpretResult mesche_vm_run(VM *vm) {
         vm->current_reset_marker = AS_STACK_MARKER(mesche_vm_stack_pop(vm));
       }
 
-      mesche_vm_stack_push(vm, value);
-      frame = &vm->frames[vm->frame_count - 1];
-      break;
-    case OP_BREAK:
+      mesche_vm_stack_push(vm, result);
+      LOAD_STATE();
+      NEXT();
+    }
+    CASE(OP_BREAK) :
+      SYNC_STATE();
+
       // Print out diagnostics and end execution
       PRINT_VALUE_STACK();
 
@@ -1089,12 +1846,13 @@ InterpretResult mesche_vm_run(VM *vm) {
 
       mesche_vm_raise_error(vm, "Exiting due to `break`.");
       return INTERPRET_RUNTIME_ERROR;
-    case OP_DISPLAY:
-      // Peek at the value on the stack
-      mesche_value_print(vm->output_port, mesche_vm_stack_pop(vm));
-      mesche_vm_stack_push(vm, UNSPECIFIED_VAL);
-      break;
-    case OP_LOAD_FILE: {
+    CASE(OP_DISPLAY) :
+      SYNC_STATE();
+      mesche_value_print(vm->output_port, PEEK(0));
+      sp[-1] = UNSPECIFIED_VAL;
+      NEXT();
+    CASE(OP_LOAD_FILE) : {
+      SYNC_STATE();
       ObjectString *path = AS_STRING(vm_stack_peek(vm, 0));
       mesche_vm_load_file(vm, path->chars);
 
@@ -1104,8 +1862,7 @@ InterpretResult mesche_vm_run(VM *vm) {
         ObjectClosure *closure = AS_CLOSURE(vm_stack_peek(vm, 0));
         if (closure->function->type == TYPE_SCRIPT) {
           // Call the script
-          vm_call(vm, closure, 0, 0, false);
-          frame = &vm->frames[vm->frame_count - 1];
+          vm_call(vm, closure, NULL, 0, 0, false);
         }
       }
 
@@ -1115,11 +1872,13 @@ InterpretResult mesche_vm_run(VM *vm) {
       mesche_vm_stack_pop(vm);
       mesche_vm_stack_push(vm, closure);
 
-      break;
+      LOAD_STATE();
+      NEXT();
     }
-    case OP_DEFINE_RECORD: {
+    CASE(OP_DEFINE_RECORD) : {
       // Skip all the fields to find the name
       uint8_t field_count = READ_BYTE();
+      SYNC_STATE();
 
       // Duplicate the record type name's symbol as a string
       ObjectSymbol *name_symbol = AS_SYMBOL(vm_stack_peek(vm, field_count * 2));
@@ -1163,10 +1922,10 @@ InterpretResult mesche_vm_run(VM *vm) {
         // Build the record field from name and default value
         int stack_pos = ((field_count - i) * 2) - 1;
         ObjectSymbol *name = AS_SYMBOL(vm_stack_peek(vm, stack_pos));
-        Value value = vm_stack_peek(vm, stack_pos + 1);
+        Value value = vm_stack_peek(vm, stack_pos - 1);
         ObjectRecordField *field = mesche_object_make_record_field(vm, name->name, value);
         mesche_vm_stack_push(vm, OBJECT_VAL(field));
-        mesche_value_array_write((MescheMemory *)vm, &record->fields, OBJECT_VAL(field));
+        mesche_record_field_add(vm, record, field);
         mesche_vm_stack_pop(vm);
 
         // Create a binding for the field accessor "function"
@@ -1210,9 +1969,12 @@ InterpretResult mesche_vm_run(VM *vm) {
       // Push the record type onto the stack as the result
       mesche_vm_stack_push(vm, OBJECT_VAL(record));
 
-      break;
+      LOAD_STATE();
+      NEXT();
     }
-    case OP_DEFINE_MODULE: {
+    CASE(OP_DEFINE_MODULE) : {
+      SYNC_STATE();
+
       // Resolve the module and set the current closure's module.
       // This works because scripts are compiled into functions with
       // their own closure, so a `define-module` will cause that to
@@ -1225,9 +1987,13 @@ InterpretResult mesche_vm_run(VM *vm) {
 
       // Push the defined module onto the stack
       mesche_vm_stack_push(vm, OBJECT_VAL(frame->closure->module));
-      break;
+
+      LOAD_STATE();
+      NEXT();
     }
-    case OP_IMPORT_MODULE: {
+    CASE(OP_IMPORT_MODULE) : {
+      SYNC_STATE();
+
       // Resolve the module based on the given path
       ObjectString *module_name = AS_STRING(vm_stack_peek(vm, 0));
       ObjectModule *resolved_module = mesche_module_resolve_by_name(vm, module_name, true);
@@ -1241,96 +2007,198 @@ InterpretResult mesche_vm_run(VM *vm) {
       // Push the resolved module to the stack
       mesche_vm_stack_push(vm, OBJECT_VAL(resolved_module));
 
-      break;
+      LOAD_STATE();
+      NEXT();
     }
-    case OP_ENTER_MODULE: {
+    CASE(OP_ENTER_MODULE) : {
+      SYNC_STATE();
       ObjectString *module_name = AS_STRING(mesche_vm_stack_pop(vm));
       ObjectModule *module = mesche_module_resolve_by_name(vm, module_name, true);
       // TODO: This might cause unexpected behavior!
       frame->closure->module = module;
+      mesche_gc_write_barrier(vm, (Object *)frame->closure);
       vm->current_module = module;
       mesche_vm_stack_push(vm, OBJECT_VAL(module));
-      break;
+      LOAD_STATE();
+      NEXT();
     }
-    case OP_EXPORT_SYMBOL:
-      name = READ_STRING();
+    CASE(OP_EXPORT_SYMBOL) : {
+      ObjectString *name = READ_STRING();
+      SYNC_STATE();
       // TODO: Convert the local value for this binding to an ObjectExport
       mesche_value_array_write((MescheMemory *)vm, &CURRENT_MODULE()->exports, OBJECT_VAL(name));
-      break;
-    case OP_DEFINE_GLOBAL:
-      name = READ_STRING();
-      mesche_table_set((MescheMemory *)vm, &CURRENT_MODULE()->locals, name, vm_stack_peek(vm, 0));
-      break;
-    case OP_READ_GLOBAL:
-      name = READ_STRING();
-
-      // First, try to loop up the variable in the current module's locals
-      if (!mesche_table_get(&CURRENT_MODULE()->locals, name, &value)) {
-        // Then, look up the variable in the core module's locals if it's loaded
-        // by this point
-        if (vm->core_module) {
-          if (!mesche_table_get(&vm->core_module->locals, name, &value)) {
-            mesche_vm_raise_error(vm, "Undefined variable '%s'.", name->chars);
-            return INTERPRET_RUNTIME_ERROR;
-          }
+      mesche_gc_write_barrier(vm, (Object *)CURRENT_MODULE());
+      LOAD_STATE();
+      NEXT();
+    }
+    CASE(OP_DEFINE_GLOBAL) : {
+      ObjectString *name = READ_STRING();
+      SYNC_STATE();
+      mesche_module_binding_define(vm, CURRENT_MODULE(), name, vm_stack_peek(vm, 0));
+      LOAD_STATE();
+      NEXT();
+    }
+    CASE(OP_READ_GLOBAL) : {
+      uint8_t constant = READ_BYTE();
+      GlobalCache *cache = &global_caches[constant];
+      ObjectModule *module = CURRENT_MODULE();
+
+      // Resolve the binding again if the cached slot might be stale.  The
+      // variable is looked up in the current module first, then in the core
+      // module if it's loaded by this point.
+      if (cache->module != module || cache->epoch != vm->binding_epoch) {
+        ObjectString *name = AS_STRING(constants[constant]);
+        if (!vm_global_resolve(vm, cache, module, name, true)) {
+          RUNTIME_ERROR("Undefined variable '%s'.", name->chars);
         }
       }
 
-      mesche_vm_stack_push(vm, value);
-      break;
-    case OP_READ_UPVALUE:
-      slot = READ_BYTE();
-      mesche_vm_stack_push(vm, *frame->closure->upvalues[slot]->location);
-      break;
-    case OP_READ_LOCAL:
-      slot = READ_BYTE();
-      mesche_vm_stack_push(vm, frame->slots[slot]);
-      break;
-    case OP_SET_GLOBAL: {
-      name = READ_STRING();
-      Table *globals = &CURRENT_MODULE()->locals;
-      if (mesche_table_set((MescheMemory *)vm, globals, name, vm_stack_peek(vm, 0))) {
-        mesche_vm_raise_error(vm, "Undefined variable '%s'.", name->chars);
-        return INTERPRET_RUNTIME_ERROR;
+      PUSH(cache->owner->bindings.values[cache->slot]);
+      NEXT();
+    }
+    CASE(OP_READ_UPVALUE) : {
+      uint8_t slot = READ_BYTE();
+      PUSH(*frame->closure->upvalues[slot]->location);
+      NEXT();
+    }
+    CASE(OP_READ_LOCAL) : {
+      uint8_t slot = READ_BYTE();
+      PUSH(frame->slots[slot]);
+      NEXT();
+    }
+    CASE(OP_READ_LOCAL_LOCAL) : {
+      // OP_READ_LOCAL a, OP_READ_LOCAL b
+      Value a = frame->slots[ip[0]];
+      Value b = frame->slots[ip[2]];
+      ip += 3;
+      PUSH(a);
+      PUSH(b);
+      NEXT();
+    }
+    CASE(OP_READ_LOCAL_CONSTANT) : {
+      // OP_READ_LOCAL a, OP_CONSTANT b
+      Value a = frame->slots[ip[0]];
+      Value b = constants[ip[2]];
+      ip += 3;
+      PUSH(a);
+      PUSH(b);
+      NEXT();
+    }
+    CASE(OP_LOCAL_CONSTANT_ADD) :
+      LOCAL_CONSTANT_OP(mesche_number_add);
+      NEXT();
+    CASE(OP_LOCAL_CONSTANT_SUBTRACT) :
+      LOCAL_CONSTANT_OP(mesche_number_subtract);
+      NEXT();
+    CASE(OP_LESS_THAN_JUMP_IF_FALSE) :
+      COMPARE_JUMP_IF_FALSE(<);
+      NEXT();
+    CASE(OP_LESS_EQUAL_JUMP_IF_FALSE) :
+      COMPARE_JUMP_IF_FALSE(<=);
+      NEXT();
+    CASE(OP_GREATER_THAN_JUMP_IF_FALSE) :
+      COMPARE_JUMP_IF_FALSE(>);
+      NEXT();
+    CASE(OP_GREATER_EQUAL_JUMP_IF_FALSE) :
+      COMPARE_JUMP_IF_FALSE(>=);
+      NEXT();
+    CASE(OP_SET_GLOBAL) : {
+      uint8_t constant = READ_BYTE();
+      GlobalCache *cache = &global_caches[constant];
+      ObjectModule *module = CURRENT_MODULE();
+
+      // Only bindings of the current module can be set
+      if (cache->module != module || cache->owner != module || cache->epoch != vm->binding_epoch) {
+        ObjectString *name = AS_STRING(constants[constant]);
+        if (!vm_global_resolve(vm, cache, module, name, false)) {
+          RUNTIME_ERROR("Undefined variable '%s'.", name->chars);
+        }
       }
-      break;
+
+      module->bindings.values[cache->slot] = PEEK(0);
+      mesche_gc_write_barrier(vm, (Object *)module);
+      NEXT();
     }
-    case OP_SET_UPVALUE:
-      slot = READ_BYTE();
-      *frame->closure->upvalues[slot]->location = vm_stack_peek(vm, 0);
-      break;
-    case OP_SET_LOCAL:
-      slot = READ_BYTE();
-      frame->slots[slot] = vm_stack_peek(vm, 0);
-      break;
-    case OP_CALL: {
+    CASE(OP_SET_UPVALUE) : {
+      uint8_t slot = READ_BYTE();
+      ObjectUpvalue *upvalue = frame->closure->upvalues[slot];
+      *upvalue->location = PEEK(0);
+      mesche_gc_write_barrier(vm, (Object *)upvalue);
+      NEXT();
+    }
+    CASE(OP_SET_LOCAL) : {
+      uint8_t slot = READ_BYTE();
+      frame->slots[slot] = PEEK(0);
+      NEXT();
+    }
+    CASE(OP_CALL) : {
       // Call the function with the specified number of arguments
       uint8_t arg_count = READ_BYTE();
       uint8_t keyword_count = READ_BYTE();
-      if (!vm_call_value(vm, vm_stack_peek(vm, arg_count + (keyword_count * 2)), arg_count,
-                         keyword_count, false)) {
+      CallCache *cache = &frame->closure->function->chunk.call_caches[READ_SHORT()];
+      SYNC_STATE();
+      if (!vm_call_site(vm, cache, ip - 5, arg_count, keyword_count, false)) {
         return INTERPRET_RUNTIME_ERROR;
       }
 
       // Set the current frame to the new call frame
-      frame = &vm->frames[vm->frame_count - 1];
-      break;
+      LOAD_STATE();
+      NEXT();
     }
-    case OP_TAIL_CALL: {
+    CASE(OP_TAIL_CALL) : {
       // Call the function with the specified number of arguments
       uint8_t arg_count = READ_BYTE();
       uint8_t keyword_count = READ_BYTE();
-      if (!vm_call_value(vm, vm_stack_peek(vm, arg_count + (keyword_count * 2)), arg_count,
-                         keyword_count, true)) {
+      CallCache *cache = &frame->closure->function->chunk.call_caches[READ_SHORT()];
+      SYNC_STATE();
+      if (!vm_call_site(vm, cache, ip - 5, arg_count, keyword_count, true)) {
         return INTERPRET_RUNTIME_ERROR;
       }
 
       // Retain the current call frame, it has already been updated
-      frame = &vm->frames[vm->frame_count - 1];
-      break;
+      LOAD_STATE();
+      NEXT();
+    }
+    CASE(OP_RECORD_REF) :
+    CASE(OP_TAIL_RECORD_REF) : {
+      // The operands are the same as OP_CALL's, only the cache index is needed
+      CallCache *cache = &frame->closure->function->chunk.call_caches[(ip[2] << 8) | ip[3]];
+      ObjectRecordFieldAccessor *accessor = (ObjectRecordFieldAccessor *)cache->callees[0];
+      Value instance = sp[-1];
+      if (IS_OBJECT(sp[-2]) && AS_OBJECT(sp[-2]) == (Object *)accessor &&
+          IS_RECORD_INSTANCE(instance) &&
+          AS_RECORD_INSTANCE(instance)->record_type == accessor->record_type) {
+        sp--;
+        sp[-1] = AS_RECORD_INSTANCE(instance)->field_values[accessor->field_index];
+        ip += 4;
+      } else {
+        // Let the generic call report errors or handle the new callee
+        DEOPTIMIZE(ip[-1] == OP_RECORD_REF ? OP_CALL : OP_TAIL_CALL);
+      }
+      NEXT();
+    }
+    CASE(OP_RECORD_SET) :
+    CASE(OP_TAIL_RECORD_SET) : {
+      CallCache *cache = &frame->closure->function->chunk.call_caches[(ip[2] << 8) | ip[3]];
+      ObjectRecordFieldSetter *setter = (ObjectRecordFieldSetter *)cache->callees[0];
+      Value instance = sp[-2];
+      if (IS_OBJECT(sp[-3]) && AS_OBJECT(sp[-3]) == (Object *)setter &&
+          IS_RECORD_INSTANCE(instance) &&
+          AS_RECORD_INSTANCE(instance)->record_type == setter->record_type) {
+        // Set the field's value and return that same value
+        AS_RECORD_INSTANCE(instance)->field_values[setter->field_index] = sp[-1];
+        mesche_gc_write_barrier(vm, AS_OBJECT(instance));
+        sp[-3] = sp[-1];
+        sp -= 2;
+        ip += 4;
+      } else {
+        DEOPTIMIZE(ip[-1] == OP_RECORD_SET ? OP_CALL : OP_TAIL_CALL);
+      }
+      NEXT();
     }
-    case OP_CLOSURE: {
+    CASE(OP_CLOSURE) : {
       ObjectFunction *function = AS_FUNCTION(READ_CONSTANT());
+      SYNC_STATE();
       ObjectClosure *closure = mesche_object_make_closure(vm, function, CURRENT_MODULE());
       mesche_vm_stack_push(vm, OBJECT_VAL(closure));
 
@@ -1347,69 +2215,91 @@ InterpretResult mesche_vm_run(VM *vm) {
         }
       }
 
-      break;
+      // Capturing upvalues can collect garbage while the closure is on the stack
+      mesche_gc_write_barrier(vm, (Object *)closure);
+
+      // The upvalue operands were read through the cached pointer
+      sp = vm->stack_top;
+      NEXT();
     }
-    case OP_CLOSE_UPVALUE: {
+    CASE(OP_CLOSE_UPVALUE) : {
+      SYNC_STATE();
+
       // NOTE: This opcode gets issued when a scope block is ending (usually
       // from a `let` or `begin` expression with multiple body expressions)
       // so skip the topmost value on the stack (the last expression result)
       // and grab the next value which should be the first local.
-      vm_close_upvalues(vm, vm->stack_top - 2);
+      vm_close_upvalues(vm, sp - 2);
 
       // Move the result value into the local's spot
-      Value result = mesche_vm_stack_pop(vm);
-      mesche_vm_stack_pop(vm);
-      mesche_vm_stack_push(vm, result);
+      Value result = POP();
+      sp[-1] = result;
 
-      break;
+      NEXT();
     }
-    case OP_APPLY: {
-      // Grab the function to call and the list to call it on
+    CASE(OP_APPLY) :
+    CASE(OP_TAIL_APPLY) : {
+      bool is_tail_call = ip[-1] == OP_TAIL_APPLY;
+      SYNC_STATE();
+
+      // Grab the function to call and the list or array to call it on
       Value func_value = vm_stack_peek(vm, 1);
-      Value list_value = vm_stack_peek(vm, 0);
+      Value args_value = vm_stack_peek(vm, 0);
 
       // Are they the expected types?
       if (!IS_CLOSURE(func_value) && !IS_NATIVE_FUNC(func_value)) {
         mesche_vm_raise_error(vm, "Cannot apply non-function value.");
         return INTERPRET_RUNTIME_ERROR;
-      } else if (!IS_CONS(list_value) && !IS_EMPTY(list_value)) {
+      } else if (!IS_CONS(args_value) && !IS_EMPTY(args_value) && !IS_ARRAY(args_value)) {
         mesche_vm_raise_error(vm, "Cannot apply function to non-list value.");
         return INTERPRET_RUNTIME_ERROR;
       }
 
-      // Store the list value location so that we can overwrite it after
-      // unrolling the values.  We do this to ensure the list doesn't get freed
-      // during a GC pass that might occur while pushing the individual values
-      // to the stack.
       int arg_count = 0;
-      Value *list_value_slot = vm->stack_top - 1;
-
-      // Unroll the list onto the stack
-      while (IS_CONS(list_value)) {
-        ObjectCons *cons = AS_CONS(list_value);
-        mesche_vm_stack_push(vm, cons->car);
-        arg_count++;
-        list_value = cons->cdr;
+      if (IS_ARRAY(args_value)) {
+        arg_count = AS_ARRAY(args_value)->objects.count;
+      } else {
+        for (Value rest = args_value; IS_CONS(rest); rest = AS_CONS(rest)->cdr) {
+          arg_count++;
+        }
+      }
+
+      if (!vm_stack_reserve(vm, arg_count)) {
+        mesche_vm_raise_error(vm, "Value stack overflow, exceeded maximum size of %d values.",
+                              vm->stack_max);
+        return INTERPRET_RUNTIME_ERROR;
       }
 
-      // Remove the original list value by shifting all new values down by 1
-      memmove(list_value_slot, list_value_slot + 1, sizeof(Value) * arg_count);
-      vm->stack_top--;
+      // Unroll the values over the slot that holds the list or array.  Nothing
+      // is allocated here so the arguments can't be collected in the meantime.
+      Value *arg_slot = vm->stack_top - 1;
+      if (IS_ARRAY(args_value)) {
+        memcpy(arg_slot, AS_ARRAY(args_value)->objects.values, sizeof(Value) * arg_count);
+      } else {
+        for (Value rest = args_value; IS_CONS(rest); rest = AS_CONS(rest)->cdr) {
+          *arg_slot++ = AS_CONS(rest)->car;
+        }
+      }
+
+      vm->stack_top += arg_count - 1;
 
       // Call the function with the unrolled argument list
-      // TODO: Can we make this a tail call?
-      if (!vm_call_value(vm, func_value, arg_count, 0, false)) {
+      if (!vm_call_value(vm, func_value, NULL, arg_count, 0, is_tail_call)) {
         return INTERPRET_RUNTIME_ERROR;
       }
 
       // Set the current frame to the new call frame
-      frame = &vm->frames[vm->frame_count - 1];
-
-      break;
+      LOAD_STATE();
+      NEXT();
     }
+    UNKNOWN_OPCODE() :
+      // Unused opcodes are skipped
+      NEXT();
+#ifndef VM_COMPUTED_GOTO
     }
 
 #ifdef DEBUG_TRACE_EXECUTION
+    SYNC_STATE();
     if (TRACE_THIS) {
       printf("Value Stack After:\n");
       for (Value *slot = vm->stack; slot < vm->stack_top; slot++) {
@@ -1433,14 +2323,33 @@ InterpretResult mesche_vm_run(VM *vm) {
     }
 #endif
   }
+#endif
 
   vm->is_running = false;
 
+#undef SYNC_STATE
+#undef LOAD_STATE
 #undef READ_STRING
 #undef READ_SHORT
 #undef READ_BYTE
 #undef READ_CONSTANT
-#undef BINARY_OP
+#undef PUSH
+#undef POP
+#undef PEEK
+#undef RUNTIME_ERROR
+#undef LOCAL_CONSTANT_OP
+#undef COMPARE_JUMP_IF_FALSE
+#undef QUICKEN
+#undef ARITHMETIC_OP
+#undef COMPARE_OP
+#undef DEOPTIMIZE
+#undef FLONUM_OP
+#undef FIXNUM_ARITHMETIC_OP
+#undef FIXNUM_COMPARE_OP
+#undef DISPATCH
+#undef CASE
+#undef NEXT
+#undef UNKNOWN_OPCODE
 }
 
 static Value mesche_vm_clock_native(int arg_count, Value *args) {
@@ -1517,7 +2426,10 @@ InterpretResult mesche_vm_call_closure(VM *vm, ObjectClosure *closure, int arg_c
 
   // Call the initial closure and run the VM.  If the VM is already running,
   // `mesche_vm_run` will consider it a sub-prompt.
-  vm_call(vm, closure, arg_count, 0, false);
+  if (!vm_call(vm, closure, NULL, arg_count, 0, false)) {
+    return INTERPRET_RUNTIME_ERROR;
+  }
+
   return mesche_vm_run(vm);
 }
 
@@ -1566,13 +2478,16 @@ static InterpretResult vm_eval_internal(VM *vm, const char *script_string, const
   // Only run the VM if it isn't already running
   if (!vm->is_running) {
     // Call the initial closure and run the VM
-    vm_call(vm, closure, 0, 0, false);
+    if (!vm_call(vm, closure, NULL, 0, 0, false)) {
+      return INTERPRET_RUNTIME_ERROR;
+    }
+
     return mesche_vm_run(vm);
   }
 }
 
 InterpretResult mesche_vm_eval_string(VM *vm, const char *script_string) {
-  vm_eval_internal(vm, script_string, NULL);
+  return vm_eval_internal(vm, script_string, NULL);
 }
 
 InterpretResult mesche_vm_load_module(VM *vm, ObjectModule *module, const char *module_path) {
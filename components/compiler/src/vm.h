@@ -21,5 +21,7 @@ InterpretResult mesche_vm_eval_string(VM *vm, const char *script_string);
 InterpretResult mesche_vm_load_file(VM *vm, const char *file_path);
 void mesche_vm_register_core_modules(VM *vm, char *module_path);
 void mesche_vm_load_path_add(VM *vm, const char *load_path);
+bool mesche_vm_arena_begin(VM *vm);
+void mesche_vm_arena_end(VM *vm);
 
 #endif
@@ -0,0 +1,252 @@
+#include <stdint.h>
+
+#include "gc.h"
+#include "native.h"
+#include "util.h"
+#include "weak.h"
+
+#define WEAK_TABLE_MAX_LOAD 0.75
+
+ObjectWeakTable *mesche_object_make_weak_table(VM *vm, WeakTableKind kind) {
+  ObjectWeakTable *table = ALLOC_OBJECT(vm, ObjectWeakTable, ObjectKindWeakTable);
+  table->kind = kind;
+  table->count = 0;
+  table->capacity = 0;
+  table->entries = NULL;
+  table->next_traced = NULL;
+  table->is_traced = false;
+
+  return table;
+}
+
+void mesche_free_weak_table(VM *vm, ObjectWeakTable *table) {
+  FREE_ARRAY((MescheMemory *)vm, WeakEntry, table->entries, table->capacity);
+  FREE_OBJECT(vm, table);
+}
+
+static uint32_t weak_table_hash(Object *key) {
+  // Objects are at least 8 byte aligned so the low bits are always zero
+  uint64_t bits = (uintptr_t)key >> 3;
+  return (uint32_t)((bits ^ (bits >> 32)) * 2654435761u);
+}
+
+// The capacity is always a power of two so that the index can be masked
+static WeakEntry *weak_table_find_entry(WeakEntry *entries, int capacity, Object *key) {
+  WeakEntry *tombstone = NULL;
+  uint32_t index = weak_table_hash(key) & (capacity - 1);
+
+  for (;;) {
+    WeakEntry *entry = &entries[index];
+    if (entry->key == NULL) {
+      if (!IS_TRUE(entry->value)) {
+        return tombstone != NULL ? tombstone : entry;
+      } else if (tombstone == NULL) {
+        tombstone = entry;
+      }
+    } else if (entry->key == key) {
+      return entry;
+    }
+
+    index = (index + 1) & (capacity - 1);
+  }
+}
+
+static void weak_table_adjust_capacity(VM *vm, ObjectWeakTable *table, int capacity) {
+  // Allocating can collect garbage, which removes the entries of dead keys
+  // from the old array before they're copied
+  WeakEntry *entries =
+      mesche_mem_realloc((MescheMemory *)vm, NULL, 0, sizeof(WeakEntry) * capacity);
+  for (int i = 0; i < capacity; i++) {
+    entries[i].key = NULL;
+    entries[i].value = FALSE_VAL;
+  }
+
+  table->count = 0;
+  for (int i = 0; i < table->capacity; i++) {
+    WeakEntry *entry = &table->entries[i];
+    if (entry->key == NULL) {
+      continue;
+    }
+
+    WeakEntry *dest = weak_table_find_entry(entries, capacity, entry->key);
+    dest->key = entry->key;
+    dest->value = entry->value;
+    table->count++;
+  }
+
+  FREE_ARRAY((MescheMemory *)vm, WeakEntry, table->entries, table->capacity);
+  table->entries = entries;
+  table->capacity = capacity;
+}
+
+bool mesche_weak_table_get(ObjectWeakTable *table, Object *key, Value *value) {
+  if (table->count == 0)
+    return false;
+
+  WeakEntry *entry = weak_table_find_entry(table->entries, table->capacity, key);
+  if (entry->key == NULL)
+    return false;
+
+  *value = entry->value;
+  return true;
+}
+
+static int weak_table_live_count(ObjectWeakTable *table) {
+  int count = 0;
+  for (int i = 0; i < table->capacity; i++) {
+    if (table->entries[i].key != NULL) {
+      count++;
+    }
+  }
+
+  return count;
+}
+
+// The key and value must be reachable from the stack since growing the table
+// can collect garbage
+bool mesche_weak_table_set(VM *vm, ObjectWeakTable *table, Object *key, Value value) {
+  if (table->count + 1 > table->capacity * WEAK_TABLE_MAX_LOAD) {
+    // Removed entries count toward the load until the table is rebuilt.  A
+    // cache whose keys keep getting collected is rebuilt at the same size
+    // instead of growing forever.
+    int capacity = table->capacity;
+    if (weak_table_live_count(table) + 1 > capacity * WEAK_TABLE_MAX_LOAD / 2) {
+      capacity = GROW_CAPACITY(capacity);
+    }
+
+    weak_table_adjust_capacity(vm, table, capacity);
+  }
+
+  WeakEntry *entry = weak_table_find_entry(table->entries, table->capacity, key);
+  bool is_new_key = entry->key == NULL;
+  if (is_new_key && IS_FALSE(entry->value)) {
+    table->count++;
+  }
+
+  entry->key = key;
+  entry->value = value;
+  mesche_gc_write_barrier(vm, (Object *)table);
+
+  return is_new_key;
+}
+
+bool mesche_weak_table_delete(ObjectWeakTable *table, Object *key) {
+  if (table->count == 0)
+    return false;
+
+  WeakEntry *entry = weak_table_find_entry(table->entries, table->capacity, key);
+  if (entry->key == NULL)
+    return false;
+
+  // Leave a tombstone so that lookups continue past this entry
+  entry->key = NULL;
+  entry->value = TRUE_VAL;
+
+  return true;
+}
+
+static ObjectWeakTable *weak_table_expect(VM *vm, Value value) {
+  if (!IS_WEAK_TABLE(value)) {
+    mesche_vm_raise_error(vm, "Expected a weak table.");
+    return NULL;
+  }
+
+  return AS_WEAK_TABLE(value);
+}
+
+static bool weak_table_expect_key(VM *vm, Value key) {
+  if (!IS_OBJECT(key)) {
+    mesche_vm_raise_error(vm, "Weak table keys must be objects.");
+    return false;
+  }
+
+  return true;
+}
+
+Value weak_table_make_msc(VM *vm, int arg_count, Value *args) {
+  if (arg_count != 0) {
+    PANIC("Function accepts no parameters.");
+  }
+
+  return OBJECT_VAL(mesche_object_make_weak_table(vm, WEAK_TABLE_KEYS));
+}
+
+Value weak_table_make_ephemeron_msc(VM *vm, int arg_count, Value *args) {
+  if (arg_count != 0) {
+    PANIC("Function accepts no parameters.");
+  }
+
+  return OBJECT_VAL(mesche_object_make_weak_table(vm, WEAK_TABLE_EPHEMERONS));
+}
+
+Value weak_table_p_msc(VM *vm, int arg_count, Value *args) {
+  if (arg_count != 1) {
+    PANIC("Function requires 1 parameter.");
+  }
+
+  return BOOL_VAL(IS_WEAK_TABLE(args[0]));
+}
+
+Value weak_table_ref_msc(VM *vm, int arg_count, Value *args) {
+  if (arg_count < 2 || arg_count > 3) {
+    PANIC("Function requires 2 or 3 parameters.");
+  }
+
+  // Returns the default value, or #f, when the key isn't in the table
+  Value value = arg_count == 3 ? args[2] : FALSE_VAL;
+  ObjectWeakTable *table = weak_table_expect(vm, args[0]);
+  if (table != NULL && IS_OBJECT(args[1])) {
+    mesche_weak_table_get(table, AS_OBJECT(args[1]), &value);
+  }
+
+  return value;
+}
+
+Value weak_table_set_msc(VM *vm, int arg_count, Value *args) {
+  if (arg_count != 3) {
+    PANIC("Function requires 3 parameters.");
+  }
+
+  ObjectWeakTable *table = weak_table_expect(vm, args[0]);
+  if (table == NULL || !weak_table_expect_key(vm, args[1])) {
+    return FALSE_VAL;
+  }
+
+  mesche_weak_table_set(vm, table, AS_OBJECT(args[1]), args[2]);
+  return args[2];
+}
+
+Value weak_table_delete_msc(VM *vm, int arg_count, Value *args) {
+  if (arg_count != 2) {
+    PANIC("Function requires 2 parameters.");
+  }
+
+  ObjectWeakTable *table = weak_table_expect(vm, args[0]);
+  if (table == NULL || !IS_OBJECT(args[1])) {
+    return FALSE_VAL;
+  }
+
+  return BOOL_VAL(mesche_weak_table_delete(table, AS_OBJECT(args[1])));
+}
+
+Value weak_table_count_msc(VM *vm, int arg_count, Value *args) {
+  if (arg_count != 1) {
+    PANIC("Function requires 1 parameter.");
+  }
+
+  ObjectWeakTable *table = weak_table_expect(vm, args[0]);
+  return FIXNUM_VAL(table != NULL ? weak_table_live_count(table) : 0);
+}
+
+void mesche_weak_table_module_init(VM *vm) {
+  mesche_vm_define_native_funcs(
+      vm, "mesche core",
+      (MescheNativeFuncDetails[]){{"make-weak-table", weak_table_make_msc, true},
+                                  {"make-ephemeron-table", weak_table_make_ephemeron_msc, true},
+                                  {"weak-table?", weak_table_p_msc, true},
+                                  {"weak-table-ref", weak_table_ref_msc, true},
+                                  {"weak-table-set!", weak_table_set_msc, true},
+                                  {"weak-table-delete!", weak_table_delete_msc, true},
+                                  {"weak-table-count", weak_table_count_msc, true},
+                                  {NULL, NULL, false}});
+}
@@ -0,0 +1,44 @@
+#ifndef mesche_weak_h
+#define mesche_weak_h
+
+#include "object.h"
+#include "vm.h"
+
+// A weak table's keys don't keep their objects alive.  Once a key is
+// collected its entry is removed from the table.  The values of a weak-key
+// table are always kept alive, while the value of an ephemeron is only kept
+// alive as long as its key is, so values that refer back to their own keys
+// don't prevent them from being collected.
+typedef enum { WEAK_TABLE_KEYS, WEAK_TABLE_EPHEMERONS } WeakTableKind;
+
+// Keys are compared by identity.  An empty entry has a NULL key and a value of
+// #f, a removed entry has a NULL key and a value of #t.
+typedef struct WeakEntry {
+  Object *key;
+  Value value;
+} WeakEntry;
+
+typedef struct ObjectWeakTable {
+  struct Object object;
+  WeakTableKind kind;
+  int count;
+  int capacity;
+  WeakEntry *entries;
+
+  // Links the tables that were traced in the current collection so that
+  // their entries can be processed once marking finishes
+  struct ObjectWeakTable *next_traced;
+  bool is_traced;
+} ObjectWeakTable;
+
+#define IS_WEAK_TABLE(value) mesche_object_is_kind(value, ObjectKindWeakTable)
+#define AS_WEAK_TABLE(value) ((ObjectWeakTable *)AS_OBJECT(value))
+
+ObjectWeakTable *mesche_object_make_weak_table(VM *vm, WeakTableKind kind);
+void mesche_free_weak_table(VM *vm, ObjectWeakTable *table);
+bool mesche_weak_table_get(ObjectWeakTable *table, Object *key, Value *value);
+bool mesche_weak_table_set(VM *vm, ObjectWeakTable *table, Object *key, Value value);
+bool mesche_weak_table_delete(ObjectWeakTable *table, Object *key);
+void mesche_weak_table_module_init(VM *vm);
+
+#endif
@@ -70,7 +70,8 @@ static uint16_t jump_val;
 #define CHECK_CALL(instr, arg_count, keyword_count)                                                \
   CHECK_BYTE(instr);                                                                               \
   CHECK_BYTE(arg_count);                                                                           \
-  CHECK_BYTE(keyword_count);
+  CHECK_BYTE(keyword_count);                                                                       \
+  byte_idx += 2;
 
 #define CHECK_STRING(expected_str, const_index)                                                    \
   if (memcmp(AS_CSTRING(out_func->chunk.constants.values[const_index]), expected_str,              \
@@ -152,7 +153,7 @@ static void compiles_lambda() {
   /* CHECK_BYTES(OP_READ_LOCAL, 1); */
   /* CHECK_BYTES(OP_READ_LOCAL, 2); */
   /* CHECK_CALL(OP_TAIL_CALL, 2, 0); */
-  CHECK_BYTES(OP_READ_LOCAL, 1);
+  CHECK_BYTES(OP_READ_LOCAL_LOCAL, 1);
   CHECK_BYTES(OP_READ_LOCAL, 2);
   CHECK_BYTE(OP_ADD);
   CHECK_BYTE(OP_RETURN);
@@ -181,7 +182,7 @@ static void compiles_let() {
   /* CHECK_BYTES(OP_READ_LOCAL, 1); */
   /* CHECK_BYTES(OP_READ_LOCAL, 2); */
   /* CHECK_CALL(OP_TAIL_CALL, 2, 0); */
-  CHECK_BYTES(OP_READ_LOCAL, 1);
+  CHECK_BYTES(OP_READ_LOCAL_LOCAL, 1);
   CHECK_BYTES(OP_READ_LOCAL, 2);
   CHECK_BYTE(OP_ADD);
   CHECK_BYTE(OP_RETURN);
@@ -206,7 +207,7 @@ static void compiles_named_let() {
 
   CHECK_SET_FUNC(AS_FUNCTION(out_func->chunk.constants.values[2]));
 
-  CHECK_BYTES(OP_READ_LOCAL, 0);
+  CHECK_BYTES(OP_READ_LOCAL_LOCAL, 0);
   /* CHECK_BYTES(OP_READ_GLOBAL, 0); */
   /* CHECK_BYTES(OP_READ_LOCAL, 1); */
   /* CHECK_BYTES(OP_READ_LOCAL, 2); */
@@ -340,6 +341,32 @@ static void compiles_lambda_rest_args() {
   PASS();
 }
 
+static void compiles_lambda_keyword_args() {
+  COMPILER_INIT();
+
+  COMPILE("(define (key-func x :rest args :keys y (z 3))"
+          "  (display z))");
+
+  ObjectFunction *func = AS_FUNCTION(out_func->chunk.constants.values[1]);
+  ASSERT_INT(2, func->arity);
+  ASSERT_INT(2, func->rest_arg_index);
+  ASSERT_INT(2, func->keyword_args.count);
+  ASSERT_INT(0, func->keyword_args.args[0].default_index);
+  ASSERT_INT(1, func->keyword_args.args[1].default_index > 0);
+
+  COMPILE("(key-func 1 :z 2 :y 3)");
+
+  CHECK_BYTES(OP_READ_GLOBAL, 0);
+  CHECK_BYTES(OP_CONSTANT, 1);
+  CHECK_BYTES(OP_CONSTANT, 2);
+  CHECK_BYTES(OP_CONSTANT, 3);
+  CHECK_BYTES(OP_CONSTANT, 4);
+  CHECK_BYTES(OP_CONSTANT, 5);
+  CHECK_CALL(OP_CALL, 1, 2);
+
+  PASS();
+}
+
 static void compiles_define_simple_binding() {
   COMPILER_INIT();
 
@@ -399,7 +426,7 @@ static void compiles_define_attributes() {
   /* CHECK_BYTES(OP_READ_LOCAL, 1); */
   /* CHECK_BYTES(OP_CONSTANT, 1); */
   /* CHECK_CALL(OP_TAIL_CALL, 2, 0); */
-  CHECK_BYTES(OP_READ_LOCAL, 1);
+  CHECK_BYTES(OP_LOCAL_CONSTANT_ADD, 1);
   CHECK_BYTES(OP_CONSTANT, 0);
   CHECK_BYTE(OP_ADD);
   CHECK_BYTE(OP_RETURN);
@@ -413,7 +440,7 @@ static void compiles_define_attributes() {
   /* CHECK_BYTES(OP_READ_LOCAL, 1); */
   /* CHECK_BYTES(OP_CONSTANT, 1); */
   /* CHECK_CALL(OP_TAIL_CALL, 2, 0); */
-  CHECK_BYTES(OP_READ_LOCAL, 1);
+  CHECK_BYTES(OP_LOCAL_CONSTANT_ADD, 1);
   CHECK_BYTES(OP_CONSTANT, 0);
   CHECK_BYTE(OP_ADD);
   CHECK_BYTE(OP_RETURN);
@@ -427,7 +454,7 @@ static void compiles_define_attributes() {
   /* CHECK_BYTES(OP_READ_LOCAL, 1); */
   /* CHECK_BYTES(OP_CONSTANT, 1); */
   /* CHECK_CALL(OP_TAIL_CALL, 2, 0); */
-  CHECK_BYTES(OP_READ_LOCAL, 1);
+  CHECK_BYTES(OP_LOCAL_CONSTANT_ADD, 1);
   CHECK_BYTES(OP_CONSTANT, 0);
   CHECK_BYTE(OP_ADD);
   CHECK_BYTE(OP_RETURN);
@@ -459,6 +486,20 @@ static void compiles_tail_call_basic() {
   CHECK_CALL(OP_TAIL_CALL, 1, 0);
   CHECK_BYTE(OP_RETURN);
 
+  COMPILE("(define (test-func x)"
+          "  (apply next-func x)"
+          "  (apply next-func x))");
+
+  CHECK_SET_FUNC(AS_FUNCTION(out_func->chunk.constants.values[1]));
+  CHECK_BYTES(OP_READ_GLOBAL, 0);
+  CHECK_BYTES(OP_READ_LOCAL, 1);
+  CHECK_BYTE(OP_APPLY);
+  CHECK_BYTE(OP_POP);
+  CHECK_BYTES(OP_READ_GLOBAL, 0);
+  CHECK_BYTES(OP_READ_LOCAL, 1);
+  CHECK_BYTE(OP_TAIL_APPLY);
+  CHECK_BYTE(OP_RETURN);
+
   // The invocation of `next-func` is not a tail call
 
   COMPILE("(define (test-func x)"
@@ -585,14 +626,14 @@ static void compiles_tail_call_if_expr() {
   /* CHECK_BYTES(OP_READ_LOCAL, 1); */
   /* CHECK_BYTE(OP_RETURN); */
 
-  CHECK_BYTES(OP_READ_LOCAL, 1);
+  CHECK_BYTES(OP_READ_LOCAL_CONSTANT, 1);
   CHECK_BYTES(OP_CONSTANT, 0);
   CHECK_BYTE(OP_EQUAL);
   CHECK_BYTE(OP_NOT);
   CHECK_JUMP(OP_JUMP_IF_FALSE, 6, 23);
   CHECK_BYTE(OP_POP);
   CHECK_BYTES(OP_READ_GLOBAL, 1);
-  CHECK_BYTES(OP_READ_LOCAL, 1);
+  CHECK_BYTES(OP_LOCAL_CONSTANT_ADD, 1);
   CHECK_BYTES(OP_CONSTANT, 2);
   CHECK_BYTE(OP_ADD);
   CHECK_CALL(OP_TAIL_CALL, 1, 0);
@@ -712,6 +753,15 @@ static void compiler_error_bad_lambda() {
   COMPILE("(lambda (foo))");
   ASSERT_ERROR("lambda: Expected at least one body expression.");
 
+  COMPILE("(lambda (foo :bar baz) foo)");
+  ASSERT_ERROR("lambda: Unexpected keyword in parameter list at line 1 in (unknown)");
+
+  COMPILE("(lambda (foo :keys (bar)) foo)");
+  ASSERT_ERROR("lambda: Expected symbol or (symbol default) after :keys");
+
+  COMPILE("(lambda (foo :keys (bar (+ 1 2))) foo)");
+  ASSERT_ERROR("lambda: Keyword parameter default must be a literal value");
+
   PASS();
 }
 
@@ -883,6 +933,7 @@ void test_compiler_suite() {
 
   compiles_module_import();
   compiles_lambda_rest_args();
+  compiles_lambda_keyword_args();
   compiles_tail_call_basic();
   compiles_tail_call_begin();
   compiles_tail_call_let();
@@ -79,7 +79,7 @@ static Reader reader;
 
 #define EXPECT_EMPTY()                                                                             \
   if (!IS_EMPTY(AS_CONS(current_syntax->value)->car)) {                                            \
-    FAIL("Expected an empty list, got %d", current_syntax->value.kind);                            \
+    FAIL("Expected an empty list, got %d", VALUE_KIND(current_syntax->value));                            \
   } else {                                                                                         \
     current_syntax = AS_SYNTAX(AS_CONS(current_syntax->value)->cdr);                               \
   }
@@ -1,4 +1,13 @@
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../src/gc.h"
+#include "../src/mem.h"
 #include "../src/object.h"
+#include "../src/op.h"
+#include "../src/profiler.h"
+#include "../src/snapshot.h"
 #include "../src/value.h"
 #include "../src/vm-impl.h"
 #include "test.h"
@@ -40,15 +49,45 @@ static void returns_basic_values() {
 
   VM_EVAL("311", INTERPRET_OK);
   value = *vm.stack_top;
-  ASSERT_KIND(value.kind, VALUE_NUMBER);
+  ASSERT_KIND(VALUE_KIND(value), VALUE_FIXNUM);
 
   VM_EVAL("#t", INTERPRET_OK);
   value = *vm.stack_top;
-  ASSERT_KIND(value.kind, VALUE_TRUE);
+  ASSERT_KIND(VALUE_KIND(value), VALUE_TRUE);
 
   VM_EVAL("#f", INTERPRET_OK);
   value = *vm.stack_top;
-  ASSERT_KIND(value.kind, VALUE_FALSE);
+  ASSERT_KIND(VALUE_KIND(value), VALUE_FALSE);
+
+  PASS();
+}
+
+static void returns_immediate_values() {
+  VM_INIT();
+  Value value;
+
+  VM_EVAL("#\\a", INTERPRET_OK);
+  value = *vm.stack_top;
+  ASSERT_KIND(VALUE_KIND(value), VALUE_CHAR);
+  if (AS_CHAR(value) != 'a') {
+    FAIL("Expected character 'a', got '%c'", AS_CHAR(value));
+  }
+
+  VM_EVAL("-2.5", INTERPRET_OK);
+  value = *vm.stack_top;
+  ASSERT_KIND(VALUE_KIND(value), VALUE_NUMBER);
+  if (AS_NUMBER(value) != -2.5) {
+    FAIL("Expected -2.5, got %f", AS_NUMBER(value));
+  }
+
+  VM_EVAL("'()", INTERPRET_OK);
+  value = *vm.stack_top;
+  ASSERT_KIND(VALUE_KIND(value), VALUE_EMPTY);
+
+  VM_EVAL("\"str\"", INTERPRET_OK);
+  value = *vm.stack_top;
+  ASSERT_KIND(VALUE_KIND(value), VALUE_OBJECT);
+  ASSERT_OBJECT(value, ObjectKindString);
 
   PASS();
 }
@@ -66,24 +105,107 @@ static void calls_function_with_rest_args() {
           INTERPRET_OK);
 
   value = *vm.stack_top;
-  ASSERT_KIND(value.kind, VALUE_NUMBER);
+  ASSERT_KIND(VALUE_KIND(value), VALUE_FIXNUM);
 
-  /* VM_EVAL("(module-import (mesche list))" */
-  /*         "(define (with-rest x :rest args :keys key)" */
-  /*         "  (car (cdr (cdr args))))" */
-  /*         "(with-rest 4 5 6 7 8)", */
-  /*         INTERPRET_OK); */
+  VM_EVAL("(define (with-keys x :rest args :keys key)"
+          "  (car (cdr (cdr args))))"
+          "(with-keys 4 5 6 7 8)",
+          INTERPRET_OK);
 
-  /* value = *vm.stack_top; */
-  /* ASSERT_KIND(value.kind, VALUE_NUMBER); */
+  value = *vm.stack_top;
+  ASSERT_KIND(VALUE_KIND(value), VALUE_FIXNUM);
 
-  /* VM_EVAL("(define (with-rest x :rest args :keys key)" */
-  /*         "  args)" */
-  /*         "(with-rest 4 :key 'foo)", */
-  /*         INTERPRET_OK); */
+  VM_EVAL("(define (with-keys x :rest args :keys key)"
+          "  args)"
+          "(with-keys 4 :key 'foo)",
+          INTERPRET_OK);
 
-  /* value = *vm.stack_top; */
-  /* ASSERT_KIND(value.kind, VALUE_FALSE); */
+  value = *vm.stack_top;
+  ASSERT_KIND(VALUE_KIND(value), VALUE_FALSE);
+
+  PASS();
+}
+
+static void calls_function_with_keyword_args() {
+  VM_INIT();
+  Value value;
+
+  VM_EVAL("(define (add-keys a :keys (b 10) (c 100))"
+          "  (+ a (+ b c)))"
+          "(+ (add-keys 1)"
+          "   (+ (add-keys 1 :c 3) (add-keys 1 :c 3 :b 2)))",
+          INTERPRET_OK);
+  value = *vm.stack_top;
+  ASSERT_KIND(VALUE_KIND(value), VALUE_FIXNUM);
+  if (AS_FIXNUM(value) != 131) {
+    FAIL("Expected 131, got %lld", (long long)AS_FIXNUM(value));
+  }
+
+  // The same call site maps its keywords onto different slot orders
+  VM_EVAL("(define (diff :keys (x 0) (y 0)) (- x y))"
+          "(define (diff-reversed :keys (y 0) (x 0)) (- y x))"
+          "(define (call-site f) (f :x 10 :y 3))"
+          "(+ (call-site diff)"
+          "   (+ (call-site diff-reversed) (* 2 (call-site diff))))",
+          INTERPRET_OK);
+  value = *vm.stack_top;
+  ASSERT_KIND(VALUE_KIND(value), VALUE_FIXNUM);
+  if (AS_FIXNUM(value) != 14) {
+    FAIL("Expected 14, got %lld", (long long)AS_FIXNUM(value));
+  }
+
+  // Keywords passed to a function without keyword parameters stay positional
+  VM_EVAL("(define (second a b) b)"
+          "(second :x 42)",
+          INTERPRET_OK);
+  value = *vm.stack_top;
+  ASSERT_KIND(VALUE_KIND(value), VALUE_FIXNUM);
+
+  VM_EVAL("(define-record-type point (fields x y))"
+          "(define (make-at y) (make-point :y y :x 2))"
+          "(make-at 1)"
+          "(point-y (make-at 5))",
+          INTERPRET_OK);
+  value = *vm.stack_top;
+  ASSERT_KIND(VALUE_KIND(value), VALUE_FIXNUM);
+  if (AS_FIXNUM(value) != 5) {
+    FAIL("Expected 5, got %lld", (long long)AS_FIXNUM(value));
+  }
+
+  VM_EVAL("(point-x (make-point :y 1))", INTERPRET_OK);
+  value = *vm.stack_top;
+  ASSERT_KIND(VALUE_KIND(value), VALUE_FALSE);
+
+  PASS();
+}
+
+static void constructs_records_positionally() {
+  VM_INIT();
+  Value value;
+
+  VM_EVAL("(define-record-type point (fields x y z))"
+          "(point-y (make-point 1 2))",
+          INTERPRET_OK);
+  value = *vm.stack_top;
+  ASSERT_KIND(VALUE_KIND(value), VALUE_FIXNUM);
+  if (AS_FIXNUM(value) != 2) {
+    FAIL("Expected 2, got %lld", (long long)AS_FIXNUM(value));
+  }
+
+  // Fields that aren't passed keep their defaults
+  VM_EVAL("(point-z (make-point 1 2))", INTERPRET_OK);
+  value = *vm.stack_top;
+  ASSERT_KIND(VALUE_KIND(value), VALUE_FALSE);
+
+  // Keyword values can follow the positional values
+  VM_EVAL("(point-z (make-point 1 :z 7))", INTERPRET_OK);
+  value = *vm.stack_top;
+  ASSERT_KIND(VALUE_KIND(value), VALUE_FIXNUM);
+  if (AS_FIXNUM(value) != 7) {
+    FAIL("Expected 7, got %lld", (long long)AS_FIXNUM(value));
+  }
+
+  VM_EVAL("(make-point 1 2 3 4)", INTERPRET_RUNTIME_ERROR);
 
   PASS();
 }
@@ -111,7 +233,7 @@ static void evaluates_and_or() {
           "    #f)",
           INTERPRET_OK);
   value = *vm.stack_top;
-  ASSERT_KIND(value.kind, VALUE_NUMBER);
+  ASSERT_KIND(VALUE_KIND(value), VALUE_FIXNUM);
 
   if (AS_NUMBER(value) != 4) {
     FAIL("It wasn't 4!");
@@ -128,7 +250,7 @@ static void evaluates_let() {
           "  (+ x y))",
           INTERPRET_OK);
   value = *vm.stack_top;
-  ASSERT_KIND(value.kind, VALUE_NUMBER);
+  ASSERT_KIND(VALUE_KIND(value), VALUE_FIXNUM);
 
   if (AS_NUMBER(value) != 7) {
     FAIL("It wasn't 7!");
@@ -150,7 +272,7 @@ static void evaluates_calls() {
           "(alpha 1)",
           INTERPRET_OK);
   value = *vm.stack_top;
-  ASSERT_KIND(value.kind, VALUE_NUMBER);
+  ASSERT_KIND(VALUE_KIND(value), VALUE_FIXNUM);
 
   if (AS_NUMBER(value) != 2) {
     FAIL("It wasn't 2!");
@@ -168,7 +290,7 @@ static void evaluates_reset() {
 
   VM_EVAL("(+ 1 (reset (lambda () 3)))", INTERPRET_OK);
   value = *vm.stack_top;
-  ASSERT_KIND(value.kind, VALUE_NUMBER);
+  ASSERT_KIND(VALUE_KIND(value), VALUE_FIXNUM);
 
   if (AS_NUMBER(value) != 4) {
     FAIL("It wasn't 4!");
@@ -186,7 +308,7 @@ static void evaluates_reset_cleanup() {
 
   VM_EVAL("(+ 1 (reset (lambda () (reset (lambda () 3)))))", INTERPRET_OK);
   value = *vm.stack_top;
-  ASSERT_KIND(value.kind, VALUE_NUMBER);
+  ASSERT_KIND(VALUE_KIND(value), VALUE_FIXNUM);
 
   if (AS_NUMBER(value) != 4) {
     FAIL("It wasn't 4!");
@@ -201,7 +323,7 @@ static void evaluates_reset_shift_after_cleanup() {
 
   VM_EVAL("(+ 1 (reset (lambda () (reset (lambda () 3)) (shift (lambda (k) 4)))))", INTERPRET_OK);
   value = *vm.stack_top;
-  ASSERT_KIND(value.kind, VALUE_NUMBER);
+  ASSERT_KIND(VALUE_KIND(value), VALUE_FIXNUM);
 
   if (AS_NUMBER(value) != 5) {
     FAIL("It wasn't 5!");
@@ -219,7 +341,7 @@ static void evaluates_shift_in_reset() {
 
   VM_EVAL("(+ 1 (reset (lambda () (* 2 ( + 4 (shift (lambda (k) 3)))))))", INTERPRET_OK);
   value = *vm.stack_top;
-  ASSERT_KIND(value.kind, VALUE_NUMBER);
+  ASSERT_KIND(VALUE_KIND(value), VALUE_FIXNUM);
 
   if (AS_NUMBER(value) != 4) {
     FAIL("It wasn't 4!");
@@ -239,7 +361,7 @@ static void evaluates_shift_in_reset_with_tail_calls() {
       "(+ 1 (reset (lambda () (* 2 ((lambda () ((lambda () ( + 4 (shift (lambda (k) 3)))))))))))",
       INTERPRET_OK);
   value = *vm.stack_top;
-  ASSERT_KIND(value.kind, VALUE_NUMBER);
+  ASSERT_KIND(VALUE_KIND(value), VALUE_FIXNUM);
 
   if (AS_NUMBER(value) != 4) {
     FAIL("It wasn't 4!");
@@ -257,7 +379,7 @@ static void evaluates_calling_continuation() {
           "(+ 2 ((doubler) 3))",
           INTERPRET_OK);
   value = *vm.stack_top;
-  ASSERT_KIND(value.kind, VALUE_NUMBER);
+  ASSERT_KIND(VALUE_KIND(value), VALUE_FIXNUM);
 
   if (AS_NUMBER(value) != 8) {
     FAIL("It wasn't 8!");
@@ -275,7 +397,7 @@ static void evaluates_calling_continuation_with_capture() {
           "((lambda (x) (+ x ((times x) 3))) 2)",
           INTERPRET_OK);
   value = *vm.stack_top;
-  ASSERT_KIND(value.kind, VALUE_NUMBER);
+  ASSERT_KIND(VALUE_KIND(value), VALUE_FIXNUM);
 
   if (AS_NUMBER(value) != 8) {
     FAIL("It wasn't 8!");
@@ -293,7 +415,7 @@ static void evaluates_calling_continuation_in_shift() {
 
   VM_EVAL("(+ 1 (reset (lambda () (* 2 (shift (lambda (k) (+ 2 (k 3))))))))", INTERPRET_OK);
   value = *vm.stack_top;
-  ASSERT_KIND(value.kind, VALUE_NUMBER);
+  ASSERT_KIND(VALUE_KIND(value), VALUE_FIXNUM);
 
   if (AS_NUMBER(value) != 9) {
     FAIL("It wasn't 9!");
@@ -314,7 +436,7 @@ static void evaluates_calling_continuation_composed() {
           "((lambda (x) (+ x ((times x) 3))) 2)",
           INTERPRET_OK);
   value = *vm.stack_top;
-  ASSERT_KIND(value.kind, VALUE_NUMBER);
+  ASSERT_KIND(VALUE_KIND(value), VALUE_FIXNUM);
 
   if (AS_NUMBER(value) != 8) {
     FAIL("It wasn't 8!");
@@ -329,7 +451,7 @@ static void evaluates_continuation_channels_sample() {
 
   VM_EVAL_FILE("./test/samples/continuations_channels.msc", INTERPRET_OK);
   value = *vm.stack_top;
-  ASSERT_KIND(value.kind, VALUE_NUMBER);
+  ASSERT_KIND(VALUE_KIND(value), VALUE_FIXNUM);
 
   if (AS_NUMBER(value) != 100) {
     FAIL("It wasn't 100!");
@@ -338,6 +460,334 @@ static void evaluates_continuation_channels_sample() {
   PASS();
 }
 
+static void evaluates_global_bindings() {
+  VM_INIT();
+  Value value;
+
+  VM_EVAL("(define counter 0)"
+          "(define (bump) (set! counter (+ counter 1)))"
+          "(bump)"
+          "(bump)"
+          "counter",
+          INTERPRET_OK);
+  value = *vm.stack_top;
+  ASSERT_KIND(VALUE_KIND(value), VALUE_FIXNUM);
+
+  if (AS_NUMBER(value) != 2) {
+    FAIL("Expected 2, got %f", AS_NUMBER(value));
+  }
+
+  // A new module binding shadows the core binding a call site resolved to
+  VM_EVAL("(define (get-length) (length '(1 2 3)))"
+          "(get-length)"
+          "(define (length items) 42)"
+          "(get-length)",
+          INTERPRET_OK);
+  value = *vm.stack_top;
+  ASSERT_KIND(VALUE_KIND(value), VALUE_FIXNUM);
+
+  if (AS_NUMBER(value) != 42) {
+    FAIL("Expected 42, got %f", AS_NUMBER(value));
+  }
+
+  PASS();
+}
+
+static void sets_undefined_global() {
+  VM_INIT();
+
+  VM_EVAL("(set! not-defined 1)", INTERPRET_RUNTIME_ERROR);
+
+  PASS();
+}
+
+static void evaluates_polymorphic_call_sites() {
+  VM_INIT();
+  Value value;
+
+  // The call in apply-to sees more distinct callees than its cache holds
+  VM_EVAL("(define (apply-to f x) (f x))"
+          "(define (inc x) (+ x 1))"
+          "(define (dbl x) (* x 2))"
+          "(define (pair x y) x)"
+          "(define (sum-calls)"
+          "  (+ (+ (apply-to inc 1) (apply-to dbl 5))"
+          "     (+ (apply-to car '(3)) (apply-to (lambda (x) (- x 1)) 1))))"
+          "(+ (sum-calls) (sum-calls))",
+          INTERPRET_OK);
+  value = *vm.stack_top;
+  ASSERT_KIND(VALUE_KIND(value), VALUE_FIXNUM);
+
+  if (AS_NUMBER(value) != 30) {
+    FAIL("Expected 30, got %f", AS_NUMBER(value));
+  }
+
+  // A callee with the wrong arity is still rejected at a warm call site
+  VM_EVAL("(apply-to pair 1)", INTERPRET_RUNTIME_ERROR);
+
+  PASS();
+}
+
+static void evaluates_quickened_operations() {
+  VM_INIT();
+  Value value;
+
+  // The comparison is quickened for numbers first and then sees symbols
+  VM_EVAL("(define (same? a b) (eqv? a b))"
+          "(define (count-same a b) (if (same? a b) 1 0))"
+          "(+ (+ (count-same 1 1) (count-same 'a 'a))"
+          "   (+ (count-same 2 3) (count-same 4 4)))",
+          INTERPRET_OK);
+  value = *vm.stack_top;
+  ASSERT_KIND(VALUE_KIND(value), VALUE_FIXNUM);
+
+  if (AS_NUMBER(value) != 3) {
+    FAIL("Expected 3, got %f", AS_NUMBER(value));
+  }
+
+  // A quickened operation still reports errors for non-number operands
+  VM_EVAL("(define (add a b) (+ a b))"
+          "(add 1 2)"
+          "(add 3 4)",
+          INTERPRET_OK);
+  VM_EVAL("(add \"one\" 2)", INTERPRET_RUNTIME_ERROR);
+
+  // A site that has seen both fixnums and doubles stays generic
+  VM_EVAL("(define (scale a b) (* a b))"
+          "(scale 2 3)"
+          "(scale 1.5 2.0)"
+          "(scale 4 5)"
+          "(scale 2.5 2.0)"
+          "(+ (scale 6 7) (scale 0.5 4.0))",
+          INTERPRET_OK);
+  value = *vm.stack_top;
+  ASSERT_KIND(VALUE_KIND(value), VALUE_NUMBER);
+  if (AS_NUMBER(value) != 44) {
+    FAIL("Expected 44, got %f", AS_NUMBER(value));
+  }
+
+  VM_EVAL("scale", INTERPRET_OK);
+  Chunk *chunk = &AS_CLOSURE(*vm.stack_top)->function->chunk;
+  if (memchr(chunk->code, OP_MULTIPLY_ANY, chunk->count) == NULL) {
+    FAIL("Expected the multiplication to stay generic");
+  }
+
+  PASS();
+}
+
+static void evaluates_superinstructions() {
+  VM_INIT();
+  Value value;
+  Chunk *chunk;
+
+  // The `then` branch jumps to the constant in the middle of the fused
+  // local, constant and add sequence that ends the `else` branch
+  VM_EVAL("(define (pick c a b) (+ (if c a b) 100))"
+          "(+ (pick #t 1 2) (* (pick #f 1 2) 1000))",
+          INTERPRET_OK);
+  value = *vm.stack_top;
+  ASSERT_KIND(VALUE_KIND(value), VALUE_FIXNUM);
+  ASSERT_INT(102101, AS_FIXNUM(value));
+
+  VM_EVAL("pick", INTERPRET_OK);
+  chunk = &AS_CLOSURE(*vm.stack_top)->function->chunk;
+  if (memchr(chunk->code, OP_LOCAL_CONSTANT_ADD, chunk->count) == NULL) {
+    FAIL("Expected the addition to be fused");
+  }
+
+  // The fused comparison and branch reports non-number operands
+  VM_EVAL("(define (smaller a b) (if (< a b) a b))"
+          "(smaller 3 2)",
+          INTERPRET_OK);
+  value = *vm.stack_top;
+  ASSERT_KIND(VALUE_KIND(value), VALUE_FIXNUM);
+  ASSERT_INT(2, AS_FIXNUM(value));
+
+  VM_EVAL("smaller", INTERPRET_OK);
+  chunk = &AS_CLOSURE(*vm.stack_top)->function->chunk;
+  if (memchr(chunk->code, OP_LESS_THAN_JUMP_IF_FALSE, chunk->count) == NULL) {
+    FAIL("Expected the comparison to be fused with its branch");
+  }
+
+  VM_EVAL("(smaller \"one\" 2)", INTERPRET_RUNTIME_ERROR);
+  VM_EVAL("(smaller 1 2.5)", INTERPRET_OK);
+  value = *vm.stack_top;
+  ASSERT_KIND(VALUE_KIND(value), VALUE_FIXNUM);
+  ASSERT_INT(1, AS_FIXNUM(value));
+
+  PASS();
+}
+
+static void evaluates_exact_numbers() {
+  VM_INIT();
+  Value value;
+
+  VM_EVAL("(% 17 5)", INTERPRET_OK);
+  value = *vm.stack_top;
+  ASSERT_KIND(VALUE_KIND(value), VALUE_FIXNUM);
+  if (AS_FIXNUM(value) != 2) {
+    FAIL("Expected 2, got %lld", (long long)AS_FIXNUM(value));
+  }
+
+  VM_EVAL("(/ 7 2)", INTERPRET_OK);
+  value = *vm.stack_top;
+  ASSERT_KIND(VALUE_KIND(value), VALUE_NUMBER);
+  if (AS_NUMBER(value) != 3.5) {
+    FAIL("Expected 3.5, got %f", AS_NUMBER(value));
+  }
+
+  VM_EVAL("(eqv? 2 2.0)", INTERPRET_OK);
+  value = *vm.stack_top;
+  ASSERT_KIND(VALUE_KIND(value), VALUE_FALSE);
+
+  // Numbers with the same value are equal regardless of their exactness,
+  // including at sites that were quickened for one kind of number
+  VM_EVAL("(define (same? a b) (equal? a b))"
+          "(same? 3 3)"
+          "(same? 3 (+ 1.5 1.5))",
+          INTERPRET_OK);
+  value = *vm.stack_top;
+  ASSERT_KIND(VALUE_KIND(value), VALUE_TRUE);
+
+  VM_EVAL("(apply equal? (list 2.0 2))", INTERPRET_OK);
+  value = *vm.stack_top;
+  ASSERT_KIND(VALUE_KIND(value), VALUE_TRUE);
+
+  VM_EVAL("(equal? 2 2.5)", INTERPRET_OK);
+  value = *vm.stack_top;
+  ASSERT_KIND(VALUE_KIND(value), VALUE_FALSE);
+
+  // A fixnum operation that overflows produces an inexact result, even after
+  // the opcode has been quickened for fixnums
+  VM_EVAL("(define (double x) (* x 2))"
+          "(double 3)"
+          "(double 70368744177663)",
+          INTERPRET_OK);
+  value = *vm.stack_top;
+  ASSERT_KIND(VALUE_KIND(value), VALUE_NUMBER);
+  if (AS_NUMBER(value) != 140737488355326.0) {
+    FAIL("Expected 140737488355326, got %f", AS_NUMBER(value));
+  }
+
+  VM_EVAL("(exact? (double 4))", INTERPRET_OK);
+  value = *vm.stack_top;
+  ASSERT_KIND(VALUE_KIND(value), VALUE_TRUE);
+
+  VM_EVAL("(inexact? (double 4.5))", INTERPRET_OK);
+  value = *vm.stack_top;
+  ASSERT_KIND(VALUE_KIND(value), VALUE_TRUE);
+
+  VM_EVAL("(exact 9.0)", INTERPRET_OK);
+  value = *vm.stack_top;
+  ASSERT_KIND(VALUE_KIND(value), VALUE_FIXNUM);
+
+  // The magnitude of the smallest fixnum is too big to be a fixnum
+  char source[80];
+  snprintf(source, sizeof(source), "(module-import (mesche math)) (abs %lld)",
+           (long long)FIXNUM_MIN);
+  VM_EVAL(source, INTERPRET_OK);
+  value = *vm.stack_top;
+  ASSERT_KIND(VALUE_KIND(value), VALUE_NUMBER);
+  if (AS_NUMBER(value) != -(double)FIXNUM_MIN) {
+    FAIL("Expected %f, got %f", -(double)FIXNUM_MIN, AS_NUMBER(value));
+  }
+
+  VM_EVAL("(% 1 0)", INTERPRET_RUNTIME_ERROR);
+
+  PASS();
+}
+
+static void evaluates_apply() {
+  VM_INIT();
+  Value value;
+
+  // An apply in tail position reuses the current call frame
+  mesche_vm_stack_configure(&vm, FRAMES_INITIAL, 100, STACK_INITIAL, STACK_MAX);
+  VM_EVAL("(define (count-down n)"
+          "  (if (> n 0) (apply count-down (list (- n 1))) n))"
+          "(count-down 1000)",
+          INTERPRET_OK);
+  value = *vm.stack_top;
+  ASSERT_KIND(VALUE_KIND(value), VALUE_FIXNUM);
+  if (AS_FIXNUM(value) != 0) {
+    FAIL("Expected 0, got %lld", (long long)AS_FIXNUM(value));
+  }
+
+  VM_EVAL("(define (third-rest a . rest) (car (cdr rest)))"
+          "(apply third-rest (list 1 2 3 4))",
+          INTERPRET_OK);
+  value = *vm.stack_top;
+  ASSERT_KIND(VALUE_KIND(value), VALUE_FIXNUM);
+  if (AS_FIXNUM(value) != 3) {
+    FAIL("Expected 3, got %lld", (long long)AS_FIXNUM(value));
+  }
+
+  VM_EVAL("(module-import (mesche array))"
+          "(define (sub a b) (- a b))"
+          "(define values (make-array))"
+          "(array-push values 5)"
+          "(array-push values 7)"
+          "(apply sub values)",
+          INTERPRET_OK);
+  value = *vm.stack_top;
+  ASSERT_KIND(VALUE_KIND(value), VALUE_FIXNUM);
+  if (AS_FIXNUM(value) != -2) {
+    FAIL("Expected -2, got %lld", (long long)AS_FIXNUM(value));
+  }
+
+  // Keyword values stay in place when no rest values are passed
+  VM_EVAL("(define (rest-key a :rest r :keys (k 1)) k)"
+          "(rest-key 1 :k 9)",
+          INTERPRET_OK);
+  value = *vm.stack_top;
+  ASSERT_KIND(VALUE_KIND(value), VALUE_FIXNUM);
+  if (AS_FIXNUM(value) != 9) {
+    FAIL("Expected 9, got %lld", (long long)AS_FIXNUM(value));
+  }
+
+  VM_EVAL("(apply sub 5)", INTERPRET_RUNTIME_ERROR);
+
+  PASS();
+}
+
+static void evaluates_record_field_sites() {
+  VM_INIT();
+  Value value;
+
+  // The first call specializes each site, the later ones take the fast path
+  VM_EVAL("(define-record-type point (fields x y))"
+          "(define (bump! p) (point-x-set! p (+ (point-x p) 1)))"
+          "(define (get-y p) (point-y p))"
+          "(define p (make-point :x 1 :y 10))"
+          "(bump! p) (bump! p) (bump! p)"
+          "(+ (point-x p) (+ (get-y p) (get-y p)))",
+          INTERPRET_OK);
+  value = *vm.stack_top;
+  ASSERT_KIND(VALUE_KIND(value), VALUE_FIXNUM);
+  if (AS_FIXNUM(value) != 24) {
+    FAIL("Expected 24, got %lld", (long long)AS_FIXNUM(value));
+  }
+
+  // A site that sees other callees falls back to a regular call
+  VM_EVAL("(define (call-with f p) (f p))"
+          "(call-with point-x p)"
+          "(call-with point-x p)"
+          "(+ (call-with point-y p) (call-with (lambda (p) 100) p))",
+          INTERPRET_OK);
+  value = *vm.stack_top;
+  ASSERT_KIND(VALUE_KIND(value), VALUE_FIXNUM);
+  if (AS_FIXNUM(value) != 110) {
+    FAIL("Expected 110, got %lld", (long long)AS_FIXNUM(value));
+  }
+
+  // Type errors are still reported after the site has been specialized
+  VM_EVAL("(define-record-type other (fields x))"
+          "(get-y (make-other :x 1))",
+          INTERPRET_RUNTIME_ERROR);
+
+  PASS();
+}
+
 static void evaluates_tail_calls() {
   VM_INIT();
   Value value;
@@ -349,7 +799,7 @@ static void evaluates_tail_calls() {
           "(loop 1)",
           INTERPRET_OK);
   value = *vm.stack_top;
-  ASSERT_KIND(value.kind, VALUE_NUMBER);
+  ASSERT_KIND(VALUE_KIND(value), VALUE_FIXNUM);
 
   if (AS_NUMBER(value) != 5) {
     FAIL("It wasn't 5!");
@@ -368,7 +818,7 @@ static void evaluates_tail_calls_named_let() {
           "      x))",
           INTERPRET_OK);
   value = *vm.stack_top;
-  ASSERT_KIND(value.kind, VALUE_NUMBER);
+  ASSERT_KIND(VALUE_KIND(value), VALUE_FIXNUM);
 
   if (AS_NUMBER(value) != 5) {
     FAIL("It wasn't 5!");
@@ -377,6 +827,540 @@ static void evaluates_tail_calls_named_let() {
   PASS();
 }
 
+static void evaluates_deep_recursion() {
+  VM_INIT();
+  Value value;
+
+  VM_EVAL("(define (count-up n)"
+          "  (if (< n 1) 0 (+ 1 (count-up (- n 1)))))"
+          "(count-up 100000)",
+          INTERPRET_OK);
+  value = *vm.stack_top;
+  ASSERT_KIND(VALUE_KIND(value), VALUE_FIXNUM);
+
+  if (AS_NUMBER(value) != 100000) {
+    FAIL("Expected 100000, got %f", AS_NUMBER(value));
+  }
+
+  PASS();
+}
+
+static void evaluates_deep_continuations() {
+  VM_INIT();
+  Value value;
+
+  // The reset marker sits deeper than a byte's worth of frames
+  VM_EVAL("(define (deep n)"
+          "  (if (equal? n 0)"
+          "      (+ 1 (reset (lambda () (+ 10 (shift (lambda (k) (k (k 5))))))))"
+          "      (+ 0 (deep (- n 1)))))"
+          "(deep 300)",
+          INTERPRET_OK);
+  value = *vm.stack_top;
+  ASSERT_KIND(VALUE_KIND(value), VALUE_FIXNUM);
+
+  if (AS_NUMBER(value) != 26) {
+    FAIL("Expected 26, got %f", AS_NUMBER(value));
+  }
+
+  PASS();
+}
+
+static void grows_stacks_from_minimum_size() {
+  VM_INIT();
+  Value value;
+
+  // Start with the smallest possible stacks so that every call moves them
+  mesche_vm_stack_configure(&vm, 1, FRAMES_MAX, 1, STACK_MAX);
+
+  // The captured `x` is an open upvalue while the stack grows underneath it
+  VM_EVAL("(define (deep n k)"
+          "  (if (< n 1) (k) (+ 0 (deep (- n 1) k))))"
+          "(let ((x 5)) (deep 1000 (lambda () x)))",
+          INTERPRET_OK);
+  value = *vm.stack_top;
+  ASSERT_KIND(VALUE_KIND(value), VALUE_FIXNUM);
+
+  if (AS_NUMBER(value) != 5) {
+    FAIL("Expected 5, got %f", AS_NUMBER(value));
+  }
+
+  VM_EVAL("(define (times x)"
+          "  (reset (lambda () (* x (shift (lambda (k) k))))))"
+          "((lambda (x) (+ x ((times x) 3))) 2)",
+          INTERPRET_OK);
+  value = *vm.stack_top;
+  ASSERT_KIND(VALUE_KIND(value), VALUE_FIXNUM);
+
+  if (AS_NUMBER(value) != 8) {
+    FAIL("It wasn't 8!");
+  }
+
+  PASS();
+}
+
+static void reports_stack_overflow() {
+  VM_INIT();
+
+  mesche_vm_stack_configure(&vm, FRAMES_INITIAL, 100, STACK_INITIAL, STACK_MAX);
+
+  VM_EVAL("(define (count-up n)"
+          "  (if (< n 1) 0 (+ 1 (count-up (- n 1)))))"
+          "(count-up 1000)",
+          INTERPRET_RUNTIME_ERROR);
+
+  PASS();
+}
+
+static void recovers_from_native_errors() {
+  VM_INIT();
+  Value value;
+
+  // The stack is reset by the error before the native function returns
+  VM_EVAL("(weak-table-ref 5 'key)", INTERPRET_RUNTIME_ERROR);
+  ASSERT_INT(0, (int)(vm.stack_top - vm.stack));
+
+  VM_EVAL("(+ 1 2)", INTERPRET_OK);
+  value = *vm.stack_top;
+  ASSERT_KIND(VALUE_KIND(value), VALUE_FIXNUM);
+  ASSERT_INT(3, AS_FIXNUM(value));
+
+  PASS();
+}
+
+static void keeps_values_stored_in_surviving_objects() {
+  VM_INIT();
+  Value value;
+
+  // Objects that survive a collection are promoted when garbage is collected
+  // generationally, so the values later stored in them must stay alive
+  VM_EVAL("(define items (make-array 1))"
+          "(define-record-type box (fields item))"
+          "(define b (make-box))"
+          "(define (make-cell) (let ((n 0)) (cons (lambda () n) (lambda (v) (set! n v)))))"
+          "(define cell (make-cell))"
+          "(define g #f)",
+          INTERPRET_OK);
+  mesche_mem_collect_garbage((MescheMemory *)&vm);
+
+  VM_EVAL("(array-nth-set! items 0 (list 1 2))"
+          "(box-item-set! b (list 3 4))"
+          "((cdr cell) (list 5 6))"
+          "(set! g (list 7 8))",
+          INTERPRET_OK);
+  mesche_mem_collect_garbage((MescheMemory *)&vm);
+  mesche_mem_collect_garbage((MescheMemory *)&vm);
+
+  VM_EVAL("(+ (+ (car (cdr (array-nth items 0))) (car (cdr (box-item b))))"
+          "   (+ (car (cdr ((car cell)))) (car (cdr g))))",
+          INTERPRET_OK);
+  value = *vm.stack_top;
+  ASSERT_KIND(VALUE_KIND(value), VALUE_FIXNUM);
+  if (AS_FIXNUM(value) != 20) {
+    FAIL("Expected 20, got %lld", (long long)AS_FIXNUM(value));
+  }
+
+  PASS();
+}
+
+static void keeps_values_stored_between_collection_slices() {
+  VM_INIT();
+  Value value;
+
+  // The list is big enough that marking it takes several slices when garbage
+  // is collected incrementally.  The array after it is traced first, so the
+  // lists stored in it afterwards are only found through the write barrier.
+  VM_EVAL("(define (build n acc) (if (> n 0) (build (- n 1) (cons n acc)) acc))"
+          "(define big (cons (build 20000 '()) (make-array 1)))"
+          "#t",
+          INTERPRET_OK);
+
+  // Evaluation does slices of its own, so stop after a while in case it keeps
+  // starting new cycles
+  int slice_count = 0;
+  mesche_mem_collect_garbage_slice((MescheMemory *)&vm);
+  do {
+    VM_EVAL("(array-nth-set! (cdr big) 0 (list 1 2)) #t", INTERPRET_OK);
+    mesche_mem_collect_garbage_slice((MescheMemory *)&vm);
+  } while (vm.gc_phase == GC_PHASE_MARKING && ++slice_count < 100);
+
+  VM_EVAL("(build 1000 '())"
+          "(car (cdr (array-nth (cdr big) 0)))",
+          INTERPRET_OK);
+  value = *vm.stack_top;
+  ASSERT_KIND(VALUE_KIND(value), VALUE_FIXNUM);
+  if (AS_FIXNUM(value) != 2) {
+    FAIL("Expected 2, got %lld", (long long)AS_FIXNUM(value));
+  }
+
+  PASS();
+}
+
+static void reuses_swept_heap_pages() {
+  VM_INIT();
+
+  // The scripts end with #t so that the list is only reachable from the global
+  VM_EVAL("(define (build n acc) (if (> n 0) (build (- n 1) (cons n acc)) acc))"
+          "(define items (build 20000 '()))"
+          "#t",
+          INTERPRET_OK);
+  vm.next_major_gc = 0;
+  mesche_mem_collect_garbage((MescheMemory *)&vm);
+  size_t page_count = vm.mem.heap.page_count;
+  size_t bytes_allocated = vm.mem.bytes_allocated;
+
+  // Dropping the list empties the pages it was allocated in
+  VM_EVAL("(set! items #f)", INTERPRET_OK);
+  vm.next_major_gc = 0;
+  mesche_mem_collect_garbage((MescheMemory *)&vm);
+  if (vm.mem.heap.page_count >= page_count || vm.mem.bytes_allocated >= bytes_allocated) {
+    FAIL("Expected fewer than %zu pages and %zu bytes, got %zu and %zu", page_count,
+         bytes_allocated, vm.mem.heap.page_count, vm.mem.bytes_allocated);
+  }
+
+  // Building the list again takes those pages back before mapping new ones
+  size_t empty_page_count = vm.mem.heap.empty_page_count;
+  VM_EVAL("(set! items (build 20000 '())) #t", INTERPRET_OK);
+  if (vm.mem.heap.empty_page_count >= empty_page_count) {
+    FAIL("Expected fewer than %zu empty pages, got %zu", empty_page_count,
+         vm.mem.heap.empty_page_count);
+  }
+
+  PASS();
+}
+
+static void raises_error_when_heap_limit_exceeded() {
+  VM_INIT();
+
+  VM_EVAL("(define (build n acc) (if (> n 0) (build (- n 1) (cons n acc)) acc))"
+          "#t",
+          INTERPRET_OK);
+  mesche_mem_collect_garbage((MescheMemory *)&vm);
+  mesche_mem_set_heap_limit(&vm.mem, vm.mem.bytes_allocated + 1024 * 1024);
+
+  // The list can't fit under the limit so building it fails with an error
+  VM_EVAL("(define items (build 100000 '())) #t", INTERPRET_RUNTIME_ERROR);
+  if (vm.mem.bytes_allocated > vm.mem.heap_limit + 64 * 1024) {
+    FAIL("Expected at most %zu bytes, got %zu", vm.mem.heap_limit + 64 * 1024,
+         vm.mem.bytes_allocated);
+  }
+
+  // The partial list is garbage once the error is raised
+  VM_EVAL("(define items (build 1000 '())) #t", INTERPRET_OK);
+
+  PASS();
+}
+
+static void paces_collections_within_heap_limit() {
+  VM_INIT();
+
+  // The next collection can't be scheduled past the heap limit
+  mesche_mem_set_heap_target(&vm.mem, 64 * 1024 * 1024);
+  mesche_mem_collect_garbage((MescheMemory *)&vm);
+  size_t heap_limit = vm.mem.bytes_allocated + 128 * 1024;
+  mesche_mem_set_heap_limit(&vm.mem, heap_limit);
+  mesche_mem_collect_garbage((MescheMemory *)&vm);
+  if (vm.mem.next_gc != heap_limit) {
+    FAIL("Expected next GC at %zu bytes, got %zu", heap_limit, vm.mem.next_gc);
+  }
+
+  // Allocations past 2GB are accounted without overflowing
+  mesche_mem_set_heap_limit(&vm.mem, 0);
+  size_t bytes_allocated = vm.mem.bytes_allocated;
+  mesche_mem_reserve(&vm.mem, (size_t)3 << 30);
+  if (vm.mem.bytes_allocated < (size_t)3 << 30) {
+    FAIL("Expected at least 3GB allocated, got %zu", vm.mem.bytes_allocated);
+  }
+
+  FREE_SIZE(&vm.mem, NULL, (size_t)3 << 30);
+  if (vm.mem.bytes_allocated > bytes_allocated) {
+    FAIL("Expected at most %zu bytes, got %zu", bytes_allocated, vm.mem.bytes_allocated);
+  }
+
+  PASS();
+}
+
+static void collects_gc_statistics() {
+  VM_INIT();
+  Value value;
+
+  VM_EVAL("(define (build n acc) (if (> n 0) (build (- n 1) (cons n acc)) acc))"
+          "(define items (build 1000 '()))"
+          "#t",
+          INTERPRET_OK);
+  mesche_mem_collect_garbage((MescheMemory *)&vm);
+
+  // Every pause is counted in one bucket of the histogram
+  MescheGCStats *stats = &vm.mem.stats;
+  size_t bucket_total = 0;
+  for (int i = 0; i < GC_PAUSE_BUCKET_COUNT; i++) {
+    bucket_total += stats->pause_buckets[i];
+  }
+  if (stats->collection_count == 0 || bucket_total != stats->pause_count) {
+    FAIL("Expected pauses in the histogram, got %zu collections and %zu of %zu pauses",
+         stats->collection_count, bucket_total, stats->pause_count);
+  }
+
+  MescheObjectStats object_stats;
+  mesche_gc_object_stats(&vm, &object_stats);
+  if (object_stats.object_counts[ObjectKindCons] < 1000 ||
+      object_stats.object_bytes[ObjectKindCons] <
+          object_stats.object_counts[ObjectKindCons] * sizeof(ObjectCons)) {
+    FAIL("Expected at least 1000 pairs, got %zu taking %zu bytes",
+         object_stats.object_counts[ObjectKindCons], object_stats.object_bytes[ObjectKindCons]);
+  }
+
+  VM_EVAL("(module-import (mesche gc))"
+          "(gc-collect)"
+          "(define stats (gc-stats))"
+          "(car (plist-ref (plist-ref stats :objects) :cons))",
+          INTERPRET_OK);
+  value = *vm.stack_top;
+  ASSERT_KIND(VALUE_KIND(value), VALUE_FIXNUM);
+  if (AS_FIXNUM(value) < 1000) {
+    FAIL("Expected at least 1000 pairs, got %lld", (long long)AS_FIXNUM(value));
+  }
+
+  VM_EVAL("(plist-ref stats :collections)", INTERPRET_OK);
+  value = *vm.stack_top;
+  ASSERT_KIND(VALUE_KIND(value), VALUE_FIXNUM);
+  if (AS_FIXNUM(value) < 2) {
+    FAIL("Expected at least 2 collections, got %lld", (long long)AS_FIXNUM(value));
+  }
+
+  PASS();
+}
+
+static void profiles_allocation_sites() {
+  VM_INIT();
+
+  // Sample every allocation so that the byte counts are exact
+  mesche_profiler_start(&vm, 1);
+  VM_EVAL("(define (build n acc) (if (> n 0) (build (- n 1) (cons n acc)) acc))"
+          "(define (churn n) (if (> n 0) (begin (build 10 '()) (churn (- n 1))) #t))"
+          "(define items (build 1000 '()))"
+          "(churn 100)",
+          INTERPRET_OK);
+  mesche_profiler_stop(&vm);
+  vm.next_major_gc = 0;
+  mesche_mem_collect_garbage((MescheMemory *)&vm);
+
+  // The kept list is live at the site that built it from the top level and
+  // the lists built by `churn` were freed
+  size_t kept_bytes = 0;
+  size_t churned_bytes = 0;
+  for (int i = 0; i < vm.profiler->site_count; i++) {
+    ProfileSite *site = &vm.profiler->sites[i];
+    if (strstr(site->stack, "churn") != NULL) {
+      churned_bytes += site->freed_bytes;
+    } else if (strstr(site->stack, "build") != NULL) {
+      kept_bytes += site->live_bytes;
+    }
+  }
+
+  size_t cons_size = mesche_heap_cell_size(&vm.mem.heap, sizeof(ObjectCons));
+  if (kept_bytes < 1000 * cons_size || churned_bytes < 1000 * cons_size) {
+    FAIL("Expected at least %zu live and freed bytes, got %zu and %zu", 1000 * cons_size,
+         kept_bytes, churned_bytes);
+  }
+
+  PASS();
+}
+
+static void writes_heap_snapshots() {
+  VM_INIT();
+
+  VM_EVAL("(define (build n acc) (if (> n 0) (build (- n 1) (cons n acc)) acc))"
+          "(define items (build 1000 '()))"
+          "#t",
+          INTERPRET_OK);
+
+  char file_path[] = "/tmp/mesche-snapshot-XXXXXX";
+  int fd = mkstemp(file_path);
+  if (fd == -1) {
+    FAIL("Could not create a file for the snapshot");
+  }
+  close(fd);
+
+  bool written = mesche_heap_snapshot_write(&vm, file_path);
+  MescheHeapSnapshot *snapshot = mesche_heap_snapshot_read(file_path);
+  unlink(file_path);
+  if (!written || snapshot == NULL) {
+    FAIL("Expected the snapshot to be written and read back");
+  }
+
+  // The head of the list retains the whole list
+  mesche_heap_snapshot_analyze(snapshot);
+  size_t retained_size = 0;
+  for (size_t i = 0; i < snapshot->object_count; i++) {
+    if (snapshot->objects[i].kind == ObjectKindCons &&
+        snapshot->retained_sizes[i] > retained_size) {
+      retained_size = snapshot->retained_sizes[i];
+    }
+  }
+
+  size_t cons_size = mesche_heap_cell_size(&vm.mem.heap, sizeof(ObjectCons));
+  mesche_heap_snapshot_free(snapshot);
+  if (retained_size < 1000 * cons_size) {
+    FAIL("Expected a pair retaining at least %zu bytes, got %zu", 1000 * cons_size,
+         retained_size);
+  }
+
+  PASS();
+}
+
+static void finalizes_collected_objects() {
+  VM_INIT();
+  Value value;
+
+  char file_path[] = "/tmp/mesche-finalizer-XXXXXX";
+  int fd = mkstemp(file_path);
+  if (fd == -1) {
+    FAIL("Could not create a file for the port");
+  }
+  close(fd);
+
+  char source[256];
+  snprintf(source, sizeof(source),
+           "(module-import (mesche io))"
+           "(module-import (mesche gc))"
+           "(define guardian (make-guardian))"
+           "(guardian-register! guardian (list 1 2 3))"
+           "(write-string \"hello\" (open-output-file \"%s\"))"
+           "#t",
+           file_path);
+  VM_EVAL(source, INTERPRET_OK);
+  vm.next_major_gc = 0;
+  mesche_mem_collect_garbage((MescheMemory *)&vm);
+
+  // The dropped port's file is only closed once its finalizer runs
+  struct stat file_stat;
+  stat(file_path, &file_stat);
+  off_t size_before = file_stat.st_size;
+  int run_count = mesche_gc_run_finalizers(&vm, -1);
+  stat(file_path, &file_stat);
+  unlink(file_path);
+  if (size_before != 0 || file_stat.st_size != 5 || run_count < 1) {
+    FAIL("Expected the file to be flushed by a finalizer, got %lld bytes before and %lld after "
+         "%d finalizers",
+         (long long)size_before, (long long)file_stat.st_size, run_count);
+  }
+
+  // The guardian keeps the unreachable list alive until it's taken
+  VM_EVAL("(car (guardian-poll guardian))", INTERPRET_OK);
+  value = *vm.stack_top;
+  ASSERT_KIND(VALUE_KIND(value), VALUE_FIXNUM);
+  ASSERT_INT(1, AS_FIXNUM(value));
+
+  VM_EVAL("(guardian-poll guardian)", INTERPRET_OK);
+  value = *vm.stack_top;
+  ASSERT_KIND(VALUE_KIND(value), VALUE_FALSE);
+
+  PASS();
+}
+
+static void removes_collected_weak_table_keys() {
+  VM_INIT();
+  Value value;
+
+  // The ephemeron whose value refers back to its own key doesn't keep it alive
+  VM_EVAL("(define weak (make-weak-table))"
+          "(define ephemerons (make-ephemeron-table))"
+          "(define kept (list 1))"
+          "(weak-table-set! weak kept 'kept)"
+          "(weak-table-set! weak (list 2) 'dropped)"
+          "(define (add-cycle) (let ((key (list 3))) (weak-table-set! ephemerons key (list key)) #t))"
+          "(add-cycle)"
+          "(weak-table-set! ephemerons kept (list kept))"
+          "#t",
+          INTERPRET_OK);
+  vm.next_major_gc = 0;
+  mesche_mem_collect_garbage((MescheMemory *)&vm);
+
+  VM_EVAL("(+ (weak-table-count weak) (weak-table-count ephemerons))", INTERPRET_OK);
+  value = *vm.stack_top;
+  ASSERT_KIND(VALUE_KIND(value), VALUE_FIXNUM);
+  ASSERT_INT(2, AS_FIXNUM(value));
+
+  VM_EVAL("(car (car (weak-table-ref ephemerons kept)))", INTERPRET_OK);
+  value = *vm.stack_top;
+  ASSERT_KIND(VALUE_KIND(value), VALUE_FIXNUM);
+  ASSERT_INT(1, AS_FIXNUM(value));
+
+  PASS();
+}
+
+static void collects_arena_objects() {
+  VM_INIT();
+  Value value;
+
+  // The list that escapes into a module binding survives the arena and the
+  // rest of what it allocated is freed when it ends
+  VM_EVAL("(module-import (mesche gc))"
+          "(define kept #f)"
+          "(define (churn n items) (if (> n 0) (churn (- n 1) (cons n items)) items))"
+          "#t",
+          INTERPRET_OK);
+  size_t bytes_before = vm.mem.bytes_allocated;
+  VM_EVAL("(with-arena (lambda () (churn 1000 '()) (set! kept (churn 10 '())) (churn 20 '())))",
+          INTERPRET_OK);
+  ASSERT_INT(0, vm.arena_count);
+  // Compiling the expression allocates outside of the arena
+  if (vm.mem.bytes_allocated - bytes_before > 1000 * sizeof(ObjectCons) / 2) {
+    FAIL("Expected the arena's garbage to be freed, heap grew by %zu bytes",
+         vm.mem.bytes_allocated - bytes_before);
+  }
+
+  VM_EVAL("(+ (length kept) (car kept))", INTERPRET_OK);
+  value = *vm.stack_top;
+  ASSERT_KIND(VALUE_KIND(value), VALUE_FIXNUM);
+  ASSERT_INT(11, AS_FIXNUM(value));
+
+  // Nesting arena scopes too deeply raises an error that closes all of them
+  VM_EVAL("(define (nest n) (if (> n 0) (begin (arena-begin) (nest (- n 1)))))"
+          "(nest 300)",
+          INTERPRET_RUNTIME_ERROR);
+  ASSERT_INT(0, vm.arena_count);
+  ASSERT_INT(0, vm.mem.heap.arena_depth);
+
+  VM_EVAL("(length kept)", INTERPRET_OK);
+  value = *vm.stack_top;
+  ASSERT_KIND(VALUE_KIND(value), VALUE_FIXNUM);
+  ASSERT_INT(10, AS_FIXNUM(value));
+
+  PASS();
+}
+
+static void marks_objects_in_parallel() {
+  VM_INIT();
+  Value value;
+
+  // Several markers share and steal the lists even when the heap is small
+  // or there's only one CPU.  Other builds mark the heap on one thread.
+  vm.gc_marker_count = 4;
+  vm.gc_parallel_min_heap = 0;
+  VM_EVAL("(define (build n acc) (if (> n 0) (build (- n 1) (cons n acc)) acc))"
+          "(define (sum items total) (if (null? items) total (sum (cdr items) (+ total (car items)))))"
+          "(define lists (make-array))"
+          "(define (fill n) (if (> n 0) (begin (array-push lists (build 50 '())) (fill (- n 1)))))"
+          "(fill 400)"
+          "#t",
+          INTERPRET_OK);
+  vm.next_major_gc = 0;
+  mesche_mem_collect_garbage((MescheMemory *)&vm);
+  vm.next_major_gc = 0;
+  mesche_mem_collect_garbage((MescheMemory *)&vm);
+
+  VM_EVAL("(define (total n acc) (if (> n 0) (total (- n 1) (+ acc (sum (array-nth lists (- n 1)) 0))) acc))"
+          "(total (array-length lists) 0)",
+          INTERPRET_OK);
+  value = *vm.stack_top;
+  ASSERT_KIND(VALUE_KIND(value), VALUE_FIXNUM);
+  ASSERT_INT(400 * 1275, AS_FIXNUM(value));
+
+  PASS();
+}
+
 static void vm_suite_cleanup() { mesche_vm_free(&vm); }
 
 void test_vm_suite() {
@@ -385,12 +1369,35 @@ void test_vm_suite() {
   test_suite_cleanup_func = vm_suite_cleanup;
 
   returns_basic_values();
+  returns_immediate_values();
   calls_function_with_rest_args();
+  calls_function_with_keyword_args();
+  constructs_records_positionally();
   imports_modules();
 
   evaluates_and_or();
   evaluates_let();
   evaluates_calls();
+  evaluates_global_bindings();
+  sets_undefined_global();
+  evaluates_polymorphic_call_sites();
+  evaluates_quickened_operations();
+  evaluates_superinstructions();
+  evaluates_exact_numbers();
+  evaluates_apply();
+  evaluates_record_field_sites();
+  keeps_values_stored_in_surviving_objects();
+  keeps_values_stored_between_collection_slices();
+  reuses_swept_heap_pages();
+  raises_error_when_heap_limit_exceeded();
+  paces_collections_within_heap_limit();
+  collects_gc_statistics();
+  profiles_allocation_sites();
+  writes_heap_snapshots();
+  finalizes_collected_objects();
+  removes_collected_weak_table_keys();
+  marks_objects_in_parallel();
+  collects_arena_objects();
   evaluates_tail_calls();
   evaluates_tail_calls_named_let();
 
@@ -404,6 +1411,11 @@ void test_vm_suite() {
   evaluates_calling_continuation_with_capture();
   evaluates_calling_continuation_composed();
   evaluates_continuation_channels_sample();
+  evaluates_deep_recursion();
+  evaluates_deep_continuations();
+  grows_stacks_from_minimum_size();
+  reports_stack_overflow();
+  recovers_from_native_errors();
 
   END_SUITE();
 }